@@ -0,0 +1,238 @@
+#include "animation.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+static uint32_t frame_time = 0;
+
+static const tween_t blink_tweens[] = {
+    { ANIM_BLINK_MS, 1, 1, EASE_STEP },
+    { ANIM_BLINK_MS, 0, 0, EASE_STEP },
+};
+
+static const track_t blink_tracks[] = {
+    TRACK(blink_tweens, ANIM_BLINK_COUNT),
+};
+
+const timeline_t ANIM_BLINK = TIMELINE(blink_tracks);
+
+void animation_tick(uint32_t now)
+{
+    frame_time = now;
+}
+
+uint32_t animation_now()
+{
+    return frame_time;
+}
+
+static fixed_t square(fixed_t t)
+{
+    // t < FIXED_ONE so the product fits in 32 bits unsigned
+    return (fixed_t)(((uint32_t)t * (uint32_t)t) >> FIXED_SHIFT);
+}
+
+fixed_t ease(uint8_t easing, fixed_t t)
+{
+    if (t <= 0)
+    {
+        return 0;
+    }
+    if (t >= FIXED_ONE)
+    {
+        return FIXED_ONE;
+    }
+
+    switch (easing)
+    {
+        case EASE_STEP:
+            return 0;
+        case EASE_IN_QUAD:
+            return square(t);
+        case EASE_OUT_QUAD:
+            return FIXED_ONE - square(FIXED_ONE - t);
+        case EASE_IN_OUT_QUAD:
+            if (t < (FIXED_ONE / 2))
+            {
+                return 2 * square(t);
+            }
+            return FIXED_ONE - (2 * square(FIXED_ONE - t));
+        case EASE_OUT_QUART:
+            {
+                fixed_t inv = square(FIXED_ONE - t);
+                return FIXED_ONE - square(inv);
+            }
+        case EASE_LINEAR:
+        default:
+            return t;
+    }
+}
+
+static fixed_t tween_value(const tween_t* tween, uint32_t t_ms)
+{
+    if ((tween->duration_ms == 0) || (t_ms >= tween->duration_ms))
+    {
+        return INT_TO_FIXED(tween->to);
+    }
+
+    fixed_t progress = (fixed_t)((t_ms << FIXED_SHIFT) / tween->duration_ms);
+    fixed_t eased = ease(tween->easing, progress);
+    int32_t delta = (int32_t)tween->to - (int32_t)tween->from;
+    if ((delta >= INT16_MIN) && (delta <= INT16_MAX))
+    {
+        // |delta * eased| < 2^31, the common case stays in 32 bits
+        return INT_TO_FIXED(tween->from) + (delta * eased);
+    }
+
+    // Spans over 32767 overflow a 32 bit product, the sum lies between
+    // from and to so it fits once added, saturated for safety
+    int64_t value = ((int64_t)tween->from << FIXED_SHIFT) + ((int64_t)delta * eased);
+    if (value > INT32_MAX)
+    {
+        return INT32_MAX;
+    }
+    if (value < INT32_MIN)
+    {
+        return INT32_MIN;
+    }
+    return (fixed_t)value;
+}
+
+static uint32_t track_duration(const track_t* track)
+{
+    uint32_t duration = 0;
+    for (uint8_t i = 0; i < track->count; ++i)
+    {
+        duration += track->tweens[i].duration_ms;
+    }
+    return duration;
+}
+
+static bool track_done(const track_t* track, uint32_t elapsed)
+{
+    if (track->repeat == ANIMATION_REPEAT_FOREVER)
+    {
+        return false;
+    }
+    if (elapsed < track->delay_ms)
+    {
+        return false;
+    }
+    return (elapsed - track->delay_ms) >= (track_duration(track) * track->repeat);
+}
+
+static fixed_t track_value(const track_t* track, uint32_t elapsed)
+{
+    if (track->count == 0)
+    {
+        return 0;
+    }
+    if (elapsed < track->delay_ms)
+    {
+        return INT_TO_FIXED(track->tweens[0].from);
+    }
+    elapsed -= track->delay_ms;
+
+    uint32_t duration = track_duration(track);
+    if (duration == 0)
+    {
+        return INT_TO_FIXED(track->tweens[track->count - 1].to);
+    }
+
+    uint32_t cycle = elapsed / duration;
+    if ((track->repeat != ANIMATION_REPEAT_FOREVER) && (cycle >= track->repeat))
+    {
+        return INT_TO_FIXED(track->tweens[track->count - 1].to);
+    }
+
+    uint32_t t = elapsed - (cycle * duration);
+    const tween_t* tween = track->tweens;
+    while (t >= tween->duration_ms)
+    {
+        t -= tween->duration_ms;
+        ++tween;
+    }
+    return tween_value(tween, t);
+}
+
+void animation_start(animation_t* anim, const timeline_t* timeline)
+{
+    anim->timeline = timeline;
+    anim->start = frame_time;
+}
+
+uint32_t animation_elapsed(const animation_t* anim)
+{
+    return frame_time - anim->start;
+}
+
+bool animation_done(const animation_t* anim)
+{
+    if (anim->timeline == NULL)
+    {
+        return true;
+    }
+
+    uint32_t elapsed = animation_elapsed(anim);
+    for (uint8_t i = 0; i < anim->timeline->count; ++i)
+    {
+        if (!track_done(&anim->timeline->tracks[i], elapsed))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+fixed_t animation_value(const animation_t* anim, uint8_t track)
+{
+    if ((anim->timeline == NULL) || (track >= anim->timeline->count))
+    {
+        return 0;
+    }
+    return track_value(&anim->timeline->tracks[track], animation_elapsed(anim));
+}
+
+int16_t animation_int(const animation_t* anim, uint8_t track)
+{
+    return (int16_t)FIXED_TO_INT(animation_value(anim, track));
+}
+
+uint32_t animation_cycle(const animation_t* anim, uint8_t track)
+{
+    if ((anim->timeline == NULL) || (track >= anim->timeline->count))
+    {
+        return 0;
+    }
+
+    const track_t* t = &anim->timeline->tracks[track];
+    uint32_t elapsed = animation_elapsed(anim);
+    uint32_t duration = track_duration(t);
+    if ((elapsed < t->delay_ms) || (duration == 0))
+    {
+        return 0;
+    }
+    return (elapsed - t->delay_ms) / duration;
+}
+
+bool animation_ticked(const animation_t* anim, uint8_t track, uint32_t* cycle)
+{
+    uint32_t current = animation_cycle(anim, track);
+    if (current != *cycle)
+    {
+        *cycle = current;
+        return true;
+    }
+    return false;
+}
+
+bool animation_changed(const animation_t* anim, uint8_t track, int16_t* value)
+{
+    int16_t current = animation_int(anim, track);
+    if (current != *value)
+    {
+        *value = current;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,96 @@
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+#include <stdint.h>
+
+// Fixed-point tween/timeline engine. The M0+ has no FPU, so values are
+// Q16.16 and progress through a tween is Q16 in [0, FIXED_ONE].
+//
+// A tween eases a value between two integers over a duration. A track
+// plays its tweens in sequence, optionally repeating, after a delay. A
+// timeline plays its tracks in parallel. Tweens, tracks and timelines are
+// const data; a running animation is only a timeline pointer and a start
+// time. Time is sampled once per frame with animation_tick().
+
+typedef int32_t fixed_t;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE ((fixed_t)1 << FIXED_SHIFT)
+#define INT_TO_FIXED(i) ((fixed_t)(i) << FIXED_SHIFT)
+#define FIXED_TO_INT(f) ((int32_t)(f) >> FIXED_SHIFT)
+
+#define ANIMATION_REPEAT_FOREVER 0
+
+typedef enum
+{
+    EASE_LINEAR,
+    EASE_STEP,
+    EASE_IN_QUAD,
+    EASE_OUT_QUAD,
+    EASE_IN_OUT_QUAD,
+    EASE_OUT_QUART,
+    EASE_MAX
+} easing_t;
+
+typedef struct
+{
+    uint16_t duration_ms;
+    int16_t from;
+    int16_t to;
+    uint8_t easing;
+} tween_t;
+
+typedef struct
+{
+    const tween_t* tweens;
+    uint8_t count;
+    uint8_t repeat;
+    uint16_t delay_ms;
+} track_t;
+
+typedef struct
+{
+    const track_t* tracks;
+    uint8_t count;
+} timeline_t;
+
+typedef struct
+{
+    const timeline_t* timeline;
+    uint32_t start;
+} animation_t;
+
+#define ANIMATION_COUNT(a) ((uint8_t)(sizeof(a) / sizeof((a)[0])))
+#define TRACK(tweens, repeat) { tweens, ANIMATION_COUNT(tweens), repeat, 0 }
+#define DELAYED_TRACK(tweens, repeat, delay_ms) { tweens, ANIMATION_COUNT(tweens), repeat, delay_ms }
+#define TIMELINE(tracks) { tracks, ANIMATION_COUNT(tracks) }
+
+// Stock effect: visible/hidden blink, single track with values 1 and 0
+#define ANIM_BLINK_MS 250
+#define ANIM_BLINK_COUNT 5
+extern const timeline_t ANIM_BLINK;
+
+// Sample the clock for this frame, called once by the renderer
+void animation_tick(uint32_t now);
+uint32_t animation_now();
+
+fixed_t ease(uint8_t easing, fixed_t t);
+
+void animation_start(animation_t* anim, const timeline_t* timeline);
+uint32_t animation_elapsed(const animation_t* anim);
+bool animation_done(const animation_t* anim);
+
+// Value of a track at the current frame time
+fixed_t animation_value(const animation_t* anim, uint8_t track);
+int16_t animation_int(const animation_t* anim, uint8_t track);
+
+// Number of completed passes through a track
+uint32_t animation_cycle(const animation_t* anim, uint8_t track);
+
+// True when the track started a new pass since *cycle was last updated
+bool animation_ticked(const animation_t* anim, uint8_t track, uint32_t* cycle);
+
+// True when the integer value of the track differs from *value
+bool animation_changed(const animation_t* anim, uint8_t track, int16_t* value);
+
+#endif // ANIMATION_H_
@@ -0,0 +1,385 @@
+#include "bench.h"
+
+#ifdef CIPHERPAL_BENCH
+
+#include "animation.h"
+#include "boot.h"
+#include "cipher.h"
+#include "coroutine.h"
+#include "grayscale.h"
+#include "particles.h"
+#include "renderer.h"
+#include "scroll_console.h"
+#include "sprite.h"
+#include "transition.h"
+#include "utility.h"
+
+#include <stdint.h>
+
+#define BENCH_ITERATIONS 10000
+
+typedef struct
+{
+    coroutine_t co;
+    uint32_t count;
+} bench_coroutine_t;
+
+static bench_coroutine_t bench_co;
+
+bool bench_coroutine_step()
+{
+    coroutine_t* co = &bench_co.co;
+    CO_BEGIN(co);
+    while (true)
+    {
+        ++bench_co.count;
+        CO_AWAIT_FRAME(co);
+    }
+    CO_END(co);
+}
+
+bool bench_empty_step()
+{
+    ++bench_co.count;
+    return true;
+}
+
+// Cost of resuming a coroutine compared to calling a plain function
+void bench_coroutine_resume()
+{
+    bool (* volatile step)() = bench_empty_step;
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i)
+    {
+        step();
+    }
+    uint32_t call_us = micros() - start;
+
+    CO_INIT(&bench_co.co);
+    step = bench_coroutine_step;
+    start = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i)
+    {
+        step();
+    }
+    uint32_t resume_us = micros() - start;
+
+    Log("bench coroutine: %u bytes state, call %lu ns, resume %lu ns",
+        (unsigned)sizeof(coroutine_t),
+        (unsigned long)((call_us * 1000UL) / BENCH_ITERATIONS),
+        (unsigned long)((resume_us * 1000UL) / BENCH_ITERATIONS));
+}
+
+#define BENCH_ANIMATIONS 64
+
+static const tween_t bench_tweens[] = {
+    { 300, 0, 127, EASE_IN_OUT_QUAD },
+    { 200, 127, 64, EASE_OUT_QUART },
+    { 500, 64, 0, EASE_LINEAR },
+};
+
+static const track_t bench_tracks[] = {
+    TRACK(bench_tweens, ANIMATION_REPEAT_FOREVER),
+    DELAYED_TRACK(bench_tweens, 3, 100),
+};
+
+static const timeline_t bench_timeline = TIMELINE(bench_tracks);
+
+// Cost of sampling many concurrent animations once per frame
+void bench_animation_sample()
+{
+    static animation_t anims[BENCH_ANIMATIONS];
+    for (uint8_t i = 0; i < BENCH_ANIMATIONS; ++i)
+    {
+        animation_tick(i * 7);
+        animation_start(&anims[i], &bench_timeline);
+    }
+
+    uint32_t frames = BENCH_ITERATIONS / BENCH_ANIMATIONS;
+    volatile int32_t sink = 0;
+    uint32_t start = micros();
+    for (uint32_t frame = 0; frame < frames; ++frame)
+    {
+        animation_tick(frame * 16);
+        for (uint8_t i = 0; i < BENCH_ANIMATIONS; ++i)
+        {
+            sink += animation_value(&anims[i], i & 1);
+        }
+    }
+    uint32_t elapsed_us = micros() - start;
+
+    Log("bench animation: %u bytes each, %lu ns per sample, %lu us per frame of %u",
+        (unsigned)sizeof(animation_t),
+        (unsigned long)((elapsed_us * 1000UL) / (frames * BENCH_ANIMATIONS)),
+        (unsigned long)(elapsed_us / frames),
+        BENCH_ANIMATIONS);
+}
+
+#define BENCH_SPRITES 256
+
+void bench_sprite_case(const char* name, const image_t* image, uint8_t scale, uint8_t mode)
+{
+    uint8_t* frame = display->frame();
+    uint32_t start = micros();
+    for (uint16_t i = 0; i < BENCH_SPRITES; ++i)
+    {
+        int16_t x = (int16_t)((i * 37) % (LCD_WIDTH + 32)) - 16;
+        int16_t y = (int16_t)((i * 23) % (LCD_HEIGHT + 16)) - 8;
+        sprite_draw(frame, image, x, y, scale, mode);
+    }
+    uint32_t elapsed_us = micros() - start;
+    uint32_t per_sprite_ns = (elapsed_us * 1000UL) / BENCH_SPRITES;
+    uint32_t frame_us = 1000000UL / DEFAULT_TARGET_FPS;
+
+    Log("bench sprite %s x%u: %lu ns each, %lu per frame",
+        name,
+        scale,
+        (unsigned long)per_sprite_ns,
+        (unsigned long)((per_sprite_ns > 0) ? ((frame_us * 1000UL) / per_sprite_ns) : 0));
+}
+
+// Sprite throughput, reported as sprites per frame at the default rate
+void bench_sprites()
+{
+    bench_sprite_case("tiny", &DI_TINY, 1, SPRITE_OR);
+    bench_sprite_case("tiny", &DI_TINY, 2, SPRITE_OR);
+    bench_sprite_case("small", &DI_SMALL, 1, SPRITE_COPY);
+    bench_sprite_case("medium", &DI_MEDIUM, 1, SPRITE_XOR);
+    display->clearDisplay();
+}
+
+#define BENCH_SCROLL_COLUMNS 256
+#define BENCH_FULL_FRAMES 16
+
+// Hardware scrolled console against redrawing and flushing whole frames
+void bench_scroll_console()
+{
+    uint32_t start = micros();
+    for (uint8_t i = 0; i < BENCH_FULL_FRAMES; ++i)
+    {
+        display->mark_all_dirty();
+        display->display();
+    }
+    uint32_t frame_us = (micros() - start) / BENCH_FULL_FRAMES;
+
+    scroll_console_begin();
+    uint32_t bytes = scroll_console_bytes_sent();
+    start = micros();
+    for (uint16_t i = 0; i < BENCH_SCROLL_COLUMNS; ++i)
+    {
+        for (uint8_t lane = 0; lane < SCROLL_CONSOLE_LANES; ++lane)
+        {
+            if (scroll_console_pending(lane) < 2)
+            {
+                scroll_console_print(lane, "CIPHERPAL ");
+            }
+        }
+        scroll_console_advance(1);
+    }
+    uint32_t scroll_us = micros() - start;
+    bytes = scroll_console_bytes_sent() - bytes;
+    scroll_console_end();
+    display->display();
+
+    uint32_t column_us = scroll_us / BENCH_SCROLL_COLUMNS;
+    Log("bench scroll: full frame %lu us, column %lu us, %lu bytes/column",
+        (unsigned long)frame_us,
+        (unsigned long)column_us,
+        (unsigned long)(bytes / BENCH_SCROLL_COLUMNS));
+    Log("bench scroll: %lu columns/s, %lu chars/s over %u lanes",
+        (unsigned long)((column_us > 0) ? (1000000UL / column_us) : 0),
+        (unsigned long)((column_us > 0) ? (1000000UL / (column_us * SCROLL_CONSOLE_CHAR_WIDTH)) * SCROLL_CONSOLE_LANES : 0),
+        SCROLL_CONSOLE_LANES);
+}
+
+#define BENCH_PARTICLE_FRAMES 32
+
+// Particle step and plot with every frame byte broken up
+void bench_particles()
+{
+    uint8_t* frame = display->frame();
+    for (uint16_t i = 0; i < FRAME_BYTES; ++i)
+    {
+        frame[i] = (uint8_t)(0x81 | (i * 37));
+    }
+    uint16_t count = particles_capture(frame);
+    particles_scatter(LCD_WIDTH / 2, LCD_HEIGHT / 2);
+
+    uint32_t start = micros();
+    for (uint8_t i = 0; i < BENCH_PARTICLE_FRAMES; ++i)
+    {
+        particles_step_free();
+        particles_draw(frame);
+    }
+    uint32_t free_us = micros() - start;
+
+    start = micros();
+    for (uint8_t i = 0; i < BENCH_PARTICLE_FRAMES; ++i)
+    {
+        particles_step_home();
+        particles_draw(frame);
+    }
+    uint32_t home_us = micros() - start;
+    display->clearDisplay();
+
+    uint32_t per_particle_ns = ((free_us + home_us) * 1000UL) / (2UL * BENCH_PARTICLE_FRAMES * count);
+    uint32_t frame_us = 1000000UL / DEFAULT_TARGET_FPS;
+    Log("bench particles: %u fragments, free %lu us, home %lu us per frame",
+        count,
+        (unsigned long)(free_us / BENCH_PARTICLE_FRAMES),
+        (unsigned long)(home_us / BENCH_PARTICLE_FRAMES));
+    Log("bench particles: %lu ns each, %lu per frame",
+        (unsigned long)per_particle_ns,
+        (unsigned long)((per_particle_ns > 0) ? ((frame_us * 1000UL) / per_particle_ns) : 0));
+}
+
+#define BENCH_TRANSITION_STEPS 32
+
+// Composition cost per transition frame, excluding the flush
+void bench_transitions()
+{
+    static uint8_t from[FRAME_BYTES] __attribute__((aligned(4)));
+    static uint8_t out[FRAME_BYTES] __attribute__((aligned(4)));
+    static const char* names[TRANSITION_MAX] = { "none", "wipe", "slide", "dissolve", "xor" };
+    const uint8_t* to = display->frame();
+    for (uint16_t i = 0; i < FRAME_BYTES; ++i)
+    {
+        from[i] = (uint8_t)(i * 13);
+    }
+
+    for (uint8_t type = TRANSITION_WIPE; type < TRANSITION_MAX; ++type)
+    {
+        uint32_t pages = 0;
+        uint32_t start = micros();
+        for (uint8_t i = 0; i < BENCH_TRANSITION_STEPS; ++i)
+        {
+            uint16_t changed = transition_compose(type, false, from, to, (i * TRANSITION_SPAN) / BENCH_TRANSITION_STEPS, out);
+            pages += __builtin_popcount(changed);
+        }
+        uint32_t elapsed_us = micros() - start;
+        Log("bench transition %s: %lu us per frame, %lu pages flushed per frame",
+            names[type],
+            (unsigned long)(elapsed_us / BENCH_TRANSITION_STEPS),
+            (unsigned long)(pages / BENCH_TRANSITION_STEPS));
+    }
+}
+
+#define BENCH_GRAYSCALE_HZ 1000
+#define BENCH_GRAYSCALE_US 2000000UL
+
+// Highest plane rate the bus sustains with a quarter and all of the
+// screen gray, which bounds how much shading grayscale mode can hold
+void bench_grayscale_case(int16_t gray_width)
+{
+    grayscale_begin(BENCH_GRAYSCALE_HZ);
+    grayscale_fill_rect(0, 0, gray_width, LCD_HEIGHT, 1);
+    uint32_t start = micros();
+    uint32_t now = start;
+    while ((now - start) < BENCH_GRAYSCALE_US)
+    {
+        grayscale_service(now);
+        now = micros();
+    }
+    const grayscale_stats_t* stats = grayscale_stats();
+    Log("bench grayscale %u columns: %u planes/s, %lu us flush, %lu bytes/s",
+        gray_width,
+        stats->plane_rate,
+        (unsigned long)stats->flush_us,
+        (unsigned long)(stats->bytes_sent / (BENCH_GRAYSCALE_US / 1000000UL)));
+    grayscale_end();
+}
+
+void bench_grayscale()
+{
+    bench_grayscale_case(LCD_WIDTH / 4);
+    bench_grayscale_case(LCD_WIDTH);
+    display->clearDisplay();
+    display->display();
+}
+
+// Runs after the first frame, so the boot phases up to it are in
+void bench_boot()
+{
+    uint32_t first_frame_us = boot_time_us(BOOT_FIRST_FRAME);
+    Log("bench boot: reset to first frame %lu us, target %lu us, %s",
+        (unsigned long)first_frame_us,
+        (unsigned long)BOOT_FIRST_FRAME_TARGET_US,
+        (first_frame_us <= BOOT_FIRST_FRAME_TARGET_US) ? "met" : "MISSED");
+}
+
+// Whole frame flush at each clock, with and without page batching
+void bench_flush()
+{
+    static const uint32_t clocks[] = { I2C_STANDARD_HZ, I2C_FAST_HZ, I2C_FAST_PLUS_HZ };
+    for (uint8_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); ++i)
+    {
+        uint32_t clock = display->set_bus_speed(clocks[i]);
+        for (uint8_t batch = 0; batch < 2; ++batch)
+        {
+            display->set_page_batching(batch != 0);
+            display->reset_flush_timing();
+            for (uint8_t n = 0; n < 16; ++n)
+            {
+                display->mark_all_dirty();
+                display->display();
+            }
+            const flush_timing_t& timing = display->flush_timing();
+            Log("bench flush %lu Hz %s: %lu us per frame, %lu us per page, max page %lu us",
+                (unsigned long)clock,
+                batch ? "batched" : "unbatched",
+                (unsigned long)(timing.total_us / timing.frames),
+                (unsigned long)(timing.total_us / timing.pages),
+                (unsigned long)timing.page_us_max);
+        }
+    }
+    display->set_bus_speed(DEFAULT_BUS_HZ);
+    display->reset_flush_timing();
+}
+
+#define BENCH_CIPHER_BYTES 1024
+#define BENCH_CIPHER_PASSES 16
+
+// Same workload as tools/cipher_bench.cpp on the host
+void bench_cipher()
+{
+    static const uint8_t key[] = "CIPHERPAL";
+    static uint8_t buffer[BENCH_CIPHER_BYTES] __attribute__((aligned(4)));
+    static cipher_t cipher;
+    for (uint8_t mode = 0; mode < CIPHER_MODES; ++mode)
+    {
+        cipher_init(&cipher, mode, false, key, sizeof(key) - 1);
+        for (uint16_t i = 0; i < BENCH_CIPHER_BYTES; ++i)
+        {
+            buffer[i] = 'A' + (i % 26);
+        }
+
+        uint32_t start = micros();
+        for (uint8_t pass = 0; pass < BENCH_CIPHER_PASSES; ++pass)
+        {
+            cipher_apply(&cipher, buffer, BENCH_CIPHER_BYTES);
+        }
+        uint32_t elapsed_us = micros() - start;
+        uint32_t bytes = (uint32_t)BENCH_CIPHER_BYTES * BENCH_CIPHER_PASSES;
+        Log("bench cipher %s: %lu bytes/s",
+            cipher_name(mode),
+            (unsigned long)(((uint64_t)bytes * 1000000UL) / elapsed_us));
+    }
+}
+
+void bench_run()
+{
+    Log("bench start");
+    bench_boot();
+    bench_flush();
+    bench_cipher();
+    bench_coroutine_resume();
+    bench_animation_sample();
+    bench_sprites();
+    bench_scroll_console();
+    bench_particles();
+    bench_transitions();
+    bench_grayscale();
+    Log("bench done");
+}
+
+#endif // CIPHERPAL_BENCH
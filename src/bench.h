@@ -0,0 +1,10 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+// On-target benchmarks, built only in the bench environment
+// (pio run -e adafruit_feather_m0_bench). Results are reported with Log().
+#ifdef CIPHERPAL_BENCH
+void bench_run();
+#endif
+
+#endif // BENCH_H_
@@ -0,0 +1,101 @@
+#include "boot.h"
+
+#include "renderer.h"
+#include "utility.h"
+
+#include <Arduino.h>
+#include <stdint.h>
+
+static const char* const phase_names[BOOT_PHASES] = {
+    "setup",
+    "display",
+    "first frame",
+    "deferred",
+};
+
+typedef struct
+{
+    uint32_t at_us[BOOT_PHASES];
+    uint8_t reached;
+    boot_task_t tasks[BOOT_MAX_TASKS];
+    uint8_t head;
+    uint8_t count;
+    uint32_t last_frame;
+} boot_t;
+
+static boot_t boot;
+
+void boot_mark(boot_phase_t phase)
+{
+    uint8_t bit = 1 << phase;
+    if (boot.reached & bit)
+    {
+        return;
+    }
+    boot.at_us[phase] = micros();
+    boot.reached |= bit;
+}
+
+uint32_t boot_time_us(boot_phase_t phase)
+{
+    return boot.at_us[phase];
+}
+
+void boot_defer(boot_task_t task)
+{
+    if (boot.head + boot.count < BOOT_MAX_TASKS)
+    {
+        boot.tasks[boot.head + boot.count] = task;
+        ++boot.count;
+    }
+}
+
+static void run_next()
+{
+    boot_task_t task = boot.tasks[boot.head];
+    ++boot.head;
+    --boot.count;
+    task();
+    if (boot.count == 0)
+    {
+        boot_mark(BOOT_DEFERRED);
+        boot_report();
+    }
+}
+
+void boot_service()
+{
+    uint32_t frame = render_frame_count();
+    bool idle = (frame == boot.last_frame);
+    boot.last_frame = frame;
+    if (idle && (boot.count > 0))
+    {
+        run_next();
+    }
+}
+
+void boot_finish()
+{
+    while (boot.count > 0)
+    {
+        run_next();
+    }
+}
+
+void boot_report()
+{
+    uint32_t previous = 0;
+    for (uint8_t i = 0; i < BOOT_PHASES; ++i)
+    {
+        if ((boot.reached & (1 << i)) == 0)
+        {
+            Log("boot %s: not reached", phase_names[i]);
+            continue;
+        }
+        Log("boot %s: %lu us (+%lu us)",
+            phase_names[i],
+            (unsigned long)boot.at_us[i],
+            (unsigned long)(boot.at_us[i] - previous));
+        previous = boot.at_us[i];
+    }
+}
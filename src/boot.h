@@ -0,0 +1,45 @@
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#include <stdint.h>
+
+// Boot phase timestamps and deferred initialization. setup() does only
+// what the first frame needs, everything else is queued with boot_defer()
+// and run by boot_service() one task at a time, in loop iterations where
+// render() had nothing to do. The timestamps are reported with Log() once
+// the queue is empty.
+//
+// Times are micros() since the core started SysTick in init(), the
+// bootloader and clock start up before that are not included.
+
+#define BOOT_MAX_TASKS 8
+// Target for reset to the first frame on the panel, tracked by the bench
+#define BOOT_FIRST_FRAME_TARGET_US 150000UL
+
+typedef enum
+{
+    BOOT_SETUP = 0,
+    // Controller initialized and the panel on
+    BOOT_DISPLAY,
+    // First frame sent to the panel
+    BOOT_FIRST_FRAME,
+    // Deferred initialization done
+    BOOT_DEFERRED,
+    BOOT_PHASES
+} boot_phase_t;
+
+typedef void(*boot_task_t)();
+
+// Record the phase, only the first mark of each phase counts
+void boot_mark(boot_phase_t phase);
+// 0 until the phase is reached
+uint32_t boot_time_us(boot_phase_t phase);
+
+void boot_defer(boot_task_t task);
+// Run the next deferred task if render() did not render this iteration
+void boot_service();
+// Run all remaining deferred tasks now
+void boot_finish();
+void boot_report();
+
+#endif // BOOT_H_
@@ -6,13 +6,31 @@
 #include <stdint.h>
 
 static uint32_t last_change = 0;
-static volatile uint8_t button_state = 0;
+// All buttons start released, matching the pull-ups
+static volatile uint8_t button_state = BUTTON_ALL_MASK;
+static button_source_t button_source = NULL;
+static uint8_t suppressed = 0;
 
 uint8_t get_buttons()
 {
+    if (button_source != NULL)
+    {
+        return button_source();
+    }
     return button_state;
 }
 
+void set_button_source(button_source_t source)
+{
+    button_source = source;
+}
+
+void suppress_buttons()
+{
+    suppressed = BUTTON_ALL_MASK;
+    last_change = millis();
+}
+
 void scan_buttons()
 {
     uint8_t scan_state = 0;
@@ -43,6 +61,9 @@ void scan_buttons()
         scan_state &= ~BUTTON_DOWN_STATE_MASK;
     }
 
+    suppressed &= ~scan_state;
+    scan_state |= suppressed;
+
     if (((millis() - last_change) > DEBOUNCE_MS)
         && (scan_state != button_state))
     {
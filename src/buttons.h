@@ -12,11 +12,21 @@
 #define BUTTON_UP_STATE_MASK 0x01
 #define BUTTON_SEL_STATE_MASK 0x02
 #define BUTTON_DOWN_STATE_MASK 0x04
+#define BUTTON_ALL_MASK (BUTTON_UP_STATE_MASK | BUTTON_SEL_STATE_MASK | BUTTON_DOWN_STATE_MASK)
 
 #define BUTTON_RELEASED 1
 #define BUTTON_PRESSED 0
 
+typedef uint8_t(*button_source_t)();
+
 void scan_buttons();
 uint8_t get_buttons();
 
+// Replace the debounced pins, e.g. with scripted input, NULL restores them
+void set_button_source(button_source_t source);
+
+// Report buttons pressed right now as released until they are let go,
+// e.g. so the press that wakes the device does not also select
+void suppress_buttons();
+
 #endif // DEBOUNCE_H_
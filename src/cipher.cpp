@@ -0,0 +1,410 @@
+#include "cipher.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define LETTERS 26
+#define CASE_BIT 0x20
+#define CHACHA_ROUNDS 20
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define QUARTER_ROUND(a, b, c, d) \
+    a += b; d ^= a; d = ROTL32(d, 16); \
+    c += d; b ^= c; b = ROTL32(b, 12); \
+    a += b; d ^= a; d = ROTL32(d, 8); \
+    c += d; b ^= c; b = ROTL32(b, 7);
+
+static const char* const mode_names[CIPHER_MODES] = {
+    "SUBST",
+    "VIGENERE",
+    "XOR",
+    "CHACHA20",
+};
+
+// "expand 32-byte k"
+static const uint32_t chacha_constants[4] = {
+    0x61707865, 0x3320646E, 0x79622D32, 0x6B206574
+};
+
+// Shifted letters without a modulo, index + shift < 2 * LETTERS
+static const uint8_t letter_wrap[LETTERS * 2] = {
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
+    'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
+    'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+};
+
+// 0..25 for letters of either case, LETTERS otherwise
+static uint8_t letter_index(uint8_t c)
+{
+    uint8_t upper = c & ~CASE_BIT;
+    if ((upper >= 'A') && (upper <= 'Z') && ((c & 0x80) == 0))
+    {
+        return upper - 'A';
+    }
+    return LETTERS;
+}
+
+static char to_upper(char c)
+{
+    return (letter_index(c) < LETTERS) ? (char)(c & ~CASE_BIT) : c;
+}
+
+static bool init_substitution(cipher_t* cipher, const uint8_t* key, uint8_t key_length)
+{
+    uint8_t alphabet[LETTERS];
+    bool used[LETTERS];
+    uint8_t count = 0;
+    memset(used, 0, sizeof(used));
+
+    for (uint8_t i = 0; i < key_length; ++i)
+    {
+        uint8_t letter = letter_index(key[i]);
+        if ((letter < LETTERS) && !used[letter])
+        {
+            used[letter] = true;
+            alphabet[count++] = letter;
+        }
+    }
+    if (count == 0)
+    {
+        return false;
+    }
+    for (uint8_t letter = 0; letter < LETTERS; ++letter)
+    {
+        if (!used[letter])
+        {
+            alphabet[count++] = letter;
+        }
+    }
+
+    uint8_t* table = cipher->u.table;
+    for (uint16_t c = 0; c < 256; ++c)
+    {
+        table[c] = (uint8_t)c;
+    }
+    for (uint8_t letter = 0; letter < LETTERS; ++letter)
+    {
+        uint8_t plain = 'A' + letter;
+        uint8_t coded = 'A' + alphabet[letter];
+        uint8_t from = cipher->decrypt ? coded : plain;
+        uint8_t to = cipher->decrypt ? plain : coded;
+        table[from] = to;
+        table[from | CASE_BIT] = to | CASE_BIT;
+    }
+    return true;
+}
+
+static bool init_vigenere(cipher_t* cipher, const uint8_t* key, uint8_t key_length)
+{
+    uint8_t length = 0;
+    for (uint8_t i = 0; i < key_length; ++i)
+    {
+        uint8_t letter = letter_index(key[i]);
+        if (letter < LETTERS)
+        {
+            cipher->u.vigenere.shift[length++] =
+                (cipher->decrypt && (letter != 0)) ? (LETTERS - letter) : letter;
+        }
+    }
+    cipher->u.vigenere.length = length;
+    cipher->u.vigenere.index = 0;
+    return length > 0;
+}
+
+static void init_xor(cipher_t* cipher, const uint8_t* key, uint8_t key_length)
+{
+    // Shortest repeat of the key that is a whole number of words
+    uint8_t length = key_length;
+    while (length & 3)
+    {
+        length += key_length;
+    }
+
+    uint8_t* ring = (uint8_t*)cipher->u.xor_stream.ring;
+    for (uint8_t i = 0; i < length; ++i)
+    {
+        ring[i] = key[i % key_length];
+    }
+    cipher->u.xor_stream.length = length;
+    cipher->u.xor_stream.rotation = 0;
+}
+
+static void init_chacha(cipher_t* cipher, const uint8_t* key, uint8_t key_length)
+{
+    uint32_t* input = cipher->u.chacha.input;
+    uint8_t padded[32];
+    memset(padded, 0, sizeof(padded));
+    memcpy(padded, key, key_length);
+
+    memcpy(input, chacha_constants, sizeof(chacha_constants));
+    for (uint8_t i = 0; i < 8; ++i)
+    {
+        const uint8_t* k = &padded[i * 4];
+        input[4 + i] = (uint32_t)k[0]
+                     | ((uint32_t)k[1] << 8)
+                     | ((uint32_t)k[2] << 16)
+                     | ((uint32_t)k[3] << 24);
+    }
+    cipher_set_nonce(cipher, NULL, 0);
+}
+
+bool cipher_init(cipher_t* cipher, uint8_t mode, bool decrypt, const uint8_t* key, uint8_t key_length)
+{
+    if ((mode >= CIPHER_MODES) || (key_length == 0) || (key_length > CIPHER_KEY_MAX))
+    {
+        return false;
+    }
+
+    cipher->mode = mode;
+    cipher->decrypt = decrypt;
+    cipher->position = 0;
+    switch (mode)
+    {
+        case CIPHER_SUBSTITUTION:
+            return init_substitution(cipher, key, key_length);
+        case CIPHER_VIGENERE:
+            return init_vigenere(cipher, key, key_length);
+        case CIPHER_XOR:
+            init_xor(cipher, key, key_length);
+            return true;
+        case CIPHER_CHACHA20:
+            init_chacha(cipher, key, key_length);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void cipher_set_nonce(cipher_t* cipher, const uint8_t* nonce, uint32_t counter)
+{
+    if (cipher->mode != CIPHER_CHACHA20)
+    {
+        return;
+    }
+
+    uint32_t* input = cipher->u.chacha.input;
+    input[12] = counter;
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        const uint8_t* n = (nonce != NULL) ? &nonce[i * 4] : NULL;
+        input[13 + i] = (n == NULL) ? 0 :
+            ((uint32_t)n[0] | ((uint32_t)n[1] << 8) | ((uint32_t)n[2] << 16) | ((uint32_t)n[3] << 24));
+    }
+    cipher->u.chacha.used = CHACHA_BLOCK_BYTES;
+}
+
+static void apply_table(const uint8_t* table, uint8_t* data, uint16_t length)
+{
+    uint8_t* end = data + length;
+    while ((end - data) >= 4)
+    {
+        data[0] = table[data[0]];
+        data[1] = table[data[1]];
+        data[2] = table[data[2]];
+        data[3] = table[data[3]];
+        data += 4;
+    }
+    while (data < end)
+    {
+        *data = table[*data];
+        ++data;
+    }
+}
+
+static void apply_vigenere(cipher_t* cipher, uint8_t* data, uint16_t length)
+{
+    const uint8_t* shift = cipher->u.vigenere.shift;
+    uint8_t key_length = cipher->u.vigenere.length;
+    uint8_t index = cipher->u.vigenere.index;
+    for (uint16_t i = 0; i < length; ++i)
+    {
+        uint8_t c = data[i];
+        uint8_t letter = letter_index(c);
+        if (letter < LETTERS)
+        {
+            data[i] = letter_wrap[letter + shift[index]] | (c & CASE_BIT);
+            if (++index == key_length)
+            {
+                index = 0;
+            }
+        }
+    }
+    cipher->u.vigenere.index = index;
+}
+
+// Rotate the stored ring left by count bytes
+static void rotate_ring(uint8_t* ring, uint8_t length, uint8_t count)
+{
+    uint8_t head[4];
+    memcpy(head, ring, count);
+    memmove(ring, ring + count, length - count);
+    memcpy(ring + length - count, head, count);
+}
+
+static void apply_xor(cipher_t* cipher, uint8_t* data, uint16_t length)
+{
+    uint8_t* ring = (uint8_t*)cipher->u.xor_stream.ring;
+    uint8_t ring_length = cipher->u.xor_stream.length;
+    uint8_t rotation = cipher->u.xor_stream.rotation;
+    // Byte of the stored ring that lines up with this stream position
+    uint8_t j = (uint8_t)(((cipher->position % ring_length) + ring_length - rotation) % ring_length);
+
+    while ((length > 0) && ((uintptr_t)data & 3))
+    {
+        *data++ ^= ring[j];
+        if (++j == ring_length)
+        {
+            j = 0;
+        }
+        --length;
+    }
+
+    if (length >= 4)
+    {
+        uint8_t misalignment = j & 3;
+        if (misalignment != 0)
+        {
+            rotate_ring(ring, ring_length, misalignment);
+            cipher->u.xor_stream.rotation = (rotation + misalignment) % ring_length;
+            j -= misalignment;
+        }
+
+        const uint32_t* words = cipher->u.xor_stream.ring;
+        uint8_t ring_words = ring_length / 4;
+        uint8_t w = j / 4;
+        uint32_t* out = (uint32_t*)data;
+        uint16_t count = length / 4;
+        for (uint16_t i = 0; i < count; ++i)
+        {
+            out[i] ^= words[w];
+            if (++w == ring_words)
+            {
+                w = 0;
+            }
+        }
+        j = w * 4;
+        data += count * 4;
+        length &= 3;
+    }
+
+    while (length > 0)
+    {
+        *data++ ^= ring[j];
+        if (++j == ring_length)
+        {
+            j = 0;
+        }
+        --length;
+    }
+}
+
+static void chacha_block(const uint32_t* input, uint32_t* out)
+{
+    uint32_t x[CHACHA_BLOCK_WORDS];
+    memcpy(x, input, sizeof(x));
+    for (uint8_t i = 0; i < CHACHA_ROUNDS; i += 2)
+    {
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+    for (uint8_t i = 0; i < CHACHA_BLOCK_WORDS; ++i)
+    {
+        out[i] = x[i] + input[i];
+    }
+}
+
+// The key stream is the block words in little endian order, which is
+// their memory order on the M0+ and on the host
+static void apply_chacha(cipher_t* cipher, uint8_t* data, uint16_t length)
+{
+    uint32_t* block = cipher->u.chacha.block;
+    uint8_t used = cipher->u.chacha.used;
+    while (length > 0)
+    {
+        if (used == CHACHA_BLOCK_BYTES)
+        {
+            chacha_block(cipher->u.chacha.input, block);
+            ++cipher->u.chacha.input[12];
+            used = 0;
+        }
+
+        if ((((uintptr_t)data | used) & 3) == 0 && (length >= 4))
+        {
+            uint16_t count = CHACHA_BLOCK_BYTES - used;
+            if (count > length)
+            {
+                count = length;
+            }
+            count /= 4;
+            uint32_t* out = (uint32_t*)data;
+            const uint32_t* key = &block[used / 4];
+            for (uint16_t i = 0; i < count; ++i)
+            {
+                out[i] ^= key[i];
+            }
+            data += count * 4;
+            used += count * 4;
+            length -= count * 4;
+        }
+        else
+        {
+            *data++ ^= ((const uint8_t*)block)[used++];
+            --length;
+        }
+    }
+    cipher->u.chacha.used = used;
+}
+
+void cipher_apply(cipher_t* cipher, uint8_t* data, uint16_t length)
+{
+    switch (cipher->mode)
+    {
+        case CIPHER_SUBSTITUTION:
+            apply_table(cipher->u.table, data, length);
+            break;
+        case CIPHER_VIGENERE:
+            apply_vigenere(cipher, data, length);
+            break;
+        case CIPHER_XOR:
+            apply_xor(cipher, data, length);
+            break;
+        case CIPHER_CHACHA20:
+            apply_chacha(cipher, data, length);
+            break;
+        default:
+            break;
+    }
+    cipher->position += length;
+}
+
+const char* cipher_name(uint8_t mode)
+{
+    return (mode < CIPHER_MODES) ? mode_names[mode] : "?";
+}
+
+uint8_t cipher_mode(const char* name)
+{
+    for (uint8_t mode = 0; mode < CIPHER_MODES; ++mode)
+    {
+        const char* expected = mode_names[mode];
+        const char* given = name;
+        while ((*given != '\0') && (to_upper(*given) == *expected))
+        {
+            ++given;
+            ++expected;
+        }
+        // Whole name or just its first letter
+        if ((*given == '\0') && ((*expected == '\0') || (given == name + 1)))
+        {
+            return mode;
+        }
+    }
+    return CIPHER_MODES;
+}
@@ -0,0 +1,81 @@
+#ifndef CIPHER_H_
+#define CIPHER_H_
+
+#include <stdint.h>
+
+// Streaming ciphers that transform buffers in place. A cipher_t carries
+// its position, so a stream can be fed in chunks of any size and the
+// result is the same as transforming it in one go.
+//
+// SUBSTITUTION  keyed alphabet (the key's letters first, then the rest)
+// VIGENERE      letter shifts from the key
+//               Both work on letters only and keep case, other bytes
+//               pass through and do not use up key.
+// XOR           repeating key XOR over all bytes
+// CHACHA20      RFC 8439 ChaCha20, the key is zero padded to 32 bytes,
+//               nonce and initial counter default to 0
+//
+// The classical modes run from 256 byte tables built by cipher_init(),
+// XOR and ChaCha20 work a word at a time once the data is aligned. No
+// Arduino dependencies, so the same code is benchmarked on the host
+// (tools/cipher_bench.cpp).
+
+#define CIPHER_KEY_MAX 32
+#define CIPHER_NONCE_BYTES 12
+#define CHACHA_BLOCK_WORDS 16
+#define CHACHA_BLOCK_BYTES (CHACHA_BLOCK_WORDS * 4)
+// The key repeated to a multiple of 4 bytes
+#define CIPHER_XOR_RING_BYTES (CIPHER_KEY_MAX * 4)
+
+typedef enum
+{
+    CIPHER_SUBSTITUTION = 0,
+    CIPHER_VIGENERE,
+    CIPHER_XOR,
+    CIPHER_CHACHA20,
+    CIPHER_MODES
+} cipher_mode_t;
+
+typedef struct
+{
+    uint8_t mode;
+    bool decrypt;
+    uint32_t position;
+    union
+    {
+        uint8_t table[256];
+        struct
+        {
+            uint8_t shift[CIPHER_KEY_MAX];
+            uint8_t length;
+            uint8_t index;
+        } vigenere;
+        struct
+        {
+            uint32_t ring[CIPHER_XOR_RING_BYTES / 4];
+            uint8_t length;
+            // The ring is stored rotated so that stream positions with
+            // this remainder mod 4 line up with its words
+            uint8_t rotation;
+        } xor_stream;
+        struct
+        {
+            uint32_t input[CHACHA_BLOCK_WORDS];
+            uint32_t block[CHACHA_BLOCK_WORDS];
+            uint8_t used;
+        } chacha;
+    } u;
+} cipher_t;
+
+// False for an unknown mode or a key that is empty or too long. The
+// classical modes also need at least one letter in the key.
+bool cipher_init(cipher_t* cipher, uint8_t mode, bool decrypt, const uint8_t* key, uint8_t key_length);
+void cipher_set_nonce(cipher_t* cipher, const uint8_t* nonce, uint32_t counter);
+// Transform the next length bytes of the stream in place
+void cipher_apply(cipher_t* cipher, uint8_t* data, uint16_t length);
+
+const char* cipher_name(uint8_t mode);
+// Mode from its name or first letter, CIPHER_MODES when unknown
+uint8_t cipher_mode(const char* name);
+
+#endif // CIPHER_H_
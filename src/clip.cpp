@@ -0,0 +1,98 @@
+#include "clip.h"
+
+#include "display.h"
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TOKEN_SKIP 0x80
+#define TOKEN_COUNT_MASK 0x7F
+
+static inline uint16_t read_u16(const uint8_t* p)
+{
+    return pgm_read_byte(p) | (pgm_read_byte(p + 1) << 8);
+}
+
+bool clip_open(clip_reader_t* reader, const uint8_t* data)
+{
+    if ((pgm_read_byte(&data[0]) != 'C')
+        || (pgm_read_byte(&data[1]) != 'L')
+        || (pgm_read_byte(&data[2]) != 'P')
+        || (pgm_read_byte(&data[3]) != CLIP_VERSION))
+    {
+        return false;
+    }
+    reader->clip = data;
+    reader->frames = read_u16(&data[4]);
+    clip_rewind(reader);
+    return reader->frames > 0;
+}
+
+void clip_rewind(clip_reader_t* reader)
+{
+    reader->next = reader->clip + CLIP_HEADER_BYTES;
+    reader->frame = 0;
+}
+
+bool clip_done(const clip_reader_t* reader)
+{
+    return reader->frame >= reader->frames;
+}
+
+// XOR one page's tokens into byte column page, returns the data after it
+static const uint8_t* apply_page(const uint8_t* data, uint8_t* frame, uint8_t page)
+{
+    uint8_t* out = &frame[page];
+    uint8_t y = 0;
+    while (y < PAGE_BYTES)
+    {
+        uint8_t token = pgm_read_byte(data++);
+        uint8_t count = (token & TOKEN_COUNT_MASK) + 1;
+        if (token & TOKEN_SKIP)
+        {
+            y += count;
+            out += count * BYTES_PER_LINE;
+            continue;
+        }
+        y += count;
+        while (count-- > 0)
+        {
+            *out ^= pgm_read_byte(data++);
+            out += BYTES_PER_LINE;
+        }
+    }
+    return data;
+}
+
+uint16_t clip_next(clip_reader_t* reader, uint8_t* frame, uint16_t* dirty)
+{
+    if (clip_done(reader))
+    {
+        return 0;
+    }
+
+    const uint8_t* data = reader->next;
+    uint16_t duration = read_u16(&data[0]);
+    uint16_t pages = read_u16(&data[2]);
+    uint8_t flags = pgm_read_byte(&data[4]);
+    data += CLIP_FRAME_HEADER_BYTES;
+
+    if (flags & CLIP_KEYFRAME)
+    {
+        memset(frame, 0, FRAME_BYTES);
+        *dirty = (1u << DISPLAY_PAGES) - 1;
+    }
+    for (uint8_t page = 0; page < DISPLAY_PAGES; ++page)
+    {
+        if (pages & (1u << page))
+        {
+            data = apply_page(data, frame, page);
+        }
+    }
+    *dirty |= pages;
+
+    reader->next = data;
+    ++reader->frame;
+    return duration;
+}
@@ -0,0 +1,44 @@
+#ifndef CLIP_H_
+#define CLIP_H_
+
+#include <stdint.h>
+
+// Flash resident animation clips, made with tools/clip_encode.py. A clip
+// is a header and a run of frames, each a set of page deltas against the
+// frame before it (little endian throughout):
+//
+//   'C' 'L' 'P' version  frame count (u16)  reserved (u16)
+//   per frame: duration ms (u16)  page mask (u16)  flags (u8)  pages
+//
+// Page p of the frame is byte column p, 64 bytes top to bottom. Only the
+// pages in the mask follow, in page order, each as the mirror's tokens
+// covering exactly 64 bytes: 0x80 | (n - 1) skips n bytes, n - 1 < 0x80
+// is followed by n bytes to XOR in. A CLIP_KEYFRAME frame is a delta
+// against a blank frame; the first frame always is one, so a clip can be
+// restarted from the top.
+//
+// Decoding writes straight into a frame buffer and keeps only a read
+// position, so the RAM used does not depend on the clip.
+
+#define CLIP_VERSION 1
+#define CLIP_HEADER_BYTES 8
+#define CLIP_FRAME_HEADER_BYTES 5
+#define CLIP_KEYFRAME 0x01
+
+typedef struct
+{
+    const uint8_t* clip;
+    const uint8_t* next;
+    uint16_t frame;
+    uint16_t frames;
+} clip_reader_t;
+
+// False when data is not a clip of this version or has no frames
+bool clip_open(clip_reader_t* reader, const uint8_t* data);
+void clip_rewind(clip_reader_t* reader);
+bool clip_done(const clip_reader_t* reader);
+// Apply the next frame to frame, its pages are ORed into dirty (bit p is
+// page p) and its duration returned, 0 once the clip has ended
+uint16_t clip_next(clip_reader_t* reader, uint8_t* frame, uint16_t* dirty);
+
+#endif // CLIP_H_
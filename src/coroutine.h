@@ -0,0 +1,70 @@
+#ifndef COROUTINE_H_
+#define COROUTINE_H_
+
+#include "renderer.h"
+
+#include <stdint.h>
+
+// Stackless coroutines for render states, protothread style. The toolchain
+// for the M0 (GCC 7) has no C++20 coroutines, so the resume point is stored
+// as a line number and the body is a switch. Rules that come with that:
+//  - Locals do not survive a suspension, keep state in a struct
+//  - Only one await per source line
+//  - No switch statements around an await
+// The await macros return from the render function. They return true on
+// the first suspension so anything drawn since the last one is flushed,
+// and false while still waiting so the renderer can skip the frame.
+typedef struct
+{
+    uint16_t line;
+    uint8_t fresh;
+    uint32_t timer;
+} coroutine_t;
+
+#define CO_INIT(co) do { (co)->line = 0; (co)->fresh = 0; } while (0)
+
+#define CO_BEGIN(co) switch ((co)->line) { case 0:
+
+// Falling out of the body restarts the coroutine on the next resume
+#define CO_END(co) } (co)->line = 0; (co)->fresh = 0; return true
+
+#define CO_AWAIT(co, cond)                          \
+    do                                              \
+    {                                               \
+        (co)->line = __LINE__;                      \
+        (co)->fresh = 1;                            \
+        case __LINE__:                              \
+        if (!(cond))                                \
+        {                                           \
+            bool _co_flush = (co)->fresh;           \
+            (co)->fresh = 0;                        \
+            return _co_flush;                       \
+        }                                           \
+    } while (0)
+
+// Suspend until the next frame
+#define CO_AWAIT_FRAME(co) CO_AWAIT(co, !(co)->fresh)
+
+// Suspend until the next frame, returning whether this frame changed
+#define CO_YIELD(co, changed)                       \
+    do                                              \
+    {                                               \
+        (co)->line = __LINE__;                      \
+        return (changed);                           \
+        case __LINE__:;                             \
+    } while (0)
+
+// Suspend for at least ms milliseconds of frame time
+#define CO_AWAIT_MS(co, ctx, ms)                                        \
+    do                                                                  \
+    {                                                                   \
+        (co)->timer = (ctx)->now;                                       \
+        CO_AWAIT(co, ((ctx)->now - (co)->timer) >= (uint32_t)(ms));     \
+    } while (0)
+
+// Suspend until one of the buttons in mask is released, edges from the
+// frame the await was reached in are ignored
+#define CO_AWAIT_BUTTON(co, ctx, mask) \
+    CO_AWAIT(co, !(co)->fresh && (((ctx)->released & (mask)) != 0))
+
+#endif // COROUTINE_H_
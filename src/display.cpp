@@ -0,0 +1,423 @@
+#include "display.h"
+
+#include <Arduino.h>
+
+#include <string.h>
+
+#define SH110X_COMMAND_PREFIX   0x00
+#define SH110X_DATA_PREFIX      0x40
+// Control byte with the continuation bit: one command byte follows, then
+// another control byte
+#define SH110X_COMMAND_BYTE     0x80
+#define SH110X_NOP              0xE3
+#define SH110X_SET_PAGE         0xB0
+#define SH110X_SET_COLUMN_HIGH  0x10
+#define SH110X_SET_COLUMN_LOW   0x00
+#define SH110X_SET_START_LINE   0xDC
+#define SH110X_SET_CONTRAST     0x81
+#define SH110X_PANEL_OFF        0xAE
+#define SH110X_PANEL_ON         0xAF
+#define SH110X_NORMAL           0xA6
+#define SH110X_INVERTED         0xA7
+
+#define ALL_PAGES 0xFFFF
+
+// Bits [from, to) of a 32 bit frame word, 0 <= from < to <= 32
+static inline uint32_t word_mask(int16_t from, int16_t to)
+{
+    uint32_t upper = (to >= 32) ? 0xFFFFFFFFUL : ((1UL << to) - 1);
+    uint32_t lower = (1UL << from) - 1;
+    return upper & ~lower;
+}
+
+FrameDisplay::FrameDisplay(TwoWire* twi)
+    : Adafruit_SH1107(LCD_HEIGHT, LCD_WIDTH, twi),
+      dirty(ALL_PAGES),
+      target(frame_buffer),
+      target_dirty(&dirty),
+      scroll_line(0),
+      batch_pages(true)
+{
+    memset(frame_buffer, 0, sizeof(frame_buffer));
+    reset_stats();
+    reset_flush_timing();
+}
+
+FrameDisplay::~FrameDisplay()
+{
+    // Not ours to free
+    buffer = NULL;
+}
+
+bool FrameDisplay::begin(uint8_t i2caddr, bool reset)
+{
+    buffer = frame_buffer;
+    return Adafruit_SH1107::begin(i2caddr, reset);
+}
+
+void FrameDisplay::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    if ((x < 0) || (x >= LCD_WIDTH) || (y < 0) || (y >= LCD_HEIGHT))
+    {
+        return;
+    }
+
+    ++counters.pixel_ops;
+    uint8_t* byte = &target[(y * BYTES_PER_LINE) + (x >> 3)];
+    uint8_t mask = 1 << (x & 7);
+    switch (color)
+    {
+        case MONOOLED_WHITE:
+            *byte |= mask;
+            break;
+        case MONOOLED_BLACK:
+            *byte &= ~mask;
+            break;
+        case MONOOLED_INVERSE:
+            *byte ^= mask;
+            break;
+        default:
+            break;
+    }
+    *target_dirty |= (1 << (x >> 3));
+}
+
+void FrameDisplay::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if ((x + w) > LCD_WIDTH)
+    {
+        w = LCD_WIDTH - x;
+    }
+    if ((y + h) > LCD_HEIGHT)
+    {
+        h = LCD_HEIGHT - y;
+    }
+    if ((w <= 0) || (h <= 0))
+    {
+        return;
+    }
+
+    ++counters.rect_ops;
+    counters.rect_pixels += (uint32_t)w * h;
+    uint32_t masks[WORDS_PER_LINE];
+    for (uint8_t i = 0; i < WORDS_PER_LINE; ++i)
+    {
+        int16_t from = max((int16_t)(x - (i * 32)), (int16_t)0);
+        int16_t to = min((int16_t)(x + w - (i * 32)), (int16_t)32);
+        masks[i] = (from < to) ? word_mask(from, to) : 0;
+    }
+
+    uint32_t* line = (uint32_t*)&target[y * BYTES_PER_LINE];
+    for (int16_t row = 0; row < h; ++row)
+    {
+        for (uint8_t i = 0; i < WORDS_PER_LINE; ++i)
+        {
+            if (color == MONOOLED_WHITE)
+            {
+                line[i] |= masks[i];
+            }
+            else if (color == MONOOLED_BLACK)
+            {
+                line[i] &= ~masks[i];
+            }
+            else if (color == MONOOLED_INVERSE)
+            {
+                line[i] ^= masks[i];
+            }
+        }
+        line += WORDS_PER_LINE;
+    }
+    *target_dirty |= pages_of(x, w);
+}
+
+void FrameDisplay::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    fillRect(x, y, w, 1, color);
+}
+
+void FrameDisplay::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    fillRect(x, y, 1, h, color);
+}
+
+void FrameDisplay::clearDisplay()
+{
+    memset(target, 0, FRAME_BYTES);
+    *target_dirty = ALL_PAGES;
+}
+
+uint8_t* FrameDisplay::frame()
+{
+    return frame_buffer;
+}
+
+void FrameDisplay::set_target(uint8_t* buffer, uint16_t* dirty_pages)
+{
+    if ((buffer == NULL) || (dirty_pages == NULL))
+    {
+        buffer = frame_buffer;
+        dirty_pages = &dirty;
+    }
+    target = buffer;
+    target_dirty = dirty_pages;
+}
+
+// Pages covering logical columns [x, x + w)
+uint16_t FrameDisplay::pages_of(int16_t x, int16_t w)
+{
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if ((x + w) > LCD_WIDTH)
+    {
+        w = LCD_WIDTH - x;
+    }
+    if (w <= 0)
+    {
+        return 0;
+    }
+
+    uint8_t first = x >> 3;
+    uint8_t last = (x + w - 1) >> 3;
+    return (uint16_t)(((2UL << last) - 1) & ~((1UL << first) - 1));
+}
+
+void FrameDisplay::mark_dirty(int16_t x, int16_t w)
+{
+    dirty |= pages_of(x, w);
+}
+
+void FrameDisplay::mark_all_dirty()
+{
+    dirty = ALL_PAGES;
+}
+
+void FrameDisplay::clear_dirty()
+{
+    dirty = 0;
+}
+
+uint16_t FrameDisplay::dirty_pages() const
+{
+    return dirty;
+}
+
+void FrameDisplay::set_start_line(uint8_t line)
+{
+    line %= LCD_WIDTH;
+    uint8_t cmd[] = { SH110X_SET_START_LINE, line };
+    send_commands(cmd, sizeof(cmd));
+    scroll_line = line;
+}
+
+uint8_t FrameDisplay::start_line() const
+{
+    return scroll_line;
+}
+
+void FrameDisplay::set_contrast(uint8_t level)
+{
+    uint8_t cmd[] = { SH110X_SET_CONTRAST, level };
+    send_commands(cmd, sizeof(cmd));
+}
+
+void FrameDisplay::set_panel_on(bool on)
+{
+    uint8_t cmd = on ? SH110X_PANEL_ON : SH110X_PANEL_OFF;
+    send_commands(&cmd, 1);
+}
+
+void FrameDisplay::set_inverted(bool inverted)
+{
+    uint8_t cmd = inverted ? SH110X_INVERTED : SH110X_NORMAL;
+    send_commands(&cmd, 1);
+}
+
+void FrameDisplay::send_commands(const uint8_t* commands, uint8_t count)
+{
+    if (i2c_dev == NULL)
+    {
+        return;
+    }
+    uint8_t prefix = SH110X_COMMAND_PREFIX;
+    i2c_dev->write(commands, count, true, &prefix, 1);
+}
+
+void FrameDisplay::send_page(uint8_t page, const uint8_t* data)
+{
+    uint8_t column_high = SH110X_SET_COLUMN_HIGH + (_page_start_offset >> 4);
+    uint8_t column_low = SH110X_SET_COLUMN_LOW + (_page_start_offset & 0x0F);
+
+    // Addressing and data in one transaction saves a start, an address
+    // byte and a stop per page, and the Wire set up between them. The
+    // data stream cannot be interrupted by commands, so a page is the
+    // largest transaction page addressing allows.
+    uint8_t header[] = {
+        SH110X_COMMAND_BYTE, (uint8_t)(SH110X_SET_PAGE + page),
+        SH110X_COMMAND_BYTE, column_high,
+        SH110X_COMMAND_BYTE, column_low,
+        SH110X_DATA_PREFIX
+    };
+    if (batch_pages && ((sizeof(header) + PAGE_BYTES) <= i2c_dev->maxBufferSize()))
+    {
+        i2c_dev->write(data, PAGE_BYTES, true, header, sizeof(header));
+        return;
+    }
+
+    uint8_t cmd[] = {
+        SH110X_COMMAND_PREFIX,
+        (uint8_t)(SH110X_SET_PAGE + page),
+        column_high,
+        column_low
+    };
+    i2c_dev->write(cmd, sizeof(cmd));
+
+    uint8_t dc_byte = SH110X_DATA_PREFIX;
+    uint16_t chunk = i2c_dev->maxBufferSize() - 1;
+    uint16_t remaining = PAGE_BYTES;
+    while (remaining)
+    {
+        uint16_t to_write = min(remaining, chunk);
+        i2c_dev->write(data, to_write, true, &dc_byte, 1);
+        data += to_write;
+        remaining -= to_write;
+    }
+}
+
+bool FrameDisplay::probe()
+{
+    uint8_t nop[] = { SH110X_COMMAND_PREFIX, SH110X_NOP };
+    for (uint8_t i = 0; i < I2C_PROBE_WRITES; ++i)
+    {
+        if (!i2c_dev->write(nop, sizeof(nop)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t FrameDisplay::set_bus_speed(uint32_t hz)
+{
+    static const uint32_t clocks[] = { I2C_FAST_PLUS_HZ, I2C_FAST_HZ, I2C_STANDARD_HZ };
+    if (i2c_dev == NULL)
+    {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); ++i)
+    {
+        if ((clocks[i] > hz) || !i2c_dev->setSpeed(clocks[i]))
+        {
+            continue;
+        }
+        if (probe())
+        {
+            i2c_preclk = clocks[i];
+            i2c_postclk = clocks[i];
+            return clocks[i];
+        }
+    }
+    // Nothing answered, leave the bus as the driver set it up
+    i2c_dev->setSpeed(i2c_postclk);
+    return 0;
+}
+
+uint32_t FrameDisplay::bus_speed() const
+{
+    return i2c_postclk;
+}
+
+void FrameDisplay::set_page_batching(bool batch)
+{
+    batch_pages = batch;
+}
+
+void FrameDisplay::display()
+{
+    yield();
+    present(frame_buffer, dirty);
+    dirty = 0;
+}
+
+void FrameDisplay::present(const uint8_t* buffer, uint16_t pages)
+{
+    if ((pages == 0) || (i2c_dev == NULL))
+    {
+        return;
+    }
+
+    ++counters.flushes;
+    uint32_t frame_start = micros();
+    // The driver's default runs flushes faster than everything else, once
+    // set_bus_speed() has run both clocks are the same
+    if (i2c_preclk != i2c_postclk)
+    {
+        i2c_dev->setSpeed(i2c_preclk);
+    }
+    uint8_t page_data[PAGE_BYTES];
+    for (uint8_t page = 0; page < DISPLAY_PAGES; ++page)
+    {
+        if (!(pages & (1 << page)))
+        {
+            continue;
+        }
+
+        // Controller column 0 is the bottom line of the rotated frame
+        const uint8_t* src = &buffer[((LCD_HEIGHT - 1) * BYTES_PER_LINE) + page];
+        for (uint8_t column = 0; column < PAGE_BYTES; ++column)
+        {
+            page_data[column] = *src;
+            src -= BYTES_PER_LINE;
+        }
+        uint32_t page_start = micros();
+        send_page(page, page_data);
+        uint32_t page_us = micros() - page_start;
+        counters.flushed_bytes += PAGE_BYTES;
+        ++timing.pages;
+        timing.page_us = page_us;
+        timing.page_us_max = max(timing.page_us_max, page_us);
+    }
+    if (i2c_preclk != i2c_postclk)
+    {
+        i2c_dev->setSpeed(i2c_postclk);
+    }
+
+    uint32_t frame_us = micros() - frame_start;
+    ++timing.frames;
+    timing.total_us += frame_us;
+    timing.frame_us = frame_us;
+    timing.frame_us_max = max(timing.frame_us_max, frame_us);
+}
+
+const display_stats_t& FrameDisplay::stats() const
+{
+    return counters;
+}
+
+void FrameDisplay::reset_stats()
+{
+    memset(&counters, 0, sizeof(counters));
+}
+
+const flush_timing_t& FrameDisplay::flush_timing() const
+{
+    return timing;
+}
+
+void FrameDisplay::reset_flush_timing()
+{
+    memset(&timing, 0, sizeof(timing));
+}
@@ -0,0 +1,136 @@
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SH110X.h>
+#include <Wire.h>
+#include <stdint.h>
+
+#define LCD_WIDTH       (128)
+#define LCD_HEIGHT      (64)
+#define BYTES_PER_LINE  (16)
+#define WORDS_PER_LINE  (BYTES_PER_LINE / 4)
+#define FRAME_BYTES     (LCD_HEIGHT * BYTES_PER_LINE)
+
+// The SH1107 is 64x128 in portrait and used rotated. With that rotation a
+// controller page is a column of 8 logical pixels across all 64 lines,
+// which is exactly one byte column of the row-major frame.
+#define DISPLAY_PAGES   (LCD_WIDTH / 8)
+#define PAGE_BYTES      (LCD_HEIGHT)
+
+// I2C clocks tried by set_bus_speed(). The SH1107 is only specified for
+// Fast-mode, Fast-mode Plus works on most modules and is probed for.
+#define I2C_STANDARD_HZ     (100000UL)
+#define I2C_FAST_HZ         (400000UL)
+#define I2C_FAST_PLUS_HZ    (1000000UL)
+// Writes that must all be acknowledged before a clock is accepted
+#define I2C_PROBE_WRITES    (8)
+
+// Work done through the display, deterministic for a given sequence of
+// drawing calls so it can be compared between builds
+typedef struct
+{
+    uint32_t pixel_ops;
+    uint32_t rect_ops;
+    uint32_t rect_pixels;
+    uint32_t flushes;
+    uint32_t flushed_bytes;
+} display_stats_t;
+
+// Time spent sending to the panel, unlike display_stats_t this depends on
+// the bus and is not comparable between runs
+typedef struct
+{
+    uint32_t frames;
+    uint32_t pages;
+    uint32_t total_us;
+    uint32_t frame_us;
+    uint32_t frame_us_max;
+    uint32_t page_us;
+    uint32_t page_us_max;
+} flush_timing_t;
+
+// SH1107 with a row-major frame buffer in logical (landscape) orientation,
+// 16 bytes per line, least significant bit leftmost. Everything drawn
+// through Adafruit GFX lands in that frame, as do raw writes through
+// frame(). Only pages marked dirty are sent by display().
+//
+// Drawing can be pointed at another buffer of the same layout with
+// set_target(), e.g. a layer (see layers.h). The frame, its dirty pages
+// and display() are not affected by the target.
+class FrameDisplay : public Adafruit_SH1107
+{
+public:
+    FrameDisplay(TwoWire* twi);
+    ~FrameDisplay();
+
+    // The driver's own 1 KB buffer would be malloc'd by begin() and never
+    // drawn to, it is pointed at the frame instead
+    bool begin(uint8_t i2caddr = 0x3C, bool reset = true);
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void clearDisplay();
+    void display() override;
+
+    uint8_t* frame();
+
+    // Send GFX drawing and clearDisplay() to buffer, its touched pages are
+    // ORed into dirty_pages. NULL for either goes back to the frame.
+    void set_target(uint8_t* buffer, uint16_t* dirty_pages);
+
+    // Mark logical columns [x, x + w) for the next flush
+    void mark_dirty(int16_t x, int16_t w);
+    void mark_all_dirty();
+    // The panel already shows the frame, e.g. after present()
+    void clear_dirty();
+    uint16_t dirty_pages() const;
+
+    // Send pages of another row-major buffer, the frame is left untouched
+    void present(const uint8_t* buffer, uint16_t pages);
+
+    // Hardware scroll along the controller's COM axis, which is the
+    // horizontal axis once rotated: screen column x shows frame column
+    // (x + line) % LCD_WIDTH. Costs two command bytes, no frame data.
+    void set_start_line(uint8_t line);
+    uint8_t start_line() const;
+
+    // Whole screen effects that cost a few command bytes, the frame and
+    // the controller RAM are left untouched
+    void set_contrast(uint8_t level);
+    void set_panel_on(bool on);
+    void set_inverted(bool inverted);
+
+    void send_commands(const uint8_t* commands, uint8_t count);
+
+    // Run the bus at the fastest clock up to hz that the controller
+    // acknowledges, returns the clock chosen, 0 if none was
+    uint32_t set_bus_speed(uint32_t hz);
+    uint32_t bus_speed() const;
+    // Send each page's addressing and data as one transaction (default),
+    // or as separate command and data transactions
+    void set_page_batching(bool batch);
+
+    const display_stats_t& stats() const;
+    void reset_stats();
+    const flush_timing_t& flush_timing() const;
+    void reset_flush_timing();
+
+private:
+    void send_page(uint8_t page, const uint8_t* data);
+    bool probe();
+    static uint16_t pages_of(int16_t x, int16_t w);
+
+    uint8_t frame_buffer[FRAME_BYTES] __attribute__((aligned(4)));
+    uint16_t dirty;
+    uint8_t* target;
+    uint16_t* target_dirty;
+    uint8_t scroll_line;
+    bool batch_pages;
+    display_stats_t counters;
+    flush_timing_t timing;
+};
+
+#endif // DISPLAY_H_
@@ -0,0 +1,259 @@
+#include "grayscale.h"
+
+#include "renderer.h"
+#include "sprite.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define HIGH_PLANE 1
+#define LOW_PLANE 0
+#define ALL_PAGES 0xFFFF
+#define STATS_PERIOD_US 1000000UL
+
+typedef struct
+{
+    bool active;
+    uint8_t phase;
+    uint8_t shown;
+    uint16_t dirty;
+    // Pages where the two planes differ
+    uint16_t differ;
+    uint32_t period_us;
+    uint32_t last_us;
+    uint32_t window_us;
+    uint32_t window_planes;
+    uint32_t window_flush_us;
+    grayscale_stats_t stats;
+} grayscale_t;
+
+static uint8_t planes[GRAYSCALE_PLANES][FRAME_BYTES] __attribute__((aligned(4)));
+static grayscale_t gray;
+
+// Columns [first, last) of word w
+static inline uint32_t column_mask(uint8_t w, int16_t first, int16_t last)
+{
+    int16_t lo = first - (w * 32);
+    int16_t hi = last - (w * 32);
+    uint32_t mask = (hi >= 32) ? 0xFFFFFFFFUL : ((hi <= 0) ? 0 : ((1UL << hi) - 1));
+    if (lo > 0)
+    {
+        mask &= (lo >= 32) ? 0 : ~((1UL << lo) - 1);
+    }
+    return mask;
+}
+
+static uint16_t differing_pages()
+{
+    const uint32_t* low = (const uint32_t*)planes[LOW_PLANE];
+    const uint32_t* high = (const uint32_t*)planes[HIGH_PLANE];
+    uint32_t differ[WORDS_PER_LINE] = { 0 };
+    for (uint16_t i = 0; i < (FRAME_BYTES / 4); ++i)
+    {
+        differ[i & (WORDS_PER_LINE - 1)] |= low[i] ^ high[i];
+    }
+
+    uint16_t pages = 0;
+    for (uint8_t w = 0; w < WORDS_PER_LINE; ++w)
+    {
+        for (uint8_t i = 0; i < 4; ++i)
+        {
+            if (differ[w] & (0xFFUL << (i * 8)))
+            {
+                pages |= 1 << ((w * 4) + i);
+            }
+        }
+    }
+    return pages;
+}
+
+void grayscale_begin(uint16_t plane_hz)
+{
+    memset(&gray, 0, sizeof(gray));
+    if (plane_hz == 0)
+    {
+        plane_hz = GRAYSCALE_DEFAULT_HZ;
+    }
+    gray.stats.target_rate = plane_hz;
+    gray.period_us = 1000000UL / plane_hz;
+    gray.last_us = micros();
+    gray.window_us = gray.last_us;
+    gray.shown = HIGH_PLANE;
+    gray.active = true;
+    grayscale_clear();
+}
+
+void grayscale_end()
+{
+    gray.active = false;
+    // Put the monochrome frame back on the next flush
+    display->mark_all_dirty();
+}
+
+bool grayscale_active()
+{
+    return gray.active;
+}
+
+uint8_t* grayscale_plane(uint8_t plane)
+{
+    return planes[plane % GRAYSCALE_PLANES];
+}
+
+void grayscale_invalidate(int16_t x, int16_t w)
+{
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if ((x + w) > LCD_WIDTH)
+    {
+        w = LCD_WIDTH - x;
+    }
+    if (w <= 0)
+    {
+        return;
+    }
+    uint8_t first = x >> 3;
+    uint8_t last = (x + w - 1) >> 3;
+    gray.dirty |= (uint16_t)(((2UL << last) - 1) & ~((1UL << first) - 1));
+}
+
+void grayscale_clear()
+{
+    memset(planes, 0, sizeof(planes));
+    gray.dirty = ALL_PAGES;
+}
+
+void grayscale_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t level)
+{
+    int16_t top = max(y, (int16_t)0);
+    int16_t bottom = min((int16_t)(y + h), (int16_t)LCD_HEIGHT);
+    uint32_t masks[WORDS_PER_LINE];
+    for (uint8_t i = 0; i < WORDS_PER_LINE; ++i)
+    {
+        masks[i] = column_mask(i, x, x + w);
+    }
+
+    for (uint8_t plane = 0; plane < GRAYSCALE_PLANES; ++plane)
+    {
+        bool set = (level >> plane) & 1;
+        uint32_t* words = (uint32_t*)planes[plane];
+        for (int16_t line = top; line < bottom; ++line)
+        {
+            uint32_t* row = &words[line * WORDS_PER_LINE];
+            for (uint8_t i = 0; i < WORDS_PER_LINE; ++i)
+            {
+                row[i] = set ? (row[i] | masks[i]) : (row[i] & ~masks[i]);
+            }
+        }
+    }
+    grayscale_invalidate(x, w);
+}
+
+void grayscale_draw_image(const image_t* image, int16_t x, int16_t y, uint8_t scale, uint8_t level)
+{
+    for (uint8_t plane = 0; plane < GRAYSCALE_PLANES; ++plane)
+    {
+        sprite_draw(planes[plane], image, x, y, scale, SPRITE_OR);
+        if (!((level >> plane) & 1))
+        {
+            // OR then XOR leaves the image pixels clear
+            sprite_draw(planes[plane], image, x, y, scale, SPRITE_XOR);
+        }
+    }
+    grayscale_invalidate(x, image->width * scale);
+}
+
+void grayscale_capture(uint8_t level)
+{
+    uint16_t pages = display->dirty_pages();
+    if (pages == 0)
+    {
+        return;
+    }
+
+    // Byte i of word w is page (w * 4) + i
+    uint32_t masks[WORDS_PER_LINE];
+    for (uint8_t w = 0; w < WORDS_PER_LINE; ++w)
+    {
+        masks[w] = 0;
+        for (uint8_t i = 0; i < 4; ++i)
+        {
+            if (pages & (1 << ((w * 4) + i)))
+            {
+                masks[w] |= 0xFFUL << (i * 8);
+            }
+        }
+    }
+
+    const uint32_t* frame = (const uint32_t*)display->frame();
+    for (uint8_t plane = 0; plane < GRAYSCALE_PLANES; ++plane)
+    {
+        bool set = (level >> plane) & 1;
+        uint32_t* words = (uint32_t*)planes[plane];
+        for (uint16_t i = 0; i < (FRAME_BYTES / 4); ++i)
+        {
+            uint32_t pixels = frame[i] & masks[i & (WORDS_PER_LINE - 1)];
+            words[i] = set ? (words[i] | pixels) : (words[i] & ~pixels);
+        }
+    }
+    gray.dirty |= pages;
+    display->clear_dirty();
+}
+
+void grayscale_service(uint32_t now_us)
+{
+    if (!gray.active)
+    {
+        return;
+    }
+
+    uint32_t since = now_us - gray.last_us;
+    if (since < gray.period_us)
+    {
+        return;
+    }
+    if (since >= (2 * gray.period_us))
+    {
+        ++gray.stats.late;
+    }
+    gray.last_us = now_us;
+
+    gray.phase = (gray.phase + 1) % GRAYSCALE_SUBFRAMES;
+    uint8_t next = (gray.phase < (GRAYSCALE_SUBFRAMES - 1)) ? HIGH_PLANE : LOW_PLANE;
+    if (gray.dirty != 0)
+    {
+        gray.differ = differing_pages();
+    }
+    uint16_t pages = gray.dirty;
+    if (next != gray.shown)
+    {
+        pages |= gray.differ;
+    }
+    gray.dirty = 0;
+    gray.shown = next;
+
+    uint32_t start = micros();
+    display->present(planes[next], pages);
+    uint32_t flush_us = micros() - start;
+    gray.window_flush_us = max(gray.window_flush_us, flush_us);
+    gray.stats.bytes_sent += __builtin_popcount(pages) * PAGE_BYTES;
+    ++gray.stats.planes;
+    ++gray.window_planes;
+
+    if ((now_us - gray.window_us) >= STATS_PERIOD_US)
+    {
+        gray.stats.plane_rate = (uint16_t)gray.window_planes;
+        gray.stats.flush_us = gray.window_flush_us;
+        gray.window_planes = 0;
+        gray.window_flush_us = 0;
+        gray.window_us = now_us;
+    }
+}
+
+const grayscale_stats_t* grayscale_stats()
+{
+    return &gray.stats;
+}
@@ -0,0 +1,54 @@
+#ifndef GRAYSCALE_H_
+#define GRAYSCALE_H_
+
+#include "images.h"
+
+#include <stdint.h>
+
+// Four level grayscale on the 1 bit panel by frame rate modulation. The
+// picture is two bit-planes in the row-major frame format, the high plane
+// is shown for two sub-frames and the low plane for one, so level n is lit
+// n/3 of the time. Only pages where the planes differ (or that were drawn
+// into) are sent when the shown plane changes, so the achievable plane
+// rate depends on how much of the screen is gray and on the bus speed.
+//
+// Grayscale owns the screen between begin and end, the frame buffer is
+// not flushed meanwhile and can be used to draw text for capture.
+
+#define GRAYSCALE_LEVELS 4
+#define GRAYSCALE_PLANES 2
+#define GRAYSCALE_SUBFRAMES 3
+#define GRAYSCALE_DEFAULT_HZ 150
+
+typedef struct
+{
+    // Sub-frames shown over the last second and requested
+    uint16_t plane_rate;
+    uint16_t target_rate;
+    uint32_t planes;
+    // Sub-frames that started a full period or more late
+    uint32_t late;
+    uint32_t bytes_sent;
+    // Slowest sub-frame flush over the last second
+    uint32_t flush_us;
+} grayscale_stats_t;
+
+void grayscale_begin(uint16_t plane_hz);
+void grayscale_end();
+bool grayscale_active();
+
+uint8_t* grayscale_plane(uint8_t plane);
+// Mark columns [x, x + w) of the planes as changed
+void grayscale_invalidate(int16_t x, int16_t w);
+
+void grayscale_clear();
+void grayscale_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t level);
+void grayscale_draw_image(const image_t* image, int16_t x, int16_t y, uint8_t scale, uint8_t level);
+// Copy the pixels set in the frame's dirty pages into the planes at level
+void grayscale_capture(uint8_t level);
+
+// Show the next sub-frame when it is due, called from render()
+void grayscale_service(uint32_t now_us);
+const grayscale_stats_t* grayscale_stats();
+
+#endif // GRAYSCALE_H_
@@ -0,0 +1,101 @@
+#include "highlight.h"
+
+#include "display.h"
+#include "renderer.h"
+
+#include <stdint.h>
+
+typedef struct
+{
+    highlight_region_t regions[HIGHLIGHT_MAX_REGIONS];
+    uint8_t count;
+    bool screen;
+    bool on;
+} highlight_t;
+
+static highlight_t highlight;
+
+static void invert_region(const highlight_region_t* region)
+{
+    // fillRect inverts a word at a time and marks the pages dirty
+    display->fillRect(region->x, region->y, region->w, region->h, MONOOLED_INVERSE);
+}
+
+void highlight_clear()
+{
+    if (highlight.screen && highlight.on)
+    {
+        render_set_inverted(false);
+    }
+    highlight.count = 0;
+    highlight.screen = false;
+    highlight.on = false;
+}
+
+bool highlight_add(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    w = min(w, (int16_t)(LCD_WIDTH - x));
+    h = min(h, (int16_t)(LCD_HEIGHT - y));
+    if ((w <= 0) || (h <= 0))
+    {
+        return true;
+    }
+
+    if ((w == LCD_WIDTH) && (h == LCD_HEIGHT))
+    {
+        highlight.screen = true;
+        if (highlight.on)
+        {
+            render_set_inverted(true);
+        }
+        return true;
+    }
+
+    if (highlight.count >= HIGHLIGHT_MAX_REGIONS)
+    {
+        return false;
+    }
+    highlight_region_t* region = &highlight.regions[highlight.count++];
+    region->x = x;
+    region->y = y;
+    region->w = w;
+    region->h = h;
+    if (highlight.on)
+    {
+        invert_region(region);
+    }
+    return true;
+}
+
+bool highlight_set(bool on)
+{
+    if (on == highlight.on)
+    {
+        return false;
+    }
+    highlight.on = on;
+    if (highlight.screen)
+    {
+        render_set_inverted(on);
+    }
+    for (uint8_t i = 0; i < highlight.count; ++i)
+    {
+        invert_region(&highlight.regions[i]);
+    }
+    return highlight.count > 0;
+}
+
+bool highlight_on()
+{
+    return highlight.on;
+}
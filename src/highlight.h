@@ -0,0 +1,36 @@
+#ifndef HIGHLIGHT_H_
+#define HIGHLIGHT_H_
+
+#include <stdint.h>
+
+// Blinking and flashing without redrawing. Rectangles registered here are
+// XOR inverted in the frame in place when the highlight is switched on and
+// inverted back when it is switched off, so a flash phase costs one
+// rectangle XOR per region plus a flush of the pages they cover. A region
+// covering the whole screen is done with the panel's invert command and
+// costs no frame data at all.
+//
+// The frame is taken to be drawn normally when regions are added. A state
+// that redraws under its regions clears them first and adds them again;
+// pushing or popping a render state clears them.
+
+#define HIGHLIGHT_MAX_REGIONS 40
+
+typedef struct
+{
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+} highlight_region_t;
+
+// Forget the regions, the panel invert is switched off
+void highlight_clear();
+// Clipped to the screen, inverted straight away if the highlight is on.
+// False when there is no room left.
+bool highlight_add(int16_t x, int16_t y, int16_t w, int16_t h);
+// Returns true when the frame changed and needs a flush
+bool highlight_set(bool on);
+bool highlight_on();
+
+#endif // HIGHLIGHT_H_
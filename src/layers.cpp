@@ -0,0 +1,161 @@
+#include "layers.h"
+
+#include "display.h"
+#include "renderer.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define LAYER_ALL_PAGES ((uint16_t)((1UL << DISPLAY_PAGES) - 1))
+#define BYTES_PER_WORD 4
+
+typedef struct
+{
+    uint8_t buffers[LAYERS][FRAME_BYTES] __attribute__((aligned(4)));
+    uint16_t dirty[LAYERS];
+    // Pages drawn on since the layer was cleared
+    uint16_t used[LAYERS];
+    bool visible[LAYERS];
+    uint8_t selected;
+    bool active;
+} layers_t;
+
+static layers_t layers;
+
+void layers_begin()
+{
+    for (uint8_t layer = 0; layer < LAYERS; ++layer)
+    {
+        layer_clear(layer);
+        layers.visible[layer] = true;
+    }
+    layers.active = true;
+    layer_select(LAYER_CONTENT);
+}
+
+void layers_end()
+{
+    if (layers.active)
+    {
+        display->set_target(NULL, NULL);
+        layers.active = false;
+    }
+}
+
+bool layers_active()
+{
+    return layers.active;
+}
+
+void layer_select(uint8_t layer)
+{
+    if (layer >= LAYERS)
+    {
+        return;
+    }
+    layers.selected = layer;
+    display->set_target(layers.buffers[layer], &layers.dirty[layer]);
+}
+
+uint8_t layer_selected()
+{
+    return layers.selected;
+}
+
+void layer_clear(uint8_t layer)
+{
+    if (layer >= LAYERS)
+    {
+        return;
+    }
+    memset(layers.buffers[layer], 0, FRAME_BYTES);
+    layers.dirty[layer] = LAYER_ALL_PAGES;
+    layers.used[layer] = 0;
+}
+
+void layer_set_visible(uint8_t layer, bool visible)
+{
+    if ((layer >= LAYERS) || (layers.visible[layer] == visible))
+    {
+        return;
+    }
+    layers.visible[layer] = visible;
+    layers.dirty[layer] |= layers.used[layer];
+}
+
+bool layers_compose()
+{
+    if (!layers.active)
+    {
+        return false;
+    }
+
+    uint16_t pages = 0;
+    uint32_t shown[LAYERS];
+    for (uint8_t layer = 0; layer < LAYERS; ++layer)
+    {
+        pages |= layers.dirty[layer];
+        layers.used[layer] |= layers.dirty[layer];
+        layers.dirty[layer] = 0;
+        shown[layer] = layers.visible[layer] ? 0xFFFFFFFFUL : 0;
+    }
+    if (pages == 0)
+    {
+        return false;
+    }
+
+    // Word i of a line holds pages 4i to 4i + 3, one byte each
+    uint32_t masks[WORDS_PER_LINE];
+    uint32_t changed[WORDS_PER_LINE];
+    for (uint8_t i = 0; i < WORDS_PER_LINE; ++i)
+    {
+        masks[i] = 0;
+        changed[i] = 0;
+        for (uint8_t b = 0; b < BYTES_PER_WORD; ++b)
+        {
+            if (pages & (1u << ((i * BYTES_PER_WORD) + b)))
+            {
+                masks[i] |= 0xFFUL << (b * 8);
+            }
+        }
+    }
+
+    uint32_t* frame = (uint32_t*)display->frame();
+    const uint32_t* background = (const uint32_t*)layers.buffers[LAYER_BACKGROUND];
+    const uint32_t* content = (const uint32_t*)layers.buffers[LAYER_CONTENT];
+    const uint32_t* overlay = (const uint32_t*)layers.buffers[LAYER_OVERLAY];
+    for (uint16_t line = 0; line < LCD_HEIGHT; ++line)
+    {
+        for (uint8_t i = 0; i < WORDS_PER_LINE; ++i)
+        {
+            if (masks[i] == 0)
+            {
+                continue;
+            }
+            uint32_t composed = ((background[i] & shown[LAYER_BACKGROUND])
+                                 | (content[i] & shown[LAYER_CONTENT]))
+                                ^ (overlay[i] & shown[LAYER_OVERLAY]);
+            uint32_t next = (frame[i] & ~masks[i]) | (composed & masks[i]);
+            changed[i] |= frame[i] ^ next;
+            frame[i] = next;
+        }
+        frame += WORDS_PER_LINE;
+        background += WORDS_PER_LINE;
+        content += WORDS_PER_LINE;
+        overlay += WORDS_PER_LINE;
+    }
+
+    bool flush = false;
+    for (uint8_t i = 0; i < WORDS_PER_LINE; ++i)
+    {
+        for (uint8_t b = 0; b < BYTES_PER_WORD; ++b)
+        {
+            if ((changed[i] >> (b * 8)) & 0xFF)
+            {
+                display->mark_dirty(((i * BYTES_PER_WORD) + b) * 8, 8);
+                flush = true;
+            }
+        }
+    }
+    return flush;
+}
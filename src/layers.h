@@ -0,0 +1,43 @@
+#ifndef LAYERS_H_
+#define LAYERS_H_
+
+#include <stdint.h>
+
+// Layered drawing for states that mix static and animated content. Each
+// layer is a frame sized buffer with its own dirty pages; GFX drawing goes
+// to the selected layer and the renderer composes the frame from the
+// layers after the state has run, a word at a time over the pages any
+// layer touched. Static content is drawn into a layer once and survives
+// redraws of the layers above it.
+//
+// The background and content layers are ORed, the overlay is XORed over
+// them, so a filled rectangle in the overlay inverts what is below it.
+//
+// Pushing or popping a render state ends the layers, a state that uses
+// them calls layers_begin() whenever it is entered.
+
+#define LAYER_BACKGROUND 0
+#define LAYER_CONTENT 1
+#define LAYER_OVERLAY 2
+#define LAYERS 3
+
+// Clear every layer and select LAYER_CONTENT, the whole frame is composed
+// on the next frame
+void layers_begin();
+// Drawing goes straight to the frame again
+void layers_end();
+bool layers_active();
+
+// GFX drawing (and highlights) go to this layer until the next select
+void layer_select(uint8_t layer);
+uint8_t layer_selected();
+void layer_clear(uint8_t layer);
+// A hidden layer is left out of the composition, showing or hiding it
+// recomposes the pages it has drawn on
+void layer_set_visible(uint8_t layer, bool visible);
+
+// Compose the dirty pages into the frame. Only pages whose composition
+// differs from the frame are marked for the flush, returns true if any.
+bool layers_compose();
+
+#endif // LAYERS_H_
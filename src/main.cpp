@@ -1,29 +1,63 @@
 #include <Arduino.h>
 
+#include "bench.h"
+#include "boot.h"
 #include "buttons.h"
+#include "power.h"
+#include "protocol.h"
+#include "regression.h"
 #include "renderer.h"
+#include "stall.h"
 #include "render_states/splash_screen.h"
 #include "render_states/main_menu.h"
 
 #include <HardwareSerial.h>
 
-void setup() {
+static void start_serial() {
   Serial.begin(115200);
   Serial.println("128x64 OLED FeatherWing test");
   Serial.println("OLED begun");
+}
+
+// Only what the first frame needs runs before it, the rest is deferred
+void setup() {
+  boot_mark(BOOT_SETUP);
 
   pinMode(BUTTON_UP, INPUT_PULLUP);
   pinMode(BUTTON_SEL, INPUT_PULLUP);
   pinMode(BUTTON_DN, INPUT_PULLUP);
 
   render_init();
+  boot_mark(BOOT_DISPLAY);
+
+  boot_defer(start_serial);
+  boot_defer(power_init);
+#if !defined(CIPHERPAL_BENCH) && !defined(CIPHERPAL_REGRESSION)
+  // The bench and regression runs hold setup() far longer than a loop
+  boot_defer(stall_init);
+#endif
+
+#ifdef CIPHERPAL_REGRESSION
+  boot_finish();
+  regression_run(NULL);
+#endif
 
   push_render_function(&main_menu_render);
   push_render_function(&splash_screen_render);
+  render();
+
+#ifdef CIPHERPAL_BENCH
+  boot_finish();
+  bench_run();
+#endif
 }
 
 void loop() {
+  stall_feed();
   scan_buttons();
   render();
+  boot_service();
+  protocol_service();
+  power_service();
   yield();
 }
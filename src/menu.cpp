@@ -0,0 +1,177 @@
+#include "menu.h"
+
+#include "renderer.h"
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SH110X.h>
+
+#define ALL_ROWS(menu) ((menu->visible_rows >= MENU_MAX_ROWS) ? 0xFFFFFFFF : ((1UL << menu->visible_rows) - 1))
+
+static const int16_t entry_pad = 1;
+static const int16_t entry_margin = 1;
+static const int16_t entry_border = 1;
+static const int16_t scroll_marker_width = 6;
+
+static const uint8_t scroll_up_icon = 0x18;
+static const uint8_t scroll_down_icon = 0x19;
+
+void menu_init(menu_t* menu,
+               int16_t x,
+               int16_t y,
+               int16_t width,
+               int16_t row_height,
+               uint8_t visible_rows)
+{
+    menu->entries.clear();
+    menu->x = x;
+    menu->y = y;
+    menu->width = width;
+    menu->row_height = row_height;
+    menu->visible_rows = (visible_rows > MENU_MAX_ROWS) ? MENU_MAX_ROWS : visible_rows;
+    menu->selected = 0;
+    menu->first_visible = 0;
+    menu->dirty_rows = ALL_ROWS(menu);
+}
+
+void menu_add(menu_t* menu, const char* name, render_function_t state)
+{
+    menu_entry_t entry = {
+        .state = state,
+        .name = name
+    };
+    menu->entries.push_back(entry);
+    menu->dirty_rows = ALL_ROWS(menu);
+}
+
+void menu_clear(menu_t* menu)
+{
+    menu->entries.clear();
+    menu->selected = 0;
+    menu->first_visible = 0;
+    menu->dirty_rows = ALL_ROWS(menu);
+}
+
+void menu_invalidate(menu_t* menu)
+{
+    menu->dirty_rows = ALL_ROWS(menu);
+}
+
+static void invalidate_entry(menu_t* menu, uint16_t entry)
+{
+    if ((entry >= menu->first_visible)
+        && (entry < (menu->first_visible + menu->visible_rows)))
+    {
+        menu->dirty_rows |= (1UL << (entry - menu->first_visible));
+    }
+}
+
+void menu_move(menu_t* menu, int8_t direction)
+{
+    uint16_t count = menu->entries.size();
+    if (count == 0)
+    {
+        return;
+    }
+
+    uint16_t previous = menu->selected;
+    int32_t next = (int32_t)menu->selected + direction;
+    while (next < 0)
+    {
+        next += count;
+    }
+    menu->selected = next % count;
+
+    if (menu->selected < menu->first_visible)
+    {
+        menu->first_visible = menu->selected;
+        menu_invalidate(menu);
+    }
+    else if (menu->selected >= (menu->first_visible + menu->visible_rows))
+    {
+        menu->first_visible = menu->selected - menu->visible_rows + 1;
+        menu_invalidate(menu);
+    }
+    else
+    {
+        // Selection moved within the view, only two rows change
+        invalidate_entry(menu, previous);
+        invalidate_entry(menu, menu->selected);
+    }
+}
+
+const menu_entry_t* menu_selected(const menu_t* menu)
+{
+    if (menu->entries.empty())
+    {
+        return NULL;
+    }
+    return &menu->entries[menu->selected];
+}
+
+static void draw_row(menu_t* menu, uint8_t row)
+{
+    int16_t x = menu->x;
+    int16_t y = menu->y + (row * menu->row_height);
+    uint16_t entry = menu->first_visible + row;
+
+    display->fillRect(x, y, menu->width, menu->row_height, MONOOLED_BLACK);
+    if (entry >= menu->entries.size())
+    {
+        return;
+    }
+
+    display->setTextColor(MONOOLED_WHITE);
+    display->setCursor(
+        x+entry_margin+entry_border+entry_pad,
+        y+entry_margin+entry_border+entry_pad);
+    display->print(menu->entries[entry].name);
+
+    // Only reserve room for the scroll markers when the list can scroll
+    int16_t marker_width = 0;
+    if (menu->entries.size() > menu->visible_rows)
+    {
+        marker_width = scroll_marker_width;
+    }
+
+    if (entry == menu->selected)
+    {
+        display->drawRect(
+            x+entry_margin,
+            y+entry_margin,
+            menu->width-(2*entry_pad)-(entry_margin*2)-marker_width,
+            menu->row_height-(2*entry_pad)-(entry_margin*2),
+            MONOOLED_WHITE);
+    }
+
+    // Scroll markers live in the first and last rows
+    int16_t marker_x = x + menu->width - marker_width;
+    if ((row == 0) && (menu->first_visible > 0))
+    {
+        display->drawChar(marker_x, y+entry_margin+entry_border+entry_pad,
+                          scroll_up_icon, MONOOLED_WHITE, MONOOLED_BLACK, 1);
+    }
+    if ((row == (menu->visible_rows - 1))
+        && ((menu->first_visible + menu->visible_rows) < menu->entries.size()))
+    {
+        display->drawChar(marker_x, y+entry_margin+entry_border+entry_pad,
+                          scroll_down_icon, MONOOLED_WHITE, MONOOLED_BLACK, 1);
+    }
+}
+
+bool menu_draw(menu_t* menu)
+{
+    if (menu->dirty_rows == 0)
+    {
+        return false;
+    }
+
+    for (uint8_t row = 0; row < menu->visible_rows; ++row)
+    {
+        if (menu->dirty_rows & (1UL << row))
+        {
+            draw_row(menu, row);
+        }
+    }
+    menu->dirty_rows = 0;
+    return true;
+}
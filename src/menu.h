@@ -0,0 +1,50 @@
+#ifndef MENU_H_
+#define MENU_H_
+
+#include "renderer.h"
+
+#include <stdint.h>
+#include <vector>
+
+// One dirty bit per visible row, menu_init clamps visible_rows to this
+#define MENU_MAX_ROWS 32
+
+typedef struct {
+    render_function_t state;
+    const char* name;
+} menu_entry_t;
+
+// Retained menu widget. Each visible row is a slot that is only redrawn
+// when it has been invalidated, either by a selection change or a scroll.
+typedef struct {
+    std::vector<menu_entry_t> entries;
+    int16_t x;
+    int16_t y;
+    int16_t width;
+    int16_t row_height;
+    uint8_t visible_rows;
+    uint16_t selected;
+    uint16_t first_visible;
+    uint32_t dirty_rows;
+} menu_t;
+
+void menu_init(menu_t* menu,
+               int16_t x,
+               int16_t y,
+               int16_t width,
+               int16_t row_height,
+               uint8_t visible_rows);
+void menu_add(menu_t* menu, const char* name, render_function_t state);
+void menu_clear(menu_t* menu);
+
+// Mark every visible row for redraw
+void menu_invalidate(menu_t* menu);
+
+// Move the selection, wrapping around and scrolling as needed
+void menu_move(menu_t* menu, int8_t direction);
+const menu_entry_t* menu_selected(const menu_t* menu);
+
+// Redraw invalidated rows only, returns false if nothing was drawn
+bool menu_draw(menu_t* menu);
+
+#endif // MENU_H_
@@ -0,0 +1,199 @@
+#include "mirror.h"
+
+#ifdef CIPHERPAL_MIRROR
+
+#include "display.h"
+#include "protocol.h"
+#include "utility.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define HEADER_BYTES 9
+#define TOKEN_MAX 128
+#define BUDGET_CHECK_MASK 63
+// Literals run through single unchanged bytes, so every skip token covers
+// at least two bytes and a payload never outgrows a raw frame by more
+// than a token per 128 bytes
+#define PAYLOAD_MAX (FRAME_BYTES + (FRAME_BYTES / TOKEN_MAX) + 2)
+#define PACKET_MAX (HEADER_BYTES + PAYLOAD_MAX + 1)
+
+typedef struct
+{
+    uint8_t previous[FRAME_BYTES] __attribute__((aligned(4)));
+    uint8_t packet[PACKET_MAX];
+    uint16_t length;
+    uint16_t written;
+    uint16_t sequence;
+    bool keyframe;
+    bool suspended;
+    mirror_stats_t stats;
+} mirror_t;
+
+static mirror_t mirror = { {0}, {0}, 0, 0, 0, true, false, {0, 0, 0, 0, 0} };
+
+static inline uint8_t delta_at(const uint8_t* frame, uint16_t i)
+{
+    return mirror.keyframe ? frame[i] : (frame[i] ^ mirror.previous[i]);
+}
+
+// Returns the payload length, 0 when nothing changed, -1 over budget
+static int16_t encode(const uint8_t* frame, uint32_t start)
+{
+    uint8_t* out = &mirror.packet[HEADER_BYTES];
+    uint16_t pos = 0;
+    uint16_t skip = 0;
+    uint16_t i = 0;
+    while (i < FRAME_BYTES)
+    {
+        if (((i & BUDGET_CHECK_MASK) == 0) && ((micros() - start) > MIRROR_BUDGET_US))
+        {
+            return -1;
+        }
+
+        // Unchanged words are skipped four bytes at a time
+        if (!mirror.keyframe && ((i & 3) == 0)
+            && (*(const uint32_t*)&frame[i] == *(const uint32_t*)&mirror.previous[i]))
+        {
+            skip += 4;
+            i += 4;
+            continue;
+        }
+        if (delta_at(frame, i) == 0)
+        {
+            ++skip;
+            ++i;
+            continue;
+        }
+
+        if ((pos + skip / TOKEN_MAX + 2) >= PAYLOAD_MAX)
+        {
+            return -1;
+        }
+
+        // Skips are only written once something follows them
+        while (skip > 0)
+        {
+            uint16_t n = min(skip, (uint16_t)TOKEN_MAX);
+            out[pos++] = 0x80 | (n - 1);
+            skip -= n;
+        }
+
+        uint16_t count_at = pos++;
+        uint16_t n = 0;
+        while ((i < FRAME_BYTES) && (n < TOKEN_MAX))
+        {
+            if ((delta_at(frame, i) == 0)
+                && (((i + 1) >= FRAME_BYTES) || (delta_at(frame, i + 1) == 0)))
+            {
+                break;
+            }
+            out[pos++] = delta_at(frame, i);
+            ++n;
+            ++i;
+        }
+        out[count_at] = n - 1;
+    }
+    return pos;
+}
+
+void mirror_frame(const uint8_t* frame)
+{
+    if (mirror.suspended)
+    {
+        return;
+    }
+    // A reply on its way out is not split by a packet
+    if ((mirror.written < mirror.length) || protocol_reply_pending())
+    {
+        ++mirror.stats.dropped;
+        return;
+    }
+
+    uint32_t start = micros();
+    if ((mirror.sequence % MIRROR_KEYFRAME_INTERVAL) == 0)
+    {
+        mirror.keyframe = true;
+    }
+    int16_t payload = encode(frame, start);
+    mirror.stats.encode_us = micros() - start;
+    if (payload < 0)
+    {
+        ++mirror.stats.over_budget;
+        ++mirror.stats.dropped;
+        return;
+    }
+    if ((payload == 0) && !mirror.keyframe)
+    {
+        return;
+    }
+
+    uint8_t* header = mirror.packet;
+    header[0] = 0x00;
+    header[1] = 'M';
+    header[2] = 'I';
+    header[3] = 'R';
+    header[4] = mirror.keyframe ? 'K' : 'D';
+    header[5] = mirror.sequence & 0xFF;
+    header[6] = mirror.sequence >> 8;
+    header[7] = payload & 0xFF;
+    header[8] = payload >> 8;
+    uint8_t sum = 0;
+    for (int16_t i = 0; i < payload; ++i)
+    {
+        sum += header[HEADER_BYTES + i];
+    }
+    mirror.packet[HEADER_BYTES + payload] = sum;
+
+    memcpy(mirror.previous, frame, FRAME_BYTES);
+    mirror.keyframe = false;
+    mirror.length = HEADER_BYTES + payload + 1;
+    mirror.written = 0;
+    ++mirror.sequence;
+    ++mirror.stats.sent;
+    mirror_service();
+}
+
+void mirror_service()
+{
+    if (mirror.written >= mirror.length)
+    {
+        return;
+    }
+    int available = Serial.availableForWrite();
+    if (available <= 0)
+    {
+        return;
+    }
+    uint16_t n = min((uint16_t)available, (uint16_t)(mirror.length - mirror.written));
+    n = Serial.write(&mirror.packet[mirror.written], n);
+    mirror.written += n;
+    mirror.stats.bytes += n;
+}
+
+bool mirror_active()
+{
+    return (mirror.written < mirror.length) || Serial;
+}
+
+bool mirror_busy()
+{
+    return mirror.written < mirror.length;
+}
+
+void mirror_suspend(bool suspend)
+{
+    if (mirror.suspended && !suspend)
+    {
+        // The viewer's previous frame is stale by now
+        mirror.keyframe = true;
+    }
+    mirror.suspended = suspend;
+}
+
+const mirror_stats_t* mirror_stats()
+{
+    return &mirror.stats;
+}
+
+#endif // CIPHERPAL_MIRROR
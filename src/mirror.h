@@ -0,0 +1,57 @@
+#ifndef MIRROR_H_
+#define MIRROR_H_
+
+#include <stdint.h>
+
+// Screen mirror over Serial, built only in the mirror environment
+// (pio run -e adafruit_feather_m0_mirror). Every frame sent to the panel
+// is XORed against the last mirrored frame and run length encoded into a
+// packet, Log() text keeps flowing in between:
+//
+//   0x00 'M' 'I' 'R'  type ('K' keyframe, 'D' delta)
+//   sequence (u16 LE)  payload length (u16 LE)  payload  sum of payload (u8)
+//
+// Payload tokens: 0x80 | (n - 1) skips n unchanged bytes, n - 1 < 0x80 is
+// followed by n bytes to XOR in. Keyframes are deltas against a blank
+// frame. Trailing unchanged bytes are not sent.
+//
+// Encoding stops at MIRROR_BUDGET_US and a frame is dropped while the
+// previous packet or a protocol reply is still draining, so render()
+// never waits on the port. Replies wait for a packet in flight.
+// A Log() line landing inside a packet breaks its checksum, the viewer
+// then waits for the next keyframe. tools/mirror_view.py decodes the
+// stream.
+
+#define MIRROR_BUDGET_US 1500
+#define MIRROR_KEYFRAME_INTERVAL 64
+
+typedef struct
+{
+    uint32_t sent;
+    uint32_t dropped;
+    uint32_t over_budget;
+    uint32_t bytes;
+    uint32_t encode_us;
+} mirror_stats_t;
+
+#ifdef CIPHERPAL_MIRROR
+void mirror_frame(const uint8_t* frame);
+// Write as much of the pending packet as the port takes without blocking
+void mirror_service();
+const mirror_stats_t* mirror_stats();
+// A packet is draining or a host has the port open
+bool mirror_active();
+// A packet has been started and is not fully written yet
+bool mirror_busy();
+// While suspended no packet is started, the one in flight still drains.
+// The first packet after resuming is a keyframe.
+void mirror_suspend(bool suspend);
+#else
+inline void mirror_frame(const uint8_t* frame) { (void)frame; }
+inline void mirror_service() {}
+inline bool mirror_active() { return false; }
+inline bool mirror_busy() { return false; }
+inline void mirror_suspend(bool suspend) { (void)suspend; }
+#endif
+
+#endif // MIRROR_H_
@@ -0,0 +1,212 @@
+#include "particles.h"
+
+#include "renderer.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Outward speed per pixel of distance from the scatter point
+#define SCATTER_GAIN 12
+#define SCATTER_JITTER 0x1FF
+#define SCATTER_LIFT (Q8_8_ONE)
+#define GRAVITY 10
+#define DRAG_SHIFT 5
+// Spring stiffness 1/16 and damping 1/4 per step, slightly underdamped
+#define SPRING_SHIFT 4
+#define DAMP_SHIFT 2
+#define SETTLE_DISTANCE (Q8_8_ONE / 2)
+#define SETTLE_SPEED (Q8_8_ONE / 8)
+#define DISPLACEMENT_MAX INT_TO_Q8_8(127)
+
+typedef struct
+{
+    uint8_t bits[PARTICLE_MAX];
+    q8_8_t x[PARTICLE_MAX];
+    q8_8_t y[PARTICLE_MAX];
+    q8_8_t vx[PARTICLE_MAX];
+    q8_8_t vy[PARTICLE_MAX];
+    uint16_t count;
+    // Pages drawn into by the last particles_draw
+    uint16_t pages;
+} particle_pool_t;
+
+static particle_pool_t pool;
+static uint32_t random_state = 0x2545F491;
+
+// xorshift32, cheap enough to call per particle
+static inline uint32_t next_random()
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static inline q8_8_t saturate(int32_t v)
+{
+    if (v > DISPLACEMENT_MAX)
+    {
+        return DISPLACEMENT_MAX;
+    }
+    if (v < -DISPLACEMENT_MAX)
+    {
+        return -DISPLACEMENT_MAX;
+    }
+    return (q8_8_t)v;
+}
+
+uint16_t particles_capture(const uint8_t* buffer)
+{
+    memcpy(pool.bits, buffer, PARTICLE_MAX);
+    memset(pool.x, 0, sizeof(pool.x));
+    memset(pool.y, 0, sizeof(pool.y));
+    memset(pool.vx, 0, sizeof(pool.vx));
+    memset(pool.vy, 0, sizeof(pool.vy));
+
+    pool.count = 0;
+    pool.pages = 0;
+    for (uint16_t i = 0; i < PARTICLE_MAX; ++i)
+    {
+        if (pool.bits[i] != 0)
+        {
+            ++pool.count;
+            pool.pages |= 1 << (i & (BYTES_PER_LINE - 1));
+        }
+    }
+    return pool.count;
+}
+
+void particles_scatter(int16_t x, int16_t y)
+{
+    for (uint16_t i = 0; i < PARTICLE_MAX; ++i)
+    {
+        if (pool.bits[i] == 0)
+        {
+            continue;
+        }
+        int16_t dx = (int16_t)((i & (BYTES_PER_LINE - 1)) * 8 + 4) - x;
+        int16_t dy = (int16_t)(i / BYTES_PER_LINE) - y;
+        uint32_t r = next_random();
+        pool.vx[i] = (dx * SCATTER_GAIN) + (int16_t)(r & SCATTER_JITTER) - (SCATTER_JITTER / 2);
+        pool.vy[i] = (dy * SCATTER_GAIN) + (int16_t)((r >> 16) & SCATTER_JITTER) - (SCATTER_JITTER / 2) - SCATTER_LIFT;
+    }
+}
+
+void particles_step_free()
+{
+    for (uint16_t i = 0; i < PARTICLE_MAX; ++i)
+    {
+        if (pool.bits[i] == 0)
+        {
+            continue;
+        }
+        int16_t vx = pool.vx[i];
+        int16_t vy = pool.vy[i] + GRAVITY;
+        vx -= vx >> DRAG_SHIFT;
+        vy -= vy >> DRAG_SHIFT;
+        pool.vx[i] = vx;
+        pool.vy[i] = vy;
+        pool.x[i] = saturate((int32_t)pool.x[i] + vx);
+        pool.y[i] = saturate((int32_t)pool.y[i] + vy);
+    }
+}
+
+bool particles_step_home()
+{
+    bool settled = true;
+    for (uint16_t i = 0; i < PARTICLE_MAX; ++i)
+    {
+        if (pool.bits[i] == 0)
+        {
+            continue;
+        }
+        // Semi-implicit Euler, shifts only as there is no divider
+        int16_t x = pool.x[i];
+        int16_t y = pool.y[i];
+        int16_t vx = pool.vx[i] - (x >> SPRING_SHIFT);
+        int16_t vy = pool.vy[i] - (y >> SPRING_SHIFT);
+        vx -= vx >> DAMP_SHIFT;
+        vy -= vy >> DAMP_SHIFT;
+        x = saturate((int32_t)x + vx);
+        y = saturate((int32_t)y + vy);
+
+        if ((abs(x) < SETTLE_DISTANCE) && (abs(y) < SETTLE_DISTANCE) &&
+            (abs(vx) < SETTLE_SPEED) && (abs(vy) < SETTLE_SPEED))
+        {
+            x = y = vx = vy = 0;
+        }
+        else
+        {
+            settled = false;
+        }
+        pool.x[i] = x;
+        pool.y[i] = y;
+        pool.vx[i] = vx;
+        pool.vy[i] = vy;
+    }
+    return settled;
+}
+
+void particles_draw(uint8_t* buffer)
+{
+    uint32_t* words = (uint32_t*)buffer;
+    memset(buffer, 0, FRAME_BYTES);
+
+    uint16_t pages = 0;
+    for (uint16_t i = 0; i < PARTICLE_MAX; ++i)
+    {
+        uint32_t bits = pool.bits[i];
+        if (bits == 0)
+        {
+            continue;
+        }
+        // Floor of the Q8.8 displacement plus the home position
+        int16_t y = (int16_t)(i / BYTES_PER_LINE) + (pool.y[i] >> 8);
+        if ((y < 0) || (y >= LCD_HEIGHT))
+        {
+            continue;
+        }
+        int16_t x = (int16_t)((i & (BYTES_PER_LINE - 1)) * 8) + (pool.x[i] >> 8);
+        if ((x <= -8) || (x >= LCD_WIDTH))
+        {
+            continue;
+        }
+
+        uint32_t* row = &words[y * WORDS_PER_LINE];
+        if (x < 0)
+        {
+            row[0] |= bits >> -x;
+            pages |= 1;
+            continue;
+        }
+        uint8_t word = x >> 5;
+        uint8_t shift = x & 31;
+        row[word] |= bits << shift;
+        if ((shift > 24) && (word < (WORDS_PER_LINE - 1)))
+        {
+            row[word + 1] |= bits >> (32 - shift);
+        }
+        pages |= 1 << (x >> 3);
+        if ((x & 7) && (x < (LCD_WIDTH - 8)))
+        {
+            pages |= 1 << ((x >> 3) + 1);
+        }
+    }
+
+    // Pages that held particles last frame need flushing too, now blank
+    uint16_t dirty = pages | pool.pages;
+    pool.pages = pages;
+    for (uint8_t page = 0; page < DISPLAY_PAGES; ++page)
+    {
+        if (dirty & (1 << page))
+        {
+            render_invalidate(page * 8, 8);
+        }
+    }
+}
+
+uint16_t particles_count()
+{
+    return pool.count;
+}
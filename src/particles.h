@@ -0,0 +1,41 @@
+#ifndef PARTICLES_H_
+#define PARTICLES_H_
+
+#include "display.h"
+
+#include <stdint.h>
+
+// Frame buffer fragments as particles. Every byte of the row-major frame
+// (8 horizontal pixels) is one particle whose home is where the byte came
+// from, so the pool is indexed by frame byte and empty bytes are skipped.
+// Positions are displacements from home and, like velocities, Q8.8 fixed
+// point. Storage is struct-of-arrays in a static pool.
+//
+// The pool size is fixed by that indexing, not by RAM: a frame has 1024
+// bytes so there are at most 1024 fragments, 9 bytes each (9 KB).
+
+#define PARTICLE_MAX FRAME_BYTES
+
+typedef int16_t q8_8_t;
+
+#define Q8_8_ONE (256)
+#define INT_TO_Q8_8(x) ((q8_8_t)((x) * Q8_8_ONE))
+
+// Break buffer into particles at rest, returns the number of fragments
+uint16_t particles_capture(const uint8_t* buffer);
+
+// Launch every particle away from (x, y)
+void particles_scatter(int16_t x, int16_t y);
+
+// Ballistic step with gravity and drag
+void particles_step_free();
+
+// Spring every particle back home, returns true once all have settled
+bool particles_step_home();
+
+// Clear buffer, plot every particle and invalidate the pages that changed
+void particles_draw(uint8_t* buffer);
+
+uint16_t particles_count();
+
+#endif // PARTICLES_H_
@@ -0,0 +1,291 @@
+#include "power.h"
+
+#include "buttons.h"
+#include "grayscale.h"
+#include "mirror.h"
+#include "profiler.h"
+#include "renderer.h"
+#include "stall.h"
+
+#include <Arduino.h>
+#include <stdint.h>
+
+// Generator for the RTC and, in standby, the EIC: OSCULP32K / 32, the
+// only oscillator guaranteed to keep running in standby
+#define POWER_GCLK 4
+#define RTC_HZ 1024
+
+static const uint8_t wake_pins[] = { BUTTON_UP, BUTTON_SEL, BUTTON_DN };
+
+typedef struct
+{
+    power_state_t state;
+    uint32_t state_since;
+    uint32_t last_activity;
+    uint32_t dim_ms;
+    uint32_t standby_ms;
+    uint8_t saved_brightness;
+    bool inhibited;
+    // Set by power_activity() until the next service
+    bool activity;
+    bool wake_pending;
+    uint32_t wake_frame;
+    uint32_t wake_start_us;
+    power_stats_t stats;
+} power_t;
+
+static power_t power;
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+static volatile bool woken = false;
+
+static void gclk_sync()
+{
+    while (GCLK->STATUS.bit.SYNCBUSY);
+}
+
+static void rtc_sync()
+{
+    while (RTC->MODE0.STATUS.bit.SYNCBUSY);
+}
+
+static void rtc_begin()
+{
+    // DIVSEL divides by 2^(DIV + 1)
+    GCLK->GENDIV.reg = GCLK_GENDIV_ID(POWER_GCLK) | GCLK_GENDIV_DIV(4);
+    gclk_sync();
+    GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(POWER_GCLK)
+                      | GCLK_GENCTRL_SRC_OSCULP32K
+                      | GCLK_GENCTRL_DIVSEL
+                      | GCLK_GENCTRL_RUNSTDBY
+                      | GCLK_GENCTRL_GENEN;
+    gclk_sync();
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_RTC
+                      | GCLK_CLKCTRL_GEN(POWER_GCLK)
+                      | GCLK_CLKCTRL_CLKEN;
+    gclk_sync();
+
+    PM->APBAMASK.reg |= PM_APBAMASK_RTC;
+    RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_SWRST;
+    while (RTC->MODE0.CTRL.bit.SWRST);
+    RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_MODE_COUNT32
+                        | RTC_MODE0_CTRL_PRESCALER_DIV1;
+    rtc_sync();
+    RTC->MODE0.CTRL.reg |= RTC_MODE0_CTRL_ENABLE;
+    rtc_sync();
+}
+
+static uint32_t rtc_ticks()
+{
+    RTC->MODE0.READREQ.reg = RTC_READREQ_RREQ;
+    rtc_sync();
+    return RTC->MODE0.COUNT.reg;
+}
+
+static void on_wake()
+{
+    // Level interrupts keep firing while the button is held
+    EIC->INTENCLR.reg = EIC_INTENCLR_MASK;
+    woken = true;
+}
+
+// Returns the time spent asleep in ms
+static uint32_t sleep_until_button()
+{
+    uint32_t start = rtc_ticks();
+
+    woken = false;
+    for (uint8_t i = 0; i < sizeof(wake_pins); ++i)
+    {
+        attachInterrupt(wake_pins[i], on_wake, LOW);
+        EIC->WAKEUP.reg |= 1u << g_APinDescription[wake_pins[i]].ulExtInt;
+    }
+    // The core clocks the EIC from the main clock, which stops in standby
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_EIC
+                      | GCLK_CLKCTRL_GEN(POWER_GCLK)
+                      | GCLK_CLKCTRL_CLKEN;
+    gclk_sync();
+
+    // Errata: the NVM must not power down in sleep, and a pending SysTick
+    // keeps the core from entering standby
+    NVMCTRL->CTRLB.bit.SLEEPPRM = NVMCTRL_CTRLB_SLEEPPRM_DISABLED_Val;
+    SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    while (!woken)
+    {
+        __DSB();
+        __WFI();
+    }
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+
+    for (uint8_t i = 0; i < sizeof(wake_pins); ++i)
+    {
+        detachInterrupt(wake_pins[i]);
+        EIC->WAKEUP.reg &= ~(1u << g_APinDescription[wake_pins[i]].ulExtInt);
+        pinMode(wake_pins[i], INPUT_PULLUP);
+    }
+
+    uint32_t ticks = rtc_ticks() - start;
+    return (uint32_t)(((uint64_t)ticks * 1000) / RTC_HZ);
+}
+
+#else
+
+static void rtc_begin()
+{
+}
+
+// No standby off the SAMD21, poll until a button goes down
+static uint32_t sleep_until_button()
+{
+    uint32_t start = millis();
+    do
+    {
+        scan_buttons();
+        yield();
+    } while (get_buttons() == BUTTON_ALL_MASK);
+    return millis() - start;
+}
+
+#endif
+
+static void enter_state(power_state_t state, uint32_t now)
+{
+    power.stats.ms[power.state] += now - power.state_since;
+    power.state = state;
+    power.state_since = now;
+}
+
+static bool busy()
+{
+    // Our own dim fade does not count
+    return power.inhibited
+        || profiler_running()
+        || mirror_active()
+        || grayscale_active()
+        || render_transitioning()
+        || (render_fading() && (power.state == POWER_ACTIVE));
+}
+
+static void standby()
+{
+    enter_state(POWER_STANDBY, millis());
+    render_set_visible(false);
+    stall_pause(true);
+
+    uint32_t slept_ms = sleep_until_button();
+    power.wake_start_us = micros();
+
+    suppress_buttons();
+    // Panel off until it shows exactly the frame it showed before
+    display->mark_all_dirty();
+    display->display();
+    render_set_brightness(power.saved_brightness);
+    render_set_visible(true);
+    render_resume();
+    stall_pause(false);
+
+    // millis() stood still, standby is accounted from the RTC
+    uint32_t now = millis();
+    power.stats.ms[POWER_STANDBY] += slept_ms;
+    power.state = POWER_ACTIVE;
+    power.state_since = now;
+    power.last_activity = now;
+    ++power.stats.wakes;
+    power.wake_pending = true;
+    power.wake_frame = render_frame_count();
+}
+
+void power_init()
+{
+    rtc_begin();
+    power.state = POWER_ACTIVE;
+    power.state_since = millis();
+    power.last_activity = power.state_since;
+    power.dim_ms = POWER_DIM_MS;
+    power.standby_ms = POWER_STANDBY_MS;
+}
+
+void power_set_timeouts(uint32_t dim_ms, uint32_t standby_ms)
+{
+    power.dim_ms = dim_ms;
+    power.standby_ms = standby_ms;
+    power.last_activity = millis();
+}
+
+void power_inhibit(bool inhibit)
+{
+    power.inhibited = inhibit;
+}
+
+void power_activity()
+{
+    power.activity = true;
+}
+
+power_state_t power_state()
+{
+    return power.state;
+}
+
+const power_stats_t* power_stats()
+{
+    enter_state(power.state, millis());
+    return &power.stats;
+}
+
+void power_service()
+{
+    uint32_t now = millis();
+
+    if (power.wake_pending && (render_frame_count() != power.wake_frame))
+    {
+        uint32_t us = micros() - power.wake_start_us;
+        power.stats.wake_us = us;
+        if (us > power.stats.wake_us_max)
+        {
+            power.stats.wake_us_max = us;
+        }
+        if (us > POWER_WAKE_TARGET_US)
+        {
+            ++power.stats.wakes_late;
+        }
+        power.wake_pending = false;
+    }
+
+    bool activity = power.activity;
+    power.activity = false;
+    if ((get_buttons() != BUTTON_ALL_MASK) || activity || busy())
+    {
+        power.last_activity = now;
+        if (power.state == POWER_DIM)
+        {
+            render_fade_to(power.saved_brightness, POWER_UNDIM_FADE_MS);
+            enter_state(POWER_ACTIVE, now);
+        }
+        return;
+    }
+
+    uint32_t idle = now - power.last_activity;
+    if ((power.state == POWER_ACTIVE)
+        && (power.dim_ms > 0)
+        && (idle >= power.dim_ms)
+        && ((power.standby_ms == 0) || (power.dim_ms < power.standby_ms)))
+    {
+        power.saved_brightness = render_brightness();
+        render_fade_to(POWER_DIM_BRIGHTNESS, POWER_DIM_FADE_MS);
+        enter_state(POWER_DIM, now);
+    }
+    else if ((power.standby_ms > 0)
+             && (idle >= power.standby_ms)
+             && !render_fading())
+    {
+        if (power.state == POWER_ACTIVE)
+        {
+            power.saved_brightness = render_brightness();
+        }
+        standby();
+    }
+}
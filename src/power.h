@@ -0,0 +1,57 @@
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <stdint.h>
+
+// Idle policy, serviced from loop() after render(). With no button held
+// and no valid protocol frame for POWER_DIM_MS the contrast fades down, after POWER_STANDBY_MS the
+// SH1107 is put to sleep and the SAMD21 enters standby with the buttons as
+// wake sources. RAM survives standby, so on wake the retained frame is
+// sent while the panel is still off and the state on top of the render
+// stack carries on where it stopped; millis() does not advance in standby.
+// The press that wakes the device is not passed on.
+//
+// USB is stopped in standby, a host terminal sees the port drop. Standby
+// is held off while the profiler runs or the mirror streams, as it would
+// cut off the host reading them.
+
+#define POWER_DIM_MS 20000
+#define POWER_STANDBY_MS 30000
+#define POWER_DIM_BRIGHTNESS 0x08
+#define POWER_DIM_FADE_MS 1000
+#define POWER_UNDIM_FADE_MS 150
+// Wake to first rendered frame, includes resending the whole frame
+#define POWER_WAKE_TARGET_US 40000
+
+typedef enum
+{
+    POWER_ACTIVE = 0,
+    POWER_DIM,
+    POWER_STANDBY,
+    POWER_STATES
+} power_state_t;
+
+typedef struct
+{
+    // Time spent in each power_state_t, standby is timed by the RTC
+    uint32_t ms[POWER_STATES];
+    uint32_t wakes;
+    uint32_t wake_us;
+    uint32_t wake_us_max;
+    // Wakes that missed POWER_WAKE_TARGET_US
+    uint32_t wakes_late;
+} power_stats_t;
+
+void power_init();
+void power_service();
+
+// Either may be 0, dim_ms 0 skips dimming, standby_ms 0 never sleeps
+void power_set_timeouts(uint32_t dim_ms, uint32_t standby_ms);
+// States that must keep running untouched hold the device awake
+void power_inhibit(bool inhibit);
+// Input other than the buttons, e.g. a frame from the host
+void power_activity();
+power_state_t power_state();
+const power_stats_t* power_stats();
+
+#endif // POWER_H_
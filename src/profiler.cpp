@@ -0,0 +1,172 @@
+#include "profiler.h"
+
+#ifdef CIPHERPAL_PROFILE
+
+#include "utility.h"
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TIMER_PRESCALER 16
+// Multiplicative hash, the top 9 bits of the 16 bit product pick the slot
+#define HASH_MULTIPLIER 40503u
+#define HASH_SHIFT 7
+#define SLOT_MASK (PROFILER_SLOTS - 1)
+
+typedef struct
+{
+    profiler_slot_t slots[PROFILER_SLOTS];
+    profiler_stats_t stats;
+    volatile bool running;
+} profiler_t;
+
+static profiler_t profiler;
+
+static inline void sample(uint32_t pc)
+{
+    ++profiler.stats.samples;
+    if (pc >= PROFILER_FLASH_BYTES)
+    {
+        ++profiler.stats.outside;
+        return;
+    }
+
+    uint16_t bin = pc >> PROFILER_BIN_SHIFT;
+    uint16_t index = (uint16_t)(bin * HASH_MULTIPLIER) >> HASH_SHIFT;
+    for (uint8_t probe = 0; probe < PROFILER_PROBES; ++probe)
+    {
+        profiler_slot_t* slot = &profiler.slots[(index + probe) & SLOT_MASK];
+        if (slot->count == 0)
+        {
+            slot->bin = bin;
+        }
+        else if (slot->bin != bin)
+        {
+            continue;
+        }
+        if (slot->count == 0xFFFF)
+        {
+            break;
+        }
+        ++slot->count;
+        return;
+    }
+    ++profiler.stats.dropped;
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+static void gclk_sync()
+{
+    while (GCLK->STATUS.bit.SYNCBUSY);
+}
+
+static void tc_sync()
+{
+    while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+static void timer_start(uint16_t hz)
+{
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TCC2_TC3
+                      | GCLK_CLKCTRL_GEN_GCLK0
+                      | GCLK_CLKCTRL_CLKEN;
+    gclk_sync();
+    PM->APBCMASK.reg |= PM_APBCMASK_TC3;
+
+    TC3->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+    while (TC3->COUNT16.CTRLA.bit.SWRST);
+    TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16
+                           | TC_CTRLA_WAVEGEN_MFRQ
+                           | TC_CTRLA_PRESCALER_DIV16;
+    TC3->COUNT16.CC[0].reg = (F_CPU / TIMER_PRESCALER / hz) - 1;
+    tc_sync();
+    TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+    TC3->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+
+    // Below the stall watchdog only, so handlers are sampled too
+    NVIC_ClearPendingIRQ(TC3_IRQn);
+    NVIC_SetPriority(TC3_IRQn, 1);
+    NVIC_EnableIRQ(TC3_IRQn);
+
+    TC3->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+    tc_sync();
+}
+
+static void timer_stop()
+{
+    TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    tc_sync();
+    NVIC_DisableIRQ(TC3_IRQn);
+}
+
+// frame is the exception frame the core pushed: r0-r3, r12, lr, pc, xPSR
+extern "C" void profiler_sample(const uint32_t* frame)
+{
+    TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+    sample(frame[6]);
+}
+
+// Only the main stack is in use, so sp points at the exception frame
+extern "C" __attribute__((naked)) void TC3_Handler()
+{
+    __asm__ volatile(
+        "mov r0, sp\n"
+        "ldr r1, =profiler_sample\n"
+        "bx r1\n");
+}
+
+#else
+
+// No sample timer off the SAMD21, the histogram stays empty
+static void timer_start(uint16_t hz)
+{
+    UNUSED(hz);
+}
+
+static void timer_stop()
+{
+}
+
+#endif
+
+uint16_t profiler_start(uint16_t hz)
+{
+    if (profiler.running)
+    {
+        profiler_stop();
+    }
+    hz = min(max(hz, (uint16_t)PROFILER_MIN_HZ), (uint16_t)PROFILER_MAX_HZ);
+    memset(&profiler.slots, 0, sizeof(profiler.slots));
+    memset(&profiler.stats, 0, sizeof(profiler.stats));
+    profiler.running = true;
+    timer_start(hz);
+    return hz;
+}
+
+void profiler_stop()
+{
+    if (profiler.running)
+    {
+        timer_stop();
+        profiler.running = false;
+    }
+}
+
+bool profiler_running()
+{
+    return profiler.running;
+}
+
+const profiler_slot_t* profiler_slots()
+{
+    return profiler.slots;
+}
+
+const profiler_stats_t* profiler_stats()
+{
+    return &profiler.stats;
+}
+
+#endif // CIPHERPAL_PROFILE
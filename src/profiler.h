@@ -0,0 +1,59 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+
+// Statistical PC sampling profiler, built only in the profile environment
+// (pio run -e adafruit_feather_m0_profile). TC3 interrupts at the sample
+// rate and the interrupted PC, taken from the exception frame, is counted
+// in a small open addressed histogram keyed by flash bin. The sample
+// handler is a few dozen cycles and takes no locks, so at 1 kHz it costs
+// well under a percent of the core.
+//
+// Samples are counted per 32 byte bin of flash rather than per word, a
+// run touches far fewer bins than words so the table does not fill and
+// drop new PCs, at the cost of a bin straddling two small functions.
+//
+// Started, stopped and read through the command protocol (protocol.h);
+// tools/profile.py does that and maps the bins to functions with the
+// firmware ELF.
+
+#define PROFILER_SLOTS 512
+// Bin is PC >> PROFILER_BIN_SHIFT
+#define PROFILER_BIN_SHIFT 5
+// Collisions looked at before a sample is dropped
+#define PROFILER_PROBES 8
+#define PROFILER_DEFAULT_HZ 1000
+#define PROFILER_MIN_HZ 100
+#define PROFILER_MAX_HZ 10000
+#define PROFILER_FLASH_BYTES 0x40000UL
+
+typedef struct
+{
+    // PC >> PROFILER_BIN_SHIFT
+    uint16_t bin;
+    // 0 for an empty slot
+    uint16_t count;
+} profiler_slot_t;
+
+typedef struct
+{
+    uint32_t samples;
+    // Samples that found the histogram full or their count saturated
+    uint32_t dropped;
+    // Samples outside flash
+    uint32_t outside;
+} profiler_stats_t;
+
+#ifdef CIPHERPAL_PROFILE
+// Clears the histogram, returns the rate in effect
+uint16_t profiler_start(uint16_t hz);
+void profiler_stop();
+bool profiler_running();
+const profiler_slot_t* profiler_slots();
+const profiler_stats_t* profiler_stats();
+#else
+inline bool profiler_running() { return false; }
+#endif
+
+#endif // PROFILER_H_
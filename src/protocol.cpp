@@ -0,0 +1,535 @@
+#include "protocol.h"
+
+#include "display.h"
+#include "mirror.h"
+#include "power.h"
+#include "profiler.h"
+#include "renderer.h"
+#include "stall.h"
+#include "utility.h"
+#include "render_states/buffer_deconstruct.h"
+#include "render_states/cipher_stream.h"
+#include "render_states/clip_player.h"
+#include "render_states/crypto_unlock.h"
+#include "render_states/grayscale_demo.h"
+#include "render_states/log_ticker.h"
+#include "render_states/main_menu.h"
+#include "render_states/register_read.h"
+#include "render_states/self_test.h"
+#include "render_states/splash_screen.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// sync, type, sequence, length
+#define HEADER_BYTES 5
+#define CRC_BYTES 2
+#define FRAME_MAX (HEADER_BYTES + PROTOCOL_PAYLOAD_MAX + CRC_BYTES)
+#define CRC_INIT 0xFFFF
+
+typedef enum
+{
+    PARSE_SYNC0 = 0,
+    PARSE_SYNC1,
+    PARSE_TYPE,
+    PARSE_SEQUENCE,
+    PARSE_LENGTH,
+    PARSE_PAYLOAD,
+    PARSE_CRC_LOW,
+    PARSE_CRC_HIGH,
+} parse_state_t;
+
+typedef struct
+{
+    uint8_t state;
+    uint8_t type;
+    uint8_t sequence;
+    uint8_t length;
+    uint8_t received;
+    uint16_t crc;
+    uint16_t expected_crc;
+    uint8_t payload[PROTOCOL_PAYLOAD_MAX];
+} parser_t;
+
+typedef struct
+{
+    parser_t parser;
+    uint8_t reply[FRAME_MAX];
+    uint8_t reply_length;
+    uint8_t reply_written;
+    bool suspended;
+    uint32_t last_frame;
+    protocol_stats_t stats;
+} protocol_t;
+
+static protocol_t protocol;
+
+static const render_function_t states[PROTOCOL_STATES] = {
+    &main_menu_render,
+    &self_test_render,
+    &register_read_render,
+    &buffer_deconstruct_render,
+    &grayscale_demo_render,
+    &crypto_unlock_render,
+    &cipher_stream_render,
+    &splash_screen_render,
+    &clip_player_render,
+    &log_ticker_render,
+};
+
+// CRC-16/CCITT a nibble at a time, 32 bytes of table instead of 512
+static const uint16_t crc_nibbles[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+static inline uint16_t crc_byte(uint16_t crc, uint8_t value)
+{
+    crc = (crc << 4) ^ crc_nibbles[(crc >> 12) ^ (value >> 4)];
+    crc = (crc << 4) ^ crc_nibbles[(crc >> 12) ^ (value & 0x0F)];
+    return crc;
+}
+
+uint16_t protocol_crc(uint16_t crc, const uint8_t* data, uint16_t length)
+{
+    for (uint16_t i = 0; i < length; ++i)
+    {
+        crc = crc_byte(crc, data[i]);
+    }
+    return crc;
+}
+
+static inline void put_u32(uint8_t* out, uint32_t value)
+{
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = value >> 24;
+}
+
+static inline uint32_t get_u32(const uint8_t* in)
+{
+    return (uint32_t)in[0]
+        | ((uint32_t)in[1] << 8)
+        | ((uint32_t)in[2] << 16)
+        | ((uint32_t)in[3] << 24);
+}
+
+static void drain_reply()
+{
+    // One writer at a time, the mirror packet in flight finishes first
+    if ((protocol.reply_written >= protocol.reply_length) || mirror_busy())
+    {
+        return;
+    }
+    int available = Serial.availableForWrite();
+    if (available <= 0)
+    {
+        return;
+    }
+    // Clamped before narrowing, the USB CDC buffer can report 256 or more
+    uint8_t room = (uint8_t)min(available, 0xFF);
+    uint8_t n = min(room, (uint8_t)(protocol.reply_length - protocol.reply_written));
+    protocol.reply_written += Serial.write(&protocol.reply[protocol.reply_written], n);
+}
+
+// The reply payload is built in place after the header, status first
+static uint8_t* reply_payload()
+{
+    return &protocol.reply[HEADER_BYTES];
+}
+
+static void send_reply(uint8_t status, uint8_t length)
+{
+    uint8_t* frame = protocol.reply;
+    frame[0] = PROTOCOL_SYNC0;
+    frame[1] = PROTOCOL_SYNC1;
+    frame[2] = protocol.parser.type | PROTOCOL_REPLY;
+    frame[3] = protocol.parser.sequence;
+    frame[4] = length + 1;
+    frame[HEADER_BYTES] = status;
+    uint16_t crc = protocol_crc(CRC_INIT, &frame[2], HEADER_BYTES - 2 + length + 1);
+    frame[HEADER_BYTES + length + 1] = crc & 0xFF;
+    frame[HEADER_BYTES + length + 2] = crc >> 8;
+    protocol.reply_length = HEADER_BYTES + length + 1 + CRC_BYTES;
+    protocol.reply_written = 0;
+    drain_reply();
+}
+
+static void write_counters(uint8_t* out)
+{
+    const render_stats_t* render = render_stats();
+    const display_stats_t& flush = display->stats();
+    uint32_t values[PROTOCOL_COUNTERS];
+    values[PROTOCOL_COUNTER_FRAMES] = render->frames;
+    values[PROTOCOL_COUNTER_FRAME_US] = render->frame_us;
+    values[PROTOCOL_COUNTER_FRAME_US_MAX] = render->frame_us_max;
+    values[PROTOCOL_COUNTER_FRAME_US_AVG] = (render->frames > 0) ? (render->frame_us_total / render->frames) : 0;
+    values[PROTOCOL_COUNTER_FLUSHES] = flush.flushes;
+    values[PROTOCOL_COUNTER_FLUSHED_BYTES] = flush.flushed_bytes;
+    values[PROTOCOL_COUNTER_FLUSH_US] = display->flush_timing().total_us;
+    values[PROTOCOL_COUNTER_INPUT_EVENTS] = render->input_events;
+    values[PROTOCOL_COUNTER_RX_FRAMES] = protocol.stats.frames;
+    values[PROTOCOL_COUNTER_CRC_ERRORS] = protocol.stats.crc_errors;
+    values[PROTOCOL_COUNTER_SLICE_US_MAX] = protocol.stats.slice_us_max;
+    values[PROTOCOL_COUNTER_SLICE_US_AVG] = (protocol.stats.slices > 0)
+        ? (protocol.stats.slice_us_total / protocol.stats.slices) : 0;
+    values[PROTOCOL_COUNTER_UPTIME_MS] = millis();
+    values[PROTOCOL_COUNTER_STALLS] = stall_stats()->stalls;
+    values[PROTOCOL_COUNTER_LOOP_US_MAX] = stall_stats()->loop_us_max;
+    for (uint8_t i = 0; i < PROTOCOL_COUNTERS; ++i)
+    {
+        put_u32(&out[i * 4], values[i]);
+    }
+}
+
+static bool set_param(uint8_t param, uint32_t value)
+{
+    switch (param)
+    {
+    case PROTOCOL_PARAM_TARGET_FPS:
+        if (value > 0xFF)
+        {
+            return false;
+        }
+        render_set_target_fps((uint8_t)value);
+        return true;
+    case PROTOCOL_PARAM_LOG_MASK:
+        log_set_mask((uint8_t)value);
+        return true;
+    case PROTOCOL_PARAM_BRIGHTNESS:
+        if (value > 0xFF)
+        {
+            return false;
+        }
+        render_set_brightness((uint8_t)value);
+        return true;
+    case PROTOCOL_PARAM_BUS_HZ:
+        if ((value < I2C_STANDARD_HZ) || (value > I2C_FAST_PLUS_HZ))
+        {
+            return false;
+        }
+        // A slower clock makes every flush longer
+        stall_set_bus_hz(display->set_bus_speed(value));
+        return true;
+    case PROTOCOL_PARAM_STALL_MS:
+        stall_set_budget_ms(value);
+        return true;
+    case PROTOCOL_PARAM_CRYPTO_LEVEL:
+        if (value > 0xFF)
+        {
+            return false;
+        }
+        return crypto_unlock_set_level((uint8_t)value);
+    default:
+        return false;
+    }
+}
+
+static uint32_t get_param(uint8_t param)
+{
+    switch (param)
+    {
+    case PROTOCOL_PARAM_TARGET_FPS:
+        return render_target_fps();
+    case PROTOCOL_PARAM_LOG_MASK:
+        return log_mask();
+    case PROTOCOL_PARAM_BRIGHTNESS:
+        return render_brightness();
+    case PROTOCOL_PARAM_BUS_HZ:
+        return display->bus_speed();
+    case PROTOCOL_PARAM_STALL_MS:
+        return stall_budget_ms();
+    case PROTOCOL_PARAM_CRYPTO_LEVEL:
+        return crypto_unlock_level();
+    default:
+        return 0;
+    }
+}
+
+#ifdef CIPHERPAL_PROFILE
+static uint8_t read_profile(uint16_t first, uint8_t* out)
+{
+    const profiler_slot_t* slots = profiler_slots();
+    uint8_t count = 0;
+    if (first < PROFILER_SLOTS)
+    {
+        count = min((uint16_t)PROTOCOL_PROFILE_SLOTS_PER_READ, (uint16_t)(PROFILER_SLOTS - first));
+    }
+    out[0] = first & 0xFF;
+    out[1] = first >> 8;
+    out[2] = count;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        const profiler_slot_t* slot = &slots[first + i];
+        uint8_t* entry = &out[3 + (i * 4)];
+        entry[0] = slot->bin & 0xFF;
+        entry[1] = slot->bin >> 8;
+        entry[2] = slot->count & 0xFF;
+        entry[3] = slot->count >> 8;
+    }
+    return 3 + (count * 4);
+}
+#endif
+
+static void handle_frame()
+{
+    const parser_t* p = &protocol.parser;
+    uint8_t* out = reply_payload() + 1;
+    uint8_t echo = min(p->length, (uint8_t)(PROTOCOL_PAYLOAD_MAX - 1));
+    switch (p->type)
+    {
+    case PROTOCOL_PING:
+        // The status byte takes one byte of the echo
+        memcpy(out, p->payload, echo);
+        send_reply(PROTOCOL_OK, echo);
+        break;
+    case PROTOCOL_GET_COUNTERS:
+        write_counters(out);
+        send_reply(PROTOCOL_OK, PROTOCOL_COUNTERS * 4);
+        break;
+    case PROTOCOL_SET_PARAM:
+        if (p->length != 5)
+        {
+            send_reply(PROTOCOL_BAD_LENGTH, 0);
+            break;
+        }
+        if (!set_param(p->payload[0], get_u32(&p->payload[1])))
+        {
+            send_reply(PROTOCOL_BAD_ARGUMENT, 0);
+            break;
+        }
+        put_u32(out, get_param(p->payload[0]));
+        send_reply(PROTOCOL_OK, 4);
+        break;
+    case PROTOCOL_GET_PARAM:
+        if (p->length != 1)
+        {
+            send_reply(PROTOCOL_BAD_LENGTH, 0);
+            break;
+        }
+        if (p->payload[0] >= PROTOCOL_PARAMS)
+        {
+            send_reply(PROTOCOL_BAD_ARGUMENT, 0);
+            break;
+        }
+        put_u32(out, get_param(p->payload[0]));
+        send_reply(PROTOCOL_OK, 4);
+        break;
+    case PROTOCOL_PUSH_STATE:
+        if (p->length != 1)
+        {
+            send_reply(PROTOCOL_BAD_LENGTH, 0);
+            break;
+        }
+        if (p->payload[0] >= PROTOCOL_STATES)
+        {
+            send_reply(PROTOCOL_BAD_ARGUMENT, 0);
+            break;
+        }
+        push_render_function(states[p->payload[0]]);
+        out[0] = render_depth();
+        send_reply(PROTOCOL_OK, 1);
+        break;
+    case PROTOCOL_POP_STATE:
+        // The last state is kept, an empty stack leaves nothing to drive
+        if (render_depth() <= 1)
+        {
+            send_reply(PROTOCOL_BAD_ARGUMENT, 0);
+            break;
+        }
+        pop_render_function();
+        out[0] = render_depth();
+        send_reply(PROTOCOL_OK, 1);
+        break;
+    case PROTOCOL_RESET_COUNTERS:
+        render_reset_stats();
+        display->reset_stats();
+        display->reset_flush_timing();
+        protocol_reset_stats();
+        stall_reset_stats();
+        send_reply(PROTOCOL_OK, 0);
+        break;
+#ifdef CIPHERPAL_PROFILE
+    case PROTOCOL_PROFILE_START:
+    {
+        if (p->length != 2)
+        {
+            send_reply(PROTOCOL_BAD_LENGTH, 0);
+            break;
+        }
+        uint16_t hz = profiler_start(p->payload[0] | (p->payload[1] << 8));
+        out[0] = hz & 0xFF;
+        out[1] = hz >> 8;
+        send_reply(PROTOCOL_OK, 2);
+        break;
+    }
+    case PROTOCOL_PROFILE_STOP:
+        profiler_stop();
+        put_u32(&out[0], profiler_stats()->samples);
+        put_u32(&out[4], profiler_stats()->dropped);
+        put_u32(&out[8], profiler_stats()->outside);
+        send_reply(PROTOCOL_OK, 12);
+        break;
+    case PROTOCOL_PROFILE_READ:
+        if (p->length != 2)
+        {
+            send_reply(PROTOCOL_BAD_LENGTH, 0);
+            break;
+        }
+        send_reply(PROTOCOL_OK, read_profile(p->payload[0] | (p->payload[1] << 8), out));
+        break;
+#endif
+    default:
+        ++protocol.stats.rejected;
+        send_reply(PROTOCOL_BAD_COMMAND, 0);
+        break;
+    }
+}
+
+static void trace(const char* what)
+{
+    if (log_mask() & LOG_PROTOCOL)
+    {
+        Log("protocol: %s type 0x%02x seq %u", what, protocol.parser.type, protocol.parser.sequence);
+    }
+}
+
+// Returns true once a whole frame was handled
+static bool parse(uint8_t value)
+{
+    parser_t* p = &protocol.parser;
+    switch (p->state)
+    {
+    case PARSE_SYNC0:
+        if (value == PROTOCOL_SYNC0)
+        {
+            p->state = PARSE_SYNC1;
+        }
+        return false;
+    case PARSE_SYNC1:
+        // A second 0x00 may be the real start
+        p->state = (value == PROTOCOL_SYNC1) ? PARSE_TYPE
+                 : (value == PROTOCOL_SYNC0) ? PARSE_SYNC1 : PARSE_SYNC0;
+        p->crc = CRC_INIT;
+        return false;
+    case PARSE_TYPE:
+        p->type = value;
+        p->crc = crc_byte(p->crc, value);
+        p->state = PARSE_SEQUENCE;
+        return false;
+    case PARSE_SEQUENCE:
+        p->sequence = value;
+        p->crc = crc_byte(p->crc, value);
+        p->state = PARSE_LENGTH;
+        return false;
+    case PARSE_LENGTH:
+        if (value > PROTOCOL_PAYLOAD_MAX)
+        {
+            ++protocol.stats.rejected;
+            trace("too long");
+            p->state = PARSE_SYNC0;
+            return false;
+        }
+        p->length = value;
+        p->received = 0;
+        p->crc = crc_byte(p->crc, value);
+        p->state = (value > 0) ? PARSE_PAYLOAD : PARSE_CRC_LOW;
+        return false;
+    case PARSE_PAYLOAD:
+        p->payload[p->received++] = value;
+        p->crc = crc_byte(p->crc, value);
+        if (p->received == p->length)
+        {
+            p->state = PARSE_CRC_LOW;
+        }
+        return false;
+    case PARSE_CRC_LOW:
+        p->expected_crc = value;
+        p->state = PARSE_CRC_HIGH;
+        return false;
+    default:
+        p->expected_crc |= (uint16_t)value << 8;
+        p->state = PARSE_SYNC0;
+        if (p->expected_crc != p->crc)
+        {
+            ++protocol.stats.crc_errors;
+            trace("bad crc");
+            return false;
+        }
+        ++protocol.stats.frames;
+        power_activity();
+        handle_frame();
+        return true;
+    }
+}
+
+void protocol_service()
+{
+    // A reply already built still goes out while suspended
+    drain_reply();
+    if (protocol.suspended || (protocol.reply_written < protocol.reply_length))
+    {
+        return;
+    }
+
+    // Only in idle time, like the deferred boot work
+    uint32_t frame = render_frame_count();
+    bool idle = (frame == protocol.last_frame);
+    protocol.last_frame = frame;
+    if (!idle)
+    {
+        return;
+    }
+
+    int available = Serial.available();
+    if (available <= 0)
+    {
+        return;
+    }
+
+    uint32_t start = micros();
+    uint8_t count = min(available, PROTOCOL_BYTES_PER_SLICE);
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        int value = Serial.read();
+        if (value < 0)
+        {
+            break;
+        }
+        ++protocol.stats.bytes;
+        // The reply has to go out before the next request is looked at
+        if (parse((uint8_t)value))
+        {
+            break;
+        }
+    }
+    uint32_t elapsed = micros() - start;
+    ++protocol.stats.slices;
+    protocol.stats.slice_us_total += elapsed;
+    if (elapsed > protocol.stats.slice_us_max)
+    {
+        protocol.stats.slice_us_max = elapsed;
+    }
+}
+
+void protocol_suspend(bool suspend)
+{
+    protocol.suspended = suspend;
+    protocol.parser.state = PARSE_SYNC0;
+}
+
+bool protocol_reply_pending()
+{
+    return protocol.reply_written < protocol.reply_length;
+}
+
+const protocol_stats_t* protocol_stats()
+{
+    return &protocol.stats;
+}
+
+void protocol_reset_stats()
+{
+    memset(&protocol.stats, 0, sizeof(protocol.stats));
+}
@@ -0,0 +1,140 @@
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#include <stdint.h>
+
+// Binary command protocol over Serial, next to the Log() text. Requests
+// and replies share one frame layout:
+//
+//   0x00 'P'  type  sequence  length  payload[length]  crc (u16 LE)
+//
+// The CRC is CRC-16/CCITT-FALSE (init 0xFFFF) over type to the end of the
+// payload. A reply has the request type with PROTOCOL_REPLY set and the
+// same sequence, its first payload byte is a protocol_status_t. Multi-byte
+// values are little endian. Bytes outside a frame are ignored, so Log()
+// text and mirror packets can share the port. Replies and mirror packets
+// never interleave: a reply waits for the packet in flight and no packet
+// is started while a reply is going out (see mirror.h). Log() lines are
+// not held back, a host that only wants frames clears LOG_GENERAL with
+// PROTOCOL_SET_PARAM.
+//
+// protocol_service() runs from loop() and only in iterations where
+// render() did not draw. It reads at most PROTOCOL_BYTES_PER_SLICE bytes
+// and never waits on the port: a reply that does not fit is kept and
+// drained on later calls, and nothing is parsed until it is out. The time
+// of every slice is measured and reported with the counters.
+// tools/cipherpal_client.py is the host side.
+
+#define PROTOCOL_SYNC0 0x00
+#define PROTOCOL_SYNC1 'P'
+#define PROTOCOL_PAYLOAD_MAX 64
+#define PROTOCOL_BYTES_PER_SLICE 32
+#define PROTOCOL_REPLY 0x80
+
+typedef enum
+{
+    // Payload is echoed back
+    PROTOCOL_PING = 0x01,
+    // Reply is the protocol_counter_t values as u32
+    PROTOCOL_GET_COUNTERS = 0x02,
+    // [param, u32 value], reply is the value now in effect
+    PROTOCOL_SET_PARAM = 0x03,
+    // [param], reply is its u32 value
+    PROTOCOL_GET_PARAM = 0x04,
+    // [protocol_state_t]. Covered and popped states run their leave hook
+    // (see render_on_leave()), so they start over when on top again.
+    PROTOCOL_PUSH_STATE = 0x05,
+    PROTOCOL_POP_STATE = 0x06,
+    PROTOCOL_RESET_COUNTERS = 0x07,
+    // The profiler commands are only there in the profile build (see
+    // profiler.h). [u16 rate], reply is the rate in effect
+    PROTOCOL_PROFILE_START = 0x08,
+    // Reply is the profiler_stats_t values as u32
+    PROTOCOL_PROFILE_STOP = 0x09,
+    // [u16 first slot], reply is [u16 first, count] and count (u16 bin,
+    // u16 samples) slots, PROTOCOL_PROFILE_SLOTS_PER_READ at most and none
+    // past the end of the table
+    PROTOCOL_PROFILE_READ = 0x0A,
+} protocol_command_t;
+
+#define PROTOCOL_PROFILE_SLOTS_PER_READ 15
+
+typedef enum
+{
+    PROTOCOL_OK = 0,
+    PROTOCOL_BAD_COMMAND,
+    PROTOCOL_BAD_ARGUMENT,
+    PROTOCOL_BAD_LENGTH,
+} protocol_status_t;
+
+typedef enum
+{
+    PROTOCOL_PARAM_TARGET_FPS = 0,
+    PROTOCOL_PARAM_LOG_MASK,
+    PROTOCOL_PARAM_BRIGHTNESS,
+    PROTOCOL_PARAM_BUS_HZ,
+    PROTOCOL_PARAM_STALL_MS,
+    // Used from the next CRYPTO UNLOCK game on
+    PROTOCOL_PARAM_CRYPTO_LEVEL,
+    PROTOCOL_PARAMS
+} protocol_param_t;
+
+typedef enum
+{
+    PROTOCOL_STATE_MAIN_MENU = 0,
+    PROTOCOL_STATE_SELF_TEST,
+    PROTOCOL_STATE_REGISTER_READ,
+    PROTOCOL_STATE_BUFFER_DECONSTRUCT,
+    PROTOCOL_STATE_GRAYSCALE_DEMO,
+    PROTOCOL_STATE_CRYPTO_UNLOCK,
+    PROTOCOL_STATE_CIPHER_STREAM,
+    PROTOCOL_STATE_SPLASH,
+    PROTOCOL_STATE_CLIP_PLAYER,
+    PROTOCOL_STATE_LOG_TICKER,
+    PROTOCOL_STATES
+} protocol_state_t;
+
+// Order of the values in a PROTOCOL_GET_COUNTERS reply
+typedef enum
+{
+    PROTOCOL_COUNTER_FRAMES = 0,
+    PROTOCOL_COUNTER_FRAME_US,
+    PROTOCOL_COUNTER_FRAME_US_MAX,
+    PROTOCOL_COUNTER_FRAME_US_AVG,
+    PROTOCOL_COUNTER_FLUSHES,
+    PROTOCOL_COUNTER_FLUSHED_BYTES,
+    PROTOCOL_COUNTER_FLUSH_US,
+    PROTOCOL_COUNTER_INPUT_EVENTS,
+    PROTOCOL_COUNTER_RX_FRAMES,
+    PROTOCOL_COUNTER_CRC_ERRORS,
+    PROTOCOL_COUNTER_SLICE_US_MAX,
+    PROTOCOL_COUNTER_SLICE_US_AVG,
+    PROTOCOL_COUNTER_UPTIME_MS,
+    PROTOCOL_COUNTER_STALLS,
+    PROTOCOL_COUNTER_LOOP_US_MAX,
+    PROTOCOL_COUNTERS
+} protocol_counter_t;
+
+typedef struct
+{
+    uint32_t bytes;
+    uint32_t frames;
+    uint32_t crc_errors;
+    // Frames with an unknown type or a payload that was too long
+    uint32_t rejected;
+    uint32_t slices;
+    uint32_t slice_us_total;
+    uint32_t slice_us_max;
+} protocol_stats_t;
+
+void protocol_service();
+// States that read Serial themselves hold the parser off
+void protocol_suspend(bool suspend);
+// A reply has been built and is not fully written yet
+bool protocol_reply_pending();
+const protocol_stats_t* protocol_stats();
+void protocol_reset_stats();
+
+uint16_t protocol_crc(uint16_t crc, const uint8_t* data, uint16_t length);
+
+#endif // PROTOCOL_H_
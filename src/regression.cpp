@@ -0,0 +1,300 @@
+#include "regression.h"
+
+#ifdef CIPHERPAL_REGRESSION
+
+#include "buttons.h"
+#include "renderer.h"
+#include "utility.h"
+#include "render_states/buffer_deconstruct.h"
+#include "render_states/cipher_stream.h"
+#include "render_states/clip_player.h"
+#include "render_states/crypto_unlock.h"
+#include "render_states/grayscale_demo.h"
+#include "render_states/log_ticker.h"
+#include "render_states/main_menu.h"
+#include "render_states/register_read.h"
+#include "render_states/self_test.h"
+#include "render_states/splash_screen.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PRESS(ms, mask) { (ms), (uint8_t)(BUTTON_ALL_MASK & ~(mask)) }
+#define RELEASE(ms) { (ms), BUTTON_ALL_MASK }
+#define SCRIPT(steps) steps, (uint8_t)(sizeof(steps) / sizeof(steps[0]))
+#define NO_SCRIPT NULL, 0
+// Worst frame allowed for states that must hold the default frame rate
+#define FRAME_BUDGET_US (1000000UL / DEFAULT_TARGET_FPS)
+#define NO_BUDGET 0
+// Frame bytes per dump line, as hex within Log()'s 128 characters
+#define DUMP_BYTES 32
+
+typedef struct
+{
+    uint32_t at_ms;
+    uint8_t buttons;
+} script_step_t;
+
+typedef void (*regression_setup_t)();
+
+typedef struct
+{
+    const char* name;
+    render_function_t state;
+    // Run before the state is pushed, may be NULL
+    regression_setup_t setup;
+    const script_step_t* script;
+    uint8_t steps;
+    uint32_t duration_ms;
+    // Frames that show live values are only checked for cost
+    bool golden;
+    // Worst render() time, NO_BUDGET leaves it unchecked
+    uint32_t frame_budget_us;
+} regression_case_t;
+
+static const script_step_t menu_script[] = {
+    PRESS(200, BUTTON_DOWN_STATE_MASK),
+    RELEASE(300),
+    PRESS(500, BUTTON_DOWN_STATE_MASK),
+    RELEASE(600),
+    PRESS(800, BUTTON_UP_STATE_MASK),
+    RELEASE(900),
+};
+
+static const script_step_t crypto_script[] = {
+    PRESS(500, BUTTON_UP_STATE_MASK),
+    RELEASE(600),
+    PRESS(1000, BUTTON_SEL_STATE_MASK),
+    RELEASE(1100),
+    PRESS(1500, BUTTON_DOWN_STATE_MASK),
+    RELEASE(1600),
+    PRESS(2000, BUTTON_SEL_STATE_MASK),
+    RELEASE(2100),
+};
+
+static const script_step_t register_script[] = {
+    PRESS(300, BUTTON_DOWN_STATE_MASK),
+    RELEASE(400),
+};
+
+static const script_step_t exit_script[] = {
+    PRESS(800, BUTTON_SEL_STATE_MASK),
+    RELEASE(900),
+};
+
+static const script_step_t decon_script[] = {
+    PRESS(4000, BUTTON_SEL_STATE_MASK),
+    RELEASE(4100),
+};
+
+// A won game unlocks REGISTER READ and skips every later game, so each
+// case sets the lock it needs
+static void crypto_easy()
+{
+    register_unlocked = false;
+    crypto_unlock_set_level(CRYPTO_LEVEL_EASY);
+}
+
+static void crypto_normal()
+{
+    register_unlocked = false;
+    crypto_unlock_set_level(CRYPTO_LEVEL_NORMAL);
+}
+
+static void crypto_hard()
+{
+    register_unlocked = false;
+    crypto_unlock_set_level(CRYPTO_LEVEL_HARD);
+}
+
+// The SAMD21 memory map is only there on the target, elsewhere the viewer
+// is run locked
+static void register_access()
+{
+#if defined(ARDUINO_ARCH_SAMD)
+    register_unlocked = true;
+#else
+    register_unlocked = false;
+#endif
+}
+
+static void demo_clip()
+{
+    clip_player_set(NULL, true);
+}
+
+static const regression_case_t cases[] = {
+    { "SPLASH", splash_screen_render, NULL, NO_SCRIPT, 9000, true, NO_BUDGET },
+    { "MAIN MENU", main_menu_render, NULL, SCRIPT(menu_script), 1500, true, NO_BUDGET },
+    { "SELF TEST", self_test_render, NULL, NO_SCRIPT, 8000, true, NO_BUDGET },
+    { "CRYPTO UNLOCK", crypto_unlock_render, crypto_easy, SCRIPT(crypto_script), 3000, true, FRAME_BUDGET_US },
+    { "CRYPTO NORMAL", crypto_unlock_render, crypto_normal, SCRIPT(crypto_script), 3000, true, FRAME_BUDGET_US },
+    { "CRYPTO HARD", crypto_unlock_render, crypto_hard, SCRIPT(crypto_script), 3000, true, FRAME_BUDGET_US },
+    { "REGISTER READ", register_read_render, register_access, SCRIPT(register_script), 1500, false, NO_BUDGET },
+    { "BUFFER DECON", buffer_deconstruct_render, NULL, SCRIPT(decon_script), 4500, true, NO_BUDGET },
+    { "GRAYSCALE", grayscale_demo_render, NULL, SCRIPT(exit_script), 1000, true, NO_BUDGET },
+    // Streams whatever job is waiting on Serial, the host tests queue one
+    { "CIPHER STREAM", cipher_stream_render, NULL, NO_SCRIPT, 2000, true, FRAME_BUDGET_US },
+    { "CLIP PLAYER", clip_player_render, demo_clip, NO_SCRIPT, 3000, true, NO_BUDGET },
+    { "LOG TICKER", log_ticker_render, NULL, NO_SCRIPT, 6000, true, NO_BUDGET },
+};
+
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+static uint32_t virtual_now = 0;
+static uint8_t scripted_buttons = BUTTON_ALL_MASK;
+// Kept past the state's leave hook, which may clear the frame or, like
+// CIPHER STREAM, hold Log() off
+static uint8_t last_frame[FRAME_BYTES] __attribute__((aligned(4)));
+
+uint32_t regression_clock()
+{
+    return virtual_now;
+}
+
+uint8_t regression_buttons()
+{
+    return scripted_buttons;
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, uint16_t length)
+{
+    static const uint32_t nibble_table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    crc = ~crc;
+    for (uint16_t i = 0; i < length; ++i)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ nibble_table[crc & 0x0F];
+        crc = (crc >> 4) ^ nibble_table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+// The last frame as hex lines, tools/regression_record.py turns them into
+// the golden PBM
+static void dump_frame(const char* name, const uint8_t* frame)
+{
+    static const char hex[] = "0123456789abcdef";
+    char line[(DUMP_BYTES * 2) + 1];
+    for (uint16_t offset = 0; offset < FRAME_BYTES; offset += DUMP_BYTES)
+    {
+        for (uint8_t i = 0; i < DUMP_BYTES; ++i)
+        {
+            line[i * 2] = hex[frame[offset + i] >> 4];
+            line[(i * 2) + 1] = hex[frame[offset + i] & 0x0F];
+        }
+        line[DUMP_BYTES * 2] = '\0';
+        Log("regression %s: frame %04x %s", name, offset, line);
+    }
+}
+
+static bool run_case(const regression_case_t* test, regression_check_t check)
+{
+    srand(REGRESSION_SEED);
+    randomSeed(REGRESSION_SEED);
+    scripted_buttons = BUTTON_ALL_MASK;
+    if (test->setup != NULL)
+    {
+        test->setup();
+    }
+    display->reset_stats();
+    display->reset_flush_timing();
+    render_reset_stats();
+
+    regression_result_t result;
+    memset(&result, 0, sizeof(result));
+    result.name = test->name;
+    result.golden = test->golden;
+    result.budget_us = test->frame_budget_us;
+    uint8_t step = 0;
+    uint32_t start_ms = virtual_now;
+    push_render_function(test->state);
+
+    for (uint32_t t = 0; t < test->duration_ms; t += REGRESSION_FRAME_MS)
+    {
+        while ((step < test->steps) && (test->script[step].at_ms <= t))
+        {
+            scripted_buttons = test->script[step].buttons;
+            ++step;
+        }
+        virtual_now = start_ms + t;
+        render();
+        result.crc = crc32_update(result.crc, display->frame(), FRAME_BYTES);
+    }
+
+    const display_stats_t& stats = display->stats();
+    result.frames = render_stats()->frames;
+    result.pixel_ops = stats.pixel_ops;
+    result.rect_pixels = stats.rect_pixels;
+    result.flushes = stats.flushes;
+    result.flushed_bytes = stats.flushed_bytes;
+    result.worst_us = render_stats()->frame_us_max;
+    memcpy(last_frame, display->frame(), FRAME_BYTES);
+    result.frame = last_frame;
+
+    // Leave states that are still running
+    while (render_depth() > 0)
+    {
+        pop_render_function();
+    }
+    virtual_now = start_ms + test->duration_ms;
+    render();
+
+    if (test->golden)
+    {
+        dump_frame(test->name, last_frame);
+    }
+    bool in_budget = (test->frame_budget_us == NO_BUDGET) || (result.worst_us <= test->frame_budget_us);
+    bool pass = in_budget && ((check == NULL) || check(&result));
+
+    // Split to stay within Log()'s line length
+    Log("regression %s: %lu pixels, %lu rect pixels, %lu bytes flushed",
+        test->name,
+        (unsigned long)result.pixel_ops,
+        (unsigned long)result.rect_pixels,
+        (unsigned long)result.flushed_bytes);
+    Log("regression %s: %s crc %08lx, %lu flushes, %lu us worst%s",
+        test->name,
+        pass ? "PASS" : "FAIL",
+        (unsigned long)result.crc,
+        (unsigned long)result.flushes,
+        (unsigned long)result.worst_us,
+        in_budget ? "" : ", over budget");
+    return pass;
+}
+
+bool regression_run(regression_check_t check)
+{
+    Log("regression start");
+    render_set_clock(regression_clock);
+    set_button_source(regression_buttons);
+    uint8_t fps = render_target_fps();
+    bool was_unlocked = register_unlocked;
+    render_set_target_fps(0);
+
+    uint8_t failed = 0;
+    for (uint8_t i = 0; i < CASE_COUNT; ++i)
+    {
+        if (!run_case(&cases[i], check))
+        {
+            ++failed;
+        }
+    }
+
+    render_set_target_fps(fps);
+    crypto_unlock_set_level(CRYPTO_DEFAULT_LEVEL);
+    register_unlocked = was_unlocked;
+    set_button_source(NULL);
+    render_set_clock(NULL);
+    display->clearDisplay();
+    Log("regression done, %u of %u failed", failed, (unsigned)CASE_COUNT);
+    return failed == 0;
+}
+
+#endif // CIPHERPAL_REGRESSION
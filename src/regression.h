@@ -0,0 +1,52 @@
+#ifndef REGRESSION_H_
+#define REGRESSION_H_
+
+#include <stdint.h>
+
+// Golden frame and cost regression run. Every render state is driven with
+// scripted buttons on a virtual clock, unpaced and with a fixed random
+// seed, so a build always produces the same frames. Per state it counts
+// the work done (frames, pixel and rectangle operations, flushes and
+// flushed bytes), takes a CRC32 over every frame and the slowest
+// render(), and hands the result to a check.
+//
+// The goldens live with the host tests: test/regression_test.cpp runs the
+// firmware on the Zephyr compat shims and compares every state with the
+// frames and thresholds in test/golden/. The regression environment (pio
+// run -e adafruit_feather_m0_regression) runs the same cases on the
+// target without a check, so there a state only fails when its slowest
+// frame is over its budget. The last frame of every golden state is
+// logged as hex, tools/regression_record.py turns a run's log into PBMs.
+#ifdef CIPHERPAL_REGRESSION
+
+#define REGRESSION_SEED 0x1234
+#define REGRESSION_FRAME_MS 33
+
+typedef struct
+{
+    const char* name;
+    // States that show live values on the target are only checked for
+    // cost there
+    bool golden;
+    uint32_t crc;
+    uint32_t frames;
+    uint32_t pixel_ops;
+    uint32_t rect_pixels;
+    uint32_t flushes;
+    uint32_t flushed_bytes;
+    // Slowest render() including its flush, against budget_us when not 0
+    uint32_t worst_us;
+    uint32_t budget_us;
+    // Last frame of the state
+    const uint8_t* frame;
+} regression_result_t;
+
+// Returns false when a state's result does not match its baseline
+typedef bool (*regression_check_t)(const regression_result_t* result);
+
+// Returns true when every state passed, check may be NULL
+bool regression_run(regression_check_t check);
+
+#endif
+
+#endif // REGRESSION_H_
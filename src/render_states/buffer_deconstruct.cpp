@@ -0,0 +1,90 @@
+#include "buffer_deconstruct.h"
+
+#include "buttons.h"
+#include "coroutine.h"
+#include "images.h"
+#include "particles.h"
+#include "renderer.h"
+#include "sprite.h"
+#include "utility.h"
+
+#include <stdint.h>
+
+#define HOLD_MS 1500
+#define SCATTER_MS 1200
+#define SCATTER_X (LCD_WIDTH / 2)
+#define SCATTER_Y (LCD_HEIGHT / 2)
+
+typedef struct
+{
+    coroutine_t co;
+    uint32_t timer;
+    bool settled;
+    bool leave;
+} deconstruct_t;
+
+static deconstruct_t decon;
+
+// Break up whatever is on screen, the menu when entered from it
+static void capture_screen()
+{
+    uint8_t* frame = display->frame();
+    if (particles_capture(frame) == 0)
+    {
+        sprite_draw(frame,
+                    &DI_MEDIUM,
+                    (LCD_WIDTH - DI_MEDIUM.width) / 2,
+                    (LCD_HEIGHT - DI_MEDIUM.height) / 2,
+                    1,
+                    SPRITE_OR);
+        particles_capture(frame);
+    }
+    Log("Buffer decon: %u fragments", particles_count());
+}
+
+static void buffer_deconstruct_leave(bool popped)
+{
+    UNUSED(popped);
+    CO_INIT(&decon.co);
+}
+
+bool buffer_deconstruct_render(const render_context_t* ctx)
+{
+    if (ctx->released & BUTTON_SEL_STATE_MASK)
+    {
+        decon.leave = true;
+    }
+
+    coroutine_t* co = &decon.co;
+    CO_BEGIN(co);
+
+    render_on_leave(buffer_deconstruct_leave);
+    decon.leave = false;
+    capture_screen();
+
+    while (!decon.leave)
+    {
+        decon.timer = ctx->now;
+        CO_AWAIT(co, decon.leave || ((ctx->now - decon.timer) >= HOLD_MS));
+
+        particles_scatter(SCATTER_X, SCATTER_Y);
+        decon.timer = ctx->now;
+        while (!decon.leave && ((ctx->now - decon.timer) < SCATTER_MS))
+        {
+            particles_step_free();
+            particles_draw(display->frame());
+            CO_YIELD(co, true);
+        }
+
+        decon.settled = false;
+        while (!decon.leave && !decon.settled)
+        {
+            decon.settled = particles_step_home();
+            particles_draw(display->frame());
+            CO_YIELD(co, true);
+        }
+    }
+
+    pop_render_function();
+    CO_END(co);
+}
@@ -0,0 +1,10 @@
+#ifndef BUFFER_DECONSTRUCT_H_
+#define BUFFER_DECONSTRUCT_H_
+
+#include "renderer.h"
+
+#include <stdint.h>
+
+bool buffer_deconstruct_render(const render_context_t* ctx);
+
+#endif // BUFFER_DECONSTRUCT_H_
@@ -0,0 +1,297 @@
+#include "cipher_stream.h"
+
+#include "buttons.h"
+#include "cipher.h"
+#include "coroutine.h"
+#include "mirror.h"
+#include "power.h"
+#include "protocol.h"
+#include "renderer.h"
+#include "utility.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUNK_BYTES 128
+#define HEADER_MAX 64
+#define EXIT_HOLD_MS 1000
+#define REDRAW_MS 200
+#define RATE_WINDOW_MS 1000
+// Left in the frame budget for the redraw and its flush
+#define FLUSH_RESERVE_US 12000
+
+#define LINE_HEIGHT 8
+#define TITLE_Y 0
+#define STATUS_Y 12
+#define COUNT_Y 24
+#define BAR_Y 36
+#define BAR_HEIGHT 8
+#define RATE_Y 48
+#define HINT_Y 56
+
+typedef struct
+{
+    coroutine_t co;
+    cipher_t cipher;
+    bool streaming;
+    // A header was accepted, the title shows its cipher
+    bool has_job;
+    const char* status;
+    char header[HEADER_MAX];
+    uint8_t header_length;
+    uint8_t chunk[CHUNK_BYTES] __attribute__((aligned(4)));
+    uint16_t chunk_length;
+    uint16_t chunk_written;
+    uint32_t total;
+    uint32_t done;
+    uint32_t rate;
+    uint32_t rate_start;
+    uint32_t rate_bytes;
+    uint32_t sel_down;
+    uint32_t redraw_at;
+    bool changed;
+    uint8_t log_mask;
+} cipher_stream_t;
+
+static cipher_stream_t stream;
+
+static bool parse_header(char* line)
+{
+    char* space = strchr(line, ' ');
+    if (space == NULL)
+    {
+        return false;
+    }
+    *space = '\0';
+    uint8_t mode = cipher_mode(line);
+
+    char* field = space + 1;
+    char direction = field[0] | 0x20;
+    if (((direction != 'e') && (direction != 'd')) || (field[1] != ' '))
+    {
+        return false;
+    }
+
+    field += 2;
+    char* end = NULL;
+    unsigned long length = strtoul(field, &end, 10);
+    if ((end == field) || (*end != ' ') || (length == 0))
+    {
+        return false;
+    }
+
+    const char* key = end + 1;
+    if (!cipher_init(&stream.cipher, mode, direction == 'd', (const uint8_t*)key, strlen(key)))
+    {
+        return false;
+    }
+    stream.total = length;
+    stream.done = 0;
+    return true;
+}
+
+// Collect header bytes, returns true once a whole line was read
+static bool read_header()
+{
+    int c = Serial.read();
+    if (c < 0)
+    {
+        return false;
+    }
+    if (c == '\r')
+    {
+        return true;
+    }
+    if (c != '\n')
+    {
+        if (stream.header_length < (HEADER_MAX - 1))
+        {
+            stream.header[stream.header_length++] = (char)c;
+        }
+        return true;
+    }
+
+    stream.header[stream.header_length] = '\0';
+    stream.streaming = parse_header(stream.header);
+    stream.has_job = stream.has_job || stream.streaming;
+    stream.status = stream.streaming ? "STREAMING" : "BAD HEADER";
+    stream.header_length = 0;
+    stream.changed = true;
+    return true;
+}
+
+// Moves data until the port has nothing to give or take, or the frame
+// budget is spent
+static void pump(const render_context_t* ctx)
+{
+    while (render_budget_remaining_us(ctx) > FLUSH_RESERVE_US)
+    {
+        if (stream.chunk_written < stream.chunk_length)
+        {
+            // The tail of a mirror packet sent before entering goes first,
+            // render() keeps draining it
+            if (mirror_busy())
+            {
+                break;
+            }
+            int room = Serial.availableForWrite();
+            if (room <= 0)
+            {
+                break;
+            }
+            uint16_t count = min((uint16_t)room, (uint16_t)(stream.chunk_length - stream.chunk_written));
+            stream.chunk_written += Serial.write(&stream.chunk[stream.chunk_written], count);
+            continue;
+        }
+
+        if (!stream.streaming)
+        {
+            if (!read_header())
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (stream.done == stream.total)
+        {
+            stream.streaming = false;
+            stream.status = "DONE";
+            stream.changed = true;
+            continue;
+        }
+
+        int available = Serial.available();
+        if (available <= 0)
+        {
+            break;
+        }
+        uint32_t left = stream.total - stream.done;
+        uint16_t count = min((uint32_t)available, min(left, (uint32_t)CHUNK_BYTES));
+        count = Serial.readBytes(stream.chunk, count);
+        cipher_apply(&stream.cipher, stream.chunk, count);
+        stream.chunk_length = count;
+        stream.chunk_written = 0;
+        stream.done += count;
+        stream.rate_bytes += count;
+        stream.changed = true;
+    }
+
+    if ((ctx->now - stream.rate_start) >= RATE_WINDOW_MS)
+    {
+        stream.rate = (stream.rate_bytes * 1000UL) / (ctx->now - stream.rate_start);
+        stream.rate_bytes = 0;
+        stream.rate_start = ctx->now;
+        stream.changed = true;
+    }
+}
+
+static void draw_line(int16_t y, const char* text)
+{
+    display->fillRect(0, y, LCD_WIDTH, LINE_HEIGHT, MONOOLED_BLACK);
+    display->setCursor(0, y);
+    display->print(text);
+}
+
+static void draw_stream()
+{
+    char text[22];
+    display->setTextColor(MONOOLED_WHITE, MONOOLED_BLACK);
+    display->setTextSize(1);
+
+    snprintf(text, sizeof(text), "%-9s %s",
+             cipher_name(stream.cipher.mode),
+             stream.cipher.decrypt ? "DECRYPT" : "ENCRYPT");
+    draw_line(TITLE_Y, stream.has_job ? text : "CIPHER");
+    draw_line(STATUS_Y, stream.status);
+
+    snprintf(text, sizeof(text), "%lu/%lu B",
+             (unsigned long)stream.done,
+             (unsigned long)stream.total);
+    draw_line(COUNT_Y, text);
+
+    display->fillRect(0, BAR_Y, LCD_WIDTH, BAR_HEIGHT, MONOOLED_BLACK);
+    display->drawRect(0, BAR_Y, LCD_WIDTH, BAR_HEIGHT, MONOOLED_WHITE);
+    if (stream.total > 0)
+    {
+        int16_t width = (int16_t)(((uint64_t)(LCD_WIDTH - 4) * stream.done) / stream.total);
+        display->fillRect(2, BAR_Y + 2, width, BAR_HEIGHT - 4, MONOOLED_WHITE);
+    }
+
+    snprintf(text, sizeof(text), "%lu B/S", (unsigned long)stream.rate);
+    draw_line(RATE_Y, text);
+    draw_line(HINT_Y, "MODE E|D LEN KEY");
+}
+
+// Returns false when SEL was held long enough to exit
+static bool handle_input(const render_context_t* ctx)
+{
+    if (ctx->pressed & BUTTON_SEL_STATE_MASK)
+    {
+        stream.sel_down = ctx->now;
+    }
+    return !((ctx->released & BUTTON_SEL_STATE_MASK)
+             && ((ctx->now - stream.sel_down) >= EXIT_HOLD_MS));
+}
+
+static void cipher_stream_leave(bool popped)
+{
+    UNUSED(popped);
+    power_inhibit(false);
+    protocol_suspend(false);
+    mirror_suspend(false);
+    log_set_mask(stream.log_mask);
+    CO_INIT(&stream.co);
+}
+
+bool cipher_stream_render(const render_context_t* ctx)
+{
+    coroutine_t* co = &stream.co;
+    CO_BEGIN(co);
+
+    display->clearDisplay();
+    // Standby would drop the USB port under the host
+    power_inhibit(true);
+    // The job header and data would otherwise be taken for protocol frames
+    protocol_suspend(true);
+    // Log lines and mirror packets would land in the output stream
+    stream.log_mask = log_mask();
+    log_set_mask(0);
+    mirror_suspend(true);
+    render_on_leave(cipher_stream_leave);
+    stream.streaming = false;
+    stream.has_job = false;
+    stream.status = "WAITING FOR HEADER";
+    stream.header_length = 0;
+    stream.chunk_length = 0;
+    stream.chunk_written = 0;
+    stream.total = 0;
+    stream.done = 0;
+    stream.rate = 0;
+    stream.rate_bytes = 0;
+    stream.rate_start = ctx->now;
+    stream.sel_down = ctx->now;
+    stream.redraw_at = ctx->now;
+    stream.changed = true;
+
+    while (handle_input(ctx))
+    {
+        pump(ctx);
+        if (stream.changed && ((int32_t)(ctx->now - stream.redraw_at) >= 0))
+        {
+            draw_stream();
+            stream.changed = false;
+            stream.redraw_at = ctx->now + REDRAW_MS;
+            CO_YIELD(co, true);
+        }
+        else
+        {
+            CO_YIELD(co, false);
+        }
+    }
+
+    pop_render_function();
+    CO_END(co);
+}
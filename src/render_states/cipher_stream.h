@@ -0,0 +1,19 @@
+#ifndef CIPHER_STREAM_H_
+#define CIPHER_STREAM_H_
+
+#include "renderer.h"
+
+#include <stdint.h>
+
+// Encrypts or decrypts what arrives on Serial and sends the result back.
+// Each job starts with a text header line, then exactly length bytes:
+//
+//   <mode> <e|d> <length> <key>\n
+//
+// mode is SUBST, VIGENERE, XOR or CHACHA20 (or the first letter), the key
+// is the rest of the line. Chunks are transformed in place and written
+// from the same buffer, and only as much is done per frame as fits in the
+// frame budget. Holding SEL for a second exits.
+bool cipher_stream_render(const render_context_t* ctx);
+
+#endif // CIPHER_STREAM_H_
@@ -0,0 +1,118 @@
+#include "clip_player.h"
+
+#include "buttons.h"
+#include "clip.h"
+#include "clip_demo.h"
+#include "coroutine.h"
+#include "renderer.h"
+#include "utility.h"
+
+#include <stdint.h>
+
+// Further behind than this, e.g. after standby, the clock is followed
+// instead of catching up frame by frame
+#define RESYNC_MS 500
+
+typedef struct
+{
+    coroutine_t co;
+    clip_reader_t reader;
+    const uint8_t* clip;
+    bool loop;
+    bool ended;
+    uint32_t due;
+    uint16_t dirty;
+    clip_player_stats_t stats;
+} clip_player_t;
+
+static clip_player_t player = { {0, 0, 0}, {NULL, NULL, 0, 0}, NULL, true, false, 0, 0, {0, 0} };
+
+// Apply every frame that is due, returns the pages they changed
+static uint16_t advance(uint32_t now)
+{
+    if ((int32_t)(now - player.due) > RESYNC_MS)
+    {
+        player.due = now;
+    }
+
+    uint16_t dirty = 0;
+    uint8_t applied = 0;
+    while ((int32_t)(now - player.due) >= 0)
+    {
+        uint16_t duration = clip_next(&player.reader, display->frame(), &dirty);
+        if (duration == 0)
+        {
+            if (!player.loop)
+            {
+                player.ended = true;
+                break;
+            }
+            clip_rewind(&player.reader);
+            continue;
+        }
+        player.due += duration;
+        ++applied;
+    }
+
+    if (applied > 0)
+    {
+        ++player.stats.frames;
+        player.stats.skipped += applied - 1;
+    }
+    return dirty;
+}
+
+static void mark_pages(uint16_t pages)
+{
+    for (uint8_t page = 0; page < DISPLAY_PAGES; ++page)
+    {
+        if (pages & (1u << page))
+        {
+            display->mark_dirty(page * 8, 8);
+        }
+    }
+}
+
+static void clip_player_leave(bool popped)
+{
+    UNUSED(popped);
+    Log("Clip: %lu frames shown, %lu skipped",
+        (unsigned long)player.stats.frames,
+        (unsigned long)player.stats.skipped);
+    player.clip = NULL;
+    player.loop = true;
+    CO_INIT(&player.co);
+}
+
+bool clip_player_render(const render_context_t* ctx)
+{
+    coroutine_t* co = &player.co;
+    CO_BEGIN(co);
+
+    render_on_leave(clip_player_leave);
+    player.ended = !clip_open(&player.reader, (player.clip != NULL) ? player.clip : CLIP_DEMO);
+    player.due = ctx->now;
+    player.stats.frames = 0;
+    player.stats.skipped = 0;
+
+    while (!player.ended && !(ctx->released & BUTTON_SEL_STATE_MASK))
+    {
+        player.dirty = advance(ctx->now);
+        mark_pages(player.dirty);
+        CO_YIELD(co, player.dirty != 0);
+    }
+
+    pop_render_function();
+    CO_END(co);
+}
+
+void clip_player_set(const uint8_t* clip, bool loop)
+{
+    player.clip = clip;
+    player.loop = loop || (clip == NULL);
+}
+
+const clip_player_stats_t* clip_player_stats()
+{
+    return &player.stats;
+}
@@ -0,0 +1,24 @@
+#ifndef CLIP_PLAYER_H_
+#define CLIP_PLAYER_H_
+
+#include "renderer.h"
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t frames;
+    // Frames applied without being shown to keep to the clip's timing
+    uint32_t skipped;
+} clip_player_stats_t;
+
+// Plays a clip (see clip.h) at its own frame timing, whatever the render
+// rate: every frame that came due since the last render is applied and
+// only the pages they touched are flushed. SEL stops playback, a clip
+// that does not loop pops the state when it ends.
+bool clip_player_render(const render_context_t* ctx);
+// Clip for the next push, NULL plays the built in demo clip on loop
+void clip_player_set(const uint8_t* clip, bool loop);
+const clip_player_stats_t* clip_player_stats();
+
+#endif // CLIP_PLAYER_H_
@@ -1,51 +1,144 @@
 #include "crypto_unlock.h"
 
+#include "animation.h"
 #include "buttons.h"
+#include "cipher_stream.h"
+#include "coroutine.h"
+#include "highlight.h"
+#include "layers.h"
 #include "register_read.h"
 #include "renderer.h"
 #include "utility.h"
 
-#include <algorithm>
-#include <map>
-#include <vector>
-#include <set>
+#include <stdint.h>
+#include <stdlib.h>
 
 #define KEY_ROTATE_MS 5000
 #define CYCLE_RATE_MS 1000
 #define FLASH_RATE_MS 500
-#define CYCLE_COUNT 6
 #define CELL_STATE_LOCKED 0x01
-#define CHARACTERS_PER_LINE 11
+// Queued in crypto.changed for a redraw
+#define CELL_STATE_CHANGED 0x02
 #define UP_KEY 0
 #define DOWN_KEY 2
 #define SEL_KEY 1
 #define KEY_COUNT 3
-#define NBLINKS 5
-#define BLINK_TIME 250
+#define KEY_BAR_X 18
+#define KEY_BAR_Y 57
 
-static const uint8_t ROWS = 3;
-static const uint8_t COLUMNS = CHARACTERS_PER_LINE;
-static const uint16_t CELLS = ROWS * COLUMNS;
+// Per cell structures are sized for the largest grid at compile time
+#define EASY_CELLS (3 * 11)
+#define NORMAL_CELLS (5 * 16)
+#define HARD_CELLS (7 * 21)
+#define MAX_CELLS HARD_CELLS
+#if (EASY_CELLS > MAX_CELLS) || (NORMAL_CELLS > MAX_CELLS)
+#error "A crypto grid has more cells than MAX_CELLS"
+#endif
+
+#define CODEPOINTS 256
+#define NO_CELL 0xFFFF
+
+// Once unlocked, a level to replay or straight on to the cipher
+#define PICK_CIPHER CRYPTO_LEVELS
+#define PICK_CHOICES (CRYPTO_LEVELS + 1)
+#define PICK_Y 16
+#define PICK_PITCH 12
+
+#define CYCLE_TRACK 0
+#define KEY_TRACK 1
+#define FLASH_TRACK 2
+
+typedef uint16_t cell_index_t;
+
+// Cells are size glyphs at a pitch, the box is what a cell covers on
+// screen: cleared before its glyph is drawn and inverted when locked.
+// Codepoints are drawn from [first_codepoint, first_codepoint + codepoints).
+typedef struct
+{
+    uint8_t rows;
+    uint8_t columns;
+    uint8_t size;
+    uint8_t x;
+    uint8_t y;
+    uint8_t pitch_x;
+    uint8_t pitch_y;
+    uint8_t box_width;
+    uint8_t box_height;
+    uint8_t first_codepoint;
+    uint8_t codepoints;
+    uint8_t cycle_count;
+} crypto_grid_t;
+
+static const crypto_grid_t grids[CRYPTO_LEVELS] = {
+    // Size 2 glyphs are 12 wide, the last column is under the next cell
+    { 3, 11, 2, 5, 4, 11, 17, 11, 16, 1, 254, 6 },
+    { 5, 16, 1, 1, 1, 8, 11, 6, 8, 'A', 26, 12 },
+    { 7, 21, 1, 1, 0, 6, 8, 6, 8, '!', 64, 24 },
+};
 
 typedef struct
 {
     uint8_t codepoint;
     uint8_t state;
-} crypto_index_t;
+    // Unlocked cells sharing the codepoint
+    cell_index_t prev;
+    cell_index_t next;
+    // Position in crypto.unlocked
+    cell_index_t slot;
+} crypto_cell_t;
 
-typedef enum
+typedef struct
 {
-    CRYPTO_UNLOCK_ENTER,
-    CRYPTO_UNLOCK_STEP,
-    CRYPTO_UNLOCK_BLINK,
-    CRYPTO_UNLOCK_EXIT,
-    CRYPTO_UNLOCK_MAX
-} crypto_unlock_state_t;
-
-static crypto_index_t cell[CELLS];
-static crypto_unlock_state_t state;
-static uint32_t key_timer;
-static uint32_t cycle_timer;
+    coroutine_t co;
+    animation_t anim;
+    const crypto_grid_t* grid;
+    uint32_t key_cycle;
+    uint32_t cell_cycle;
+    int16_t visible;
+    cell_index_t cells;
+    // Unlocked cells, in no particular order
+    cell_index_t unlocked[MAX_CELLS];
+    cell_index_t unlocked_count;
+    // Cells to redraw, each only once
+    cell_index_t changed[MAX_CELLS];
+    cell_index_t changed_count;
+    // Codepoints of unlocked cells, the keys are picked from these
+    uint8_t codepoints[CODEPOINTS];
+    uint8_t codepoint_slot[CODEPOINTS];
+    uint16_t codepoint_count;
+    cell_index_t codepoint_head[CODEPOINTS];
+    // The key bar is in the background layer and only redrawn on rotation
+    bool keys_dirty;
+    // A game started without entering the state still sets up its layers
+    bool setup;
+    uint8_t pick;
+} crypto_unlock_t;
+
+static const tween_t cycle_tweens[] = {
+    { CYCLE_RATE_MS, 0, 0, EASE_STEP },
+};
+
+static const tween_t key_tweens[] = {
+    { KEY_ROTATE_MS, 0, 0, EASE_STEP },
+};
+
+// Locked cells flash between normal and inverted, as the overlay layer
+static const tween_t flash_tweens[] = {
+    { FLASH_RATE_MS, 0, 0, EASE_STEP },
+    { FLASH_RATE_MS, 1, 1, EASE_STEP },
+};
+
+static const track_t crypto_tracks[] = {
+    TRACK(cycle_tweens, ANIMATION_REPEAT_FOREVER),
+    TRACK(key_tweens, ANIMATION_REPEAT_FOREVER),
+    TRACK(flash_tweens, ANIMATION_REPEAT_FOREVER),
+};
+
+static const timeline_t crypto_timeline = TIMELINE(crypto_tracks);
+
+static crypto_cell_t cell[MAX_CELLS];
+static crypto_unlock_t crypto;
+static uint8_t crypto_level = CRYPTO_DEFAULT_LEVEL;
 static uint8_t key_codepoints[KEY_COUNT];
 static const uint8_t key_icons[KEY_COUNT] = {
     0x18, // Up Arrow
@@ -53,32 +146,151 @@ static const uint8_t key_icons[KEY_COUNT] = {
     0x19, // Down Arrow
 };
 static const uint8_t key_separator = 0x3A;
-static uint8_t buttons;
-static std::map<uint8_t, uint8_t> codepoint_set;
-static std::set<uint8_t> unlocked_set;
-static uint8_t blinks;
+static const char* const pick_names[PICK_CHOICES] = { "EASY", "NORMAL", "HARD", "CIPHER" };
+
+bool crypto_unlock_set_level(uint8_t level)
+{
+    if (level >= CRYPTO_LEVELS)
+    {
+        return false;
+    }
+    crypto_level = level;
+    return true;
+}
+
+uint8_t crypto_unlock_level()
+{
+    return crypto_level;
+}
+
+static uint8_t random_codepoint()
+{
+    return crypto.grid->first_codepoint + (rand() % crypto.grid->codepoints);
+}
+
+static void mark_changed(cell_index_t i)
+{
+    if (!(cell[i].state & CELL_STATE_CHANGED))
+    {
+        cell[i].state |= CELL_STATE_CHANGED;
+        crypto.changed[crypto.changed_count++] = i;
+    }
+}
+
+static void add_codepoint(uint8_t codepoint)
+{
+    crypto.codepoint_slot[codepoint] = crypto.codepoint_count;
+    crypto.codepoints[crypto.codepoint_count++] = codepoint;
+}
+
+static void remove_codepoint(uint8_t codepoint)
+{
+    uint8_t slot = crypto.codepoint_slot[codepoint];
+    uint8_t last = crypto.codepoints[--crypto.codepoint_count];
+    crypto.codepoints[slot] = last;
+    crypto.codepoint_slot[last] = slot;
+}
+
+// Add an unlocked cell to its codepoint's list
+static void link_cell(cell_index_t i)
+{
+    crypto_cell_t& c = cell[i];
+    cell_index_t head = crypto.codepoint_head[c.codepoint];
+    if (head == NO_CELL)
+    {
+        add_codepoint(c.codepoint);
+    }
+    else
+    {
+        cell[head].prev = i;
+    }
+    c.prev = NO_CELL;
+    c.next = head;
+    crypto.codepoint_head[c.codepoint] = i;
+}
+
+static void unlink_cell(cell_index_t i)
+{
+    crypto_cell_t& c = cell[i];
+    if (c.prev != NO_CELL)
+    {
+        cell[c.prev].next = c.next;
+    }
+    else
+    {
+        crypto.codepoint_head[c.codepoint] = c.next;
+    }
+    if (c.next != NO_CELL)
+    {
+        cell[c.next].prev = c.prev;
+    }
+    if (crypto.codepoint_head[c.codepoint] == NO_CELL)
+    {
+        remove_codepoint(c.codepoint);
+    }
+}
+
+static void swap_unlocked(cell_index_t a, cell_index_t b)
+{
+    cell_index_t i = crypto.unlocked[a];
+    cell_index_t j = crypto.unlocked[b];
+    crypto.unlocked[a] = j;
+    crypto.unlocked[b] = i;
+    cell[j].slot = a;
+    cell[i].slot = b;
+}
+
+static void remove_unlocked(cell_index_t i)
+{
+    swap_unlocked(cell[i].slot, crypto.unlocked_count - 1);
+    --crypto.unlocked_count;
+}
+
+// An unlocked cell is a glyph in the content layer. A locked one never
+// changes again, its glyph moves to the background layer and its box is
+// filled in the overlay, which inverts it while the overlay is shown.
+static void draw_cell(cell_index_t i)
+{
+    const crypto_grid_t* grid = crypto.grid;
+    int16_t x = grid->x + ((i % grid->columns) * grid->pitch_x);
+    int16_t y = grid->y + ((i / grid->columns) * grid->pitch_y);
+    crypto_cell_t& c = cell[i];
 
+    // Glyphs are drawn transparent over a cleared box, so they never
+    // touch a neighbouring cell
+    display->fillRect(x, y, grid->box_width, grid->box_height, MONOOLED_BLACK);
+    if (c.state & CELL_STATE_LOCKED)
+    {
+        layer_select(LAYER_BACKGROUND);
+        display->drawChar(x, y, (char)c.codepoint, MONOOLED_WHITE, MONOOLED_WHITE, grid->size);
+        layer_select(LAYER_OVERLAY);
+        display->fillRect(x, y, grid->box_width, grid->box_height, MONOOLED_WHITE);
+        layer_select(LAYER_CONTENT);
+    }
+    else
+    {
+        display->drawChar(x, y, (char)c.codepoint, MONOOLED_WHITE, MONOOLED_WHITE, grid->size);
+    }
+}
+
+// Only cells that changed since the last frame
 void draw_cells()
 {
-    // Reduce tick to 0 or 1
-    uint8_t tick = (millis() % (2 * FLASH_RATE_MS)) > FLASH_RATE_MS;
-    for(uint16_t i = 0; i < CELLS; ++i)
-    {
-        uint8_t x = 5 + ((i % CHARACTERS_PER_LINE) * 11);
-        uint8_t y = 4 + ((i / CHARACTERS_PER_LINE) * 17);
-        display->drawChar(x,
-                          y,
-                          (char)cell[i].codepoint,
-                          ((cell[i].state & CELL_STATE_LOCKED) && tick) ? MONOOLED_BLACK : MONOOLED_WHITE,
-                          ((cell[i].state & CELL_STATE_LOCKED) && tick) ? MONOOLED_WHITE : MONOOLED_BLACK,
-                          2);
+    for (cell_index_t n = 0; n < crypto.changed_count; ++n)
+    {
+        cell_index_t i = crypto.changed[n];
+        cell[i].state &= ~CELL_STATE_CHANGED;
+        draw_cell(i);
     }
+    crypto.changed_count = 0;
 }
 
+// Drawn over the previous keys, the glyph backgrounds erase them
 void draw_keys()
 {
-    uint8_t y = 57;
-    uint8_t x = 18;
+    layer_select(LAYER_BACKGROUND);
+    uint8_t y = KEY_BAR_Y;
+    uint8_t x = KEY_BAR_X;
     for (uint8_t i = 0; i < KEY_COUNT; ++i)
     {
         display->drawChar(x, y, key_icons[i], MONOOLED_WHITE, MONOOLED_BLACK, 1);
@@ -88,206 +300,292 @@ void draw_keys()
         display->drawChar(x, y, key_codepoints[i], MONOOLED_WHITE, MONOOLED_BLACK, 1);
         x += 23;
     }
+    layer_select(LAYER_CONTENT);
 }
 
-void redraw()
+// Walks the codepoint's own list, so it costs the cells that lock
+void lock_cells(uint8_t codepoint)
 {
-    display->clearDisplay();
+    if (codepoint == 0)
+    {
+        return;
+    }
+
+    cell_index_t i = crypto.codepoint_head[codepoint];
+    if (i == NO_CELL)
+    {
+        return;
+    }
+    while (i != NO_CELL)
+    {
+        cell_index_t next = cell[i].next;
+        cell[i].state |= CELL_STATE_LOCKED;
+        remove_unlocked(i);
+        mark_changed(i);
+        i = next;
+    }
+    crypto.codepoint_head[codepoint] = NO_CELL;
+    remove_codepoint(codepoint);
+}
+
+static uint8_t pick_codepoint()
+{
+    return crypto.codepoints[rand() % crypto.codepoint_count];
+}
+
+void rotate_keys()
+{
+    // Pick 3 random codepoints that are different
+    key_codepoints[UP_KEY] = 0;
+    key_codepoints[SEL_KEY] = 0;
+    key_codepoints[DOWN_KEY] = 0;
+
+    if (crypto.codepoint_count <= KEY_COUNT)
+    {
+        for (uint8_t i = UP_KEY; i < crypto.codepoint_count; ++i)
+        {
+            key_codepoints[i] = crypto.codepoints[i];
+        }
+    }
+    else
+    {
+        while((key_codepoints[UP_KEY] == 0) ||
+            (key_codepoints[UP_KEY] == key_codepoints[SEL_KEY]) ||
+            (key_codepoints[UP_KEY] == key_codepoints[DOWN_KEY]))
+        {
+            key_codepoints[UP_KEY] = pick_codepoint();
+        }
+
+        while((key_codepoints[SEL_KEY] == 0) ||
+            (key_codepoints[SEL_KEY] == key_codepoints[UP_KEY]) ||
+            (key_codepoints[SEL_KEY] == key_codepoints[DOWN_KEY]))
+        {
+            key_codepoints[SEL_KEY] = pick_codepoint();
+        }
+
+        while((key_codepoints[DOWN_KEY] == 0) ||
+            (key_codepoints[DOWN_KEY] == key_codepoints[UP_KEY]) ||
+            (key_codepoints[DOWN_KEY] == key_codepoints[SEL_KEY]))
+        {
+            key_codepoints[DOWN_KEY] = pick_codepoint();
+        }
+    }
+    crypto.keys_dirty = true;
+}
+
+void crypto_enter()
+{
+    Log("Crypto Unlock entered");
+    crypto.grid = &grids[crypto_level];
+    crypto.cells = crypto.grid->rows * crypto.grid->columns;
+    crypto.key_cycle = 0;
+    crypto.cell_cycle = 0;
+    animation_start(&crypto.anim, &crypto_timeline);
+
+    crypto.unlocked_count = 0;
+    crypto.changed_count = 0;
+    crypto.codepoint_count = 0;
+    for (uint16_t codepoint = 0; codepoint < CODEPOINTS; ++codepoint)
+    {
+        crypto.codepoint_head[codepoint] = NO_CELL;
+    }
+    for (cell_index_t i = 0; i < crypto.cells; ++i)
+    {
+        crypto_cell_t& c = cell[i];
+        c.codepoint = random_codepoint();
+        c.state = 0x00;
+        link_cell(i);
+        c.slot = crypto.unlocked_count;
+        crypto.unlocked[crypto.unlocked_count++] = i;
+    }
+    rotate_keys();
+    crypto.setup = true;
+}
+
+// Returns false once every cell is locked
+bool crypto_step(const render_context_t* ctx)
+{
+    if (ctx->released & BUTTON_UP_STATE_MASK)
+    {
+        Log("CU UP: %c", (char)key_codepoints[UP_KEY]);
+        lock_cells(key_codepoints[UP_KEY]);
+    }
+
+    if (ctx->released & BUTTON_SEL_STATE_MASK)
+    {
+        Log("CU SEL: %c", key_codepoints[SEL_KEY]);
+        lock_cells(key_codepoints[SEL_KEY]);
+    }
+
+    if (ctx->released & BUTTON_DOWN_STATE_MASK)
+    {
+        Log("CU DN: %c", key_codepoints[DOWN_KEY]);
+        lock_cells(key_codepoints[DOWN_KEY]);
+    }
+
+    if (animation_ticked(&crypto.anim, CYCLE_TRACK, &crypto.cell_cycle))
+    {
+        // Cycle up to cycle_count distinct unlocked cells, picked by
+        // shuffling them to the front of the unlocked list
+        cell_index_t count = min((cell_index_t)crypto.grid->cycle_count, crypto.unlocked_count);
+        if (count == 0)
+        {
+            return false;
+        }
+        for (cell_index_t n = 0; n < count; ++n)
+        {
+            swap_unlocked(n, n + (rand() % (crypto.unlocked_count - n)));
+            cell_index_t i = crypto.unlocked[n];
+            unlink_cell(i);
+            cell[i].codepoint = random_codepoint();
+            link_cell(i);
+            mark_changed(i);
+        }
+    }
+
+    if (animation_ticked(&crypto.anim, KEY_TRACK, &crypto.key_cycle))
+    {
+        rotate_keys();
+    }
+    return true;
+}
+
+// A game survives another state being pushed over it, not a pop
+static void crypto_leave(bool popped)
+{
+    if (popped)
+    {
+        CO_INIT(&crypto.co);
+    }
+}
+
+// Only changed cells and keys are drawn, the flash phase shows or hides
+// the overlay. The renderer composes the frame.
+bool crypto_draw(const render_context_t* ctx)
+{
+    if (ctx->entered || crypto.setup)
+    {
+        crypto.setup = false;
+        render_on_leave(crypto_leave);
+        layers_begin();
+        for (cell_index_t i = 0; i < crypto.cells; ++i)
+        {
+            mark_changed(i);
+        }
+        crypto.keys_dirty = true;
+    }
+    if (crypto.keys_dirty)
+    {
+        draw_keys();
+        crypto.keys_dirty = false;
+    }
     draw_cells();
-    draw_keys();
+    layer_set_visible(LAYER_OVERLAY, animation_int(&crypto.anim, FLASH_TRACK) != 0);
+    return false;
 }
 
-void lock_cells(uint8_t codepoint)
+// The whole screen blinks, as a screen sized highlight that is the
+// panel's invert command rather than a redraw
+bool crypto_blink()
 {
-    for(uint8_t i = 0; i < CELLS; ++i)
+    if (animation_changed(&crypto.anim, 0, &crypto.visible))
     {
-        crypto_index_t& index = cell[i];
-        if ((index.codepoint != 0) &&
-            (index.codepoint == codepoint))
+        highlight_set(!crypto.visible);
+    }
+    return false;
+}
+
+static void draw_pick()
+{
+    display->clearDisplay();
+    display->setTextSize(1);
+    display->setTextColor(MONOOLED_WHITE, MONOOLED_BLACK);
+    display->setCursor(0, 0);
+    display->print("UNLOCKED, REPLAY?");
+    for (uint8_t i = 0; i < PICK_CHOICES; ++i)
+    {
+        int16_t y = PICK_Y + (i * PICK_PITCH);
+        bool selected = (i == crypto.pick);
+        if (selected)
         {
-            index.state |= CELL_STATE_LOCKED;
-            codepoint_set[codepoint]--;
-            if (codepoint_set[codepoint] == 0)
-            {
-                codepoint_set.erase(codepoint);
-            }
-            unlocked_set.erase(i);
+            display->fillRect(0, y - 2, LCD_WIDTH, PICK_PITCH, MONOOLED_WHITE);
         }
+        display->setTextColor(selected ? MONOOLED_BLACK : MONOOLED_WHITE);
+        display->setCursor(8, y);
+        display->print(pick_names[i]);
+    }
+}
+
+// UP and DOWN move the choice, returns true if it was redrawn
+static bool pick_step(const render_context_t* ctx)
+{
+    bool changed = ctx->entered;
+    if (ctx->released & BUTTON_UP_STATE_MASK)
+    {
+        crypto.pick = (crypto.pick + PICK_CHOICES - 1) % PICK_CHOICES;
+        changed = true;
     }
+    if (ctx->released & BUTTON_DOWN_STATE_MASK)
+    {
+        crypto.pick = (crypto.pick + 1) % PICK_CHOICES;
+        changed = true;
+    }
+    if (changed)
+    {
+        draw_pick();
+    }
+    return changed;
 }
 
-void crypto_unlock_render(uint8_t* back_buffer)
+// Winning the game unlocks the cipher engine (and REGISTER READ). Once
+// unlocked a level can be picked to replay, or CIPHER skips the game.
+bool crypto_unlock_render(const render_context_t* ctx)
 {
-    switch(state)
-    {
-        case CRYPTO_UNLOCK_ENTER:
-            Log("Crypto Unlock entered");
-            buttons = get_buttons();
-            key_timer = 0;
-            cycle_timer = 0;
-            unlocked_set.clear();
-            codepoint_set.clear();
-            for(uint8_t i = 0; i < CELLS; ++i)
-            {
-                crypto_index_t& index = cell[i];
-                index.codepoint = 1 + (rand() % 254);
-                codepoint_set[index.codepoint]++;
-                index.state = 0x00;
-                unlocked_set.insert(i);
-            }
-            key_codepoints[UP_KEY] = 1 + (rand() % 254);
-            key_codepoints[DOWN_KEY] = 1 + (rand() % 254);
-            key_codepoints[SEL_KEY] = 1 + (rand() % 254);
-            state = CRYPTO_UNLOCK_STEP;
-            break;
-        case CRYPTO_UNLOCK_STEP:
-            {
-                uint8_t nbtn = get_buttons();
-                if (nbtn != buttons)
-                {
-                    if ((nbtn & BUTTON_UP_STATE_MASK)
-                        && !(buttons & BUTTON_UP_STATE_MASK))
-                    {
-                        Log("CU UP: %c", (char)key_codepoints[UP_KEY]);
-                        lock_cells(key_codepoints[UP_KEY]);
-                    }
-
-                    if ((nbtn & BUTTON_SEL_STATE_MASK)
-                        && !(buttons & BUTTON_SEL_STATE_MASK))
-                    {
-                        Log("CU SEL: %c", key_codepoints[SEL_KEY]);
-                        lock_cells(key_codepoints[SEL_KEY]);
-                    }
-
-                    if ((nbtn & BUTTON_DOWN_STATE_MASK)
-                        && !(buttons & BUTTON_DOWN_STATE_MASK))
-                    {
-                        Log("CU DN: %c", key_codepoints[DOWN_KEY]);
-                        lock_cells(key_codepoints[DOWN_KEY]);
-                    }
-                }
-                buttons = nbtn;
-
-                if ((millis() - cycle_timer) > CYCLE_RATE_MS)
-                {
-                    cycle_timer = millis();
-                    // Cycle all non-locked cells
-                    std::set<uint8_t> indices_to_shift;
-                    if (unlocked_set.size() <= CYCLE_COUNT)
-                    {
-                        indices_to_shift = unlocked_set;
-                    }
-                    else
-                    {
-                        std::set<uint8_t> possible_indices = unlocked_set;
-                        while (indices_to_shift.size() < CYCLE_COUNT)
-                        {
-                            // Pick a random element in unlocked set
-                            auto iter = possible_indices.begin();
-                            std::advance(iter, rand() % possible_indices.size());
-                            indices_to_shift.insert(*iter);
-                            possible_indices.erase(iter);
-                        }
-                    }
-                    if (indices_to_shift.size() == 0)
-                    {
-                        cycle_timer = millis();
-                        register_unlocked = true;
-                        state = CRYPTO_UNLOCK_BLINK;
-                        break;
-                    }
-                    for(uint16_t i : indices_to_shift)
-                    {
-                        // Check if cell was locked
-                        crypto_index_t& index = cell[i];
-                        // If no other elements share a codepoint, remove it from the set
-                        uint8_t count = 0;
-                        codepoint_set[index.codepoint]--;
-                        if (codepoint_set[index.codepoint] == 0)
-                        {
-                            codepoint_set.erase(index.codepoint);
-                        }
-                        index.codepoint = (rand() % 254) + 1;
-                        codepoint_set[index.codepoint]++;
-                    }
-                }
-
-                if ((millis() - key_timer) > KEY_ROTATE_MS)
-                {
-                    key_timer = millis();
-                    // Pick 3 random codepoints that are different
-                    key_codepoints[UP_KEY] = 0;
-                    key_codepoints[SEL_KEY] = 0;
-                    key_codepoints[DOWN_KEY] = 0;
-
-                    if (codepoint_set.size() <= 3)
-                    {
-                        auto iter = codepoint_set.begin();
-                        for (uint8_t i = UP_KEY; i < codepoint_set.size(); ++i)
-                        {
-                            key_codepoints[i] = (iter++)->first;
-                            if (iter == codepoint_set.end())
-                            {
-                                iter = codepoint_set.begin();
-                            }
-                        }
-                    }
-                    else
-                    {
-                        while((key_codepoints[UP_KEY] == 0) ||
-                            (key_codepoints[UP_KEY] == key_codepoints[SEL_KEY]) ||
-                            (key_codepoints[UP_KEY] == key_codepoints[DOWN_KEY]))
-                        {
-                            auto it = codepoint_set.begin();
-                            std::advance(it, rand() % codepoint_set.size());
-                            key_codepoints[UP_KEY] = it->first;
-                        }
-
-                        while((key_codepoints[SEL_KEY] == 0) ||
-                            (key_codepoints[SEL_KEY] == key_codepoints[UP_KEY]) ||
-                            (key_codepoints[SEL_KEY] == key_codepoints[DOWN_KEY]))
-                        {
-                            auto it = codepoint_set.begin();
-                            std::advance(it, rand() % codepoint_set.size());
-                            key_codepoints[SEL_KEY] = it->first;
-                        }
-
-                        while((key_codepoints[DOWN_KEY] == 0) ||
-                            (key_codepoints[DOWN_KEY] == key_codepoints[UP_KEY]) ||
-                            (key_codepoints[DOWN_KEY] == key_codepoints[SEL_KEY]))
-                        {
-                            auto it = codepoint_set.begin();
-                            std::advance(it, rand() % codepoint_set.size());
-                            key_codepoints[DOWN_KEY] = it->first;
-                        }
-                    }
-                }
-                redraw();
-            }
-            break;
-        case CRYPTO_UNLOCK_BLINK:
-            if ((millis() - cycle_timer) > BLINK_TIME)
-            {
-                cycle_timer = millis();
-                display->clearDisplay();
-                if ((blinks % 2) == 0)
-                {
-                    redraw();
-                }
-                ++blinks;
-                if (blinks >= (2*NBLINKS))
-                {
-                    state = CRYPTO_UNLOCK_EXIT;
-                }
-            }
-            break;
-        case CRYPTO_UNLOCK_EXIT:
-            blinks = 0;
-            pop_render_function();
-            state = CRYPTO_UNLOCK_ENTER;
-            break;
-        default:
-            pop_render_function();
-            break;
+    coroutine_t* co = &crypto.co;
+    CO_BEGIN(co);
+
+    if (register_unlocked)
+    {
+        render_on_leave(crypto_leave);
+        crypto.pick = crypto_level;
+        draw_pick();
+        CO_YIELD(co, true);
+        while (!(ctx->released & BUTTON_SEL_STATE_MASK))
+        {
+            CO_YIELD(co, pick_step(ctx));
+        }
+        if (crypto.pick != PICK_CIPHER)
+        {
+            // The game starts on the next frame, without the SEL release
+            crypto_unlock_set_level(crypto.pick);
+            CO_YIELD(co, false);
+        }
     }
+
+    if (!register_unlocked || (crypto.pick != PICK_CIPHER))
+    {
+        crypto_enter();
+        while (crypto_step(ctx))
+        {
+            CO_YIELD(co, crypto_draw(ctx));
+        }
+        register_unlocked = true;
+
+        // Back to the plain grid before the whole screen blinks
+        draw_cells();
+        layer_set_visible(LAYER_OVERLAY, false);
+        highlight_add(0, 0, LCD_WIDTH, LCD_HEIGHT);
+        animation_start(&crypto.anim, &ANIM_BLINK);
+        crypto.visible = 1;
+        CO_YIELD(co, true);
+        while (!animation_done(&crypto.anim))
+        {
+            CO_YIELD(co, crypto_blink());
+        }
+        highlight_clear();
+    }
+
+    pop_render_function();
+    push_render_function(&cipher_stream_render);
+    CO_END(co);
 }
@@ -1,8 +1,25 @@
 #ifndef CRYPTO_UNLOCK_H_
 #define CRYPTO_UNLOCK_H_
 
+#include "renderer.h"
+
 #include <stdint.h>
 
-void crypto_unlock_render(uint8_t* buffer);
+// Grid sizes, from a few large glyphs to every size 1 cell above the keys
+typedef enum
+{
+    CRYPTO_LEVEL_EASY = 0,
+    CRYPTO_LEVEL_NORMAL,
+    CRYPTO_LEVEL_HARD,
+    CRYPTO_LEVELS
+} crypto_level_t;
+
+#define CRYPTO_DEFAULT_LEVEL CRYPTO_LEVEL_EASY
+
+// Used from the next game on, false for an unknown level
+bool crypto_unlock_set_level(uint8_t level);
+uint8_t crypto_unlock_level();
+
+bool crypto_unlock_render(const render_context_t* ctx);
 
 #endif // CRYPTO_UNLOCK_H_
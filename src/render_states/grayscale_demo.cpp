@@ -0,0 +1,97 @@
+#include "grayscale_demo.h"
+
+#include "buttons.h"
+#include "coroutine.h"
+#include "grayscale.h"
+#include "images.h"
+#include "renderer.h"
+#include "utility.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define BAR_HEIGHT 14
+#define LOGO_Y 16
+#define READOUT_Y 56
+#define READOUT_HEIGHT 8
+#define READOUT_MS 1000
+
+typedef struct
+{
+    coroutine_t co;
+    uint32_t timer;
+} grayscale_demo_t;
+
+static grayscale_demo_t demo;
+
+static void draw_gray_scene()
+{
+    uint8_t bar_width = LCD_WIDTH / GRAYSCALE_LEVELS;
+    for (uint8_t level = 0; level < GRAYSCALE_LEVELS; ++level)
+    {
+        grayscale_fill_rect(level * bar_width, 0, bar_width, BAR_HEIGHT, level);
+    }
+    for (uint8_t level = GRAYSCALE_LEVELS - 1; level > 0; --level)
+    {
+        int16_t x = (GRAYSCALE_LEVELS - 1 - level) * DI_SMALL.width;
+        grayscale_draw_image(&DI_SMALL, x, LOGO_Y, 1, level);
+    }
+}
+
+// Achieved against requested plane rate, so a slow bus shows up on screen
+static void draw_gray_readout()
+{
+    const grayscale_stats_t* stats = grayscale_stats();
+    char text[22];
+    snprintf(text, sizeof(text), "%u/%uHZ %luUS",
+             stats->plane_rate,
+             stats->target_rate,
+             (unsigned long)stats->flush_us);
+
+    display->fillRect(0, READOUT_Y, LCD_WIDTH, READOUT_HEIGHT, MONOOLED_BLACK);
+    grayscale_fill_rect(0, READOUT_Y, LCD_WIDTH, READOUT_HEIGHT, 0);
+    display->setTextColor(MONOOLED_WHITE, MONOOLED_BLACK);
+    display->setTextSize(1);
+    display->setCursor(0, READOUT_Y);
+    display->print(text);
+    grayscale_capture(GRAYSCALE_LEVELS - 1);
+
+    Log("Grayscale: %u/%u planes/s, %lu late, %lu us flush",
+        stats->plane_rate,
+        stats->target_rate,
+        (unsigned long)stats->late,
+        (unsigned long)stats->flush_us);
+}
+
+// The planes must stop driving the panel however the demo is left
+static void grayscale_demo_leave(bool popped)
+{
+    UNUSED(popped);
+    grayscale_end();
+    CO_INIT(&demo.co);
+}
+
+bool grayscale_demo_render(const render_context_t* ctx)
+{
+    coroutine_t* co = &demo.co;
+    CO_BEGIN(co);
+
+    display->clearDisplay();
+    grayscale_begin(GRAYSCALE_DEFAULT_HZ);
+    render_on_leave(grayscale_demo_leave);
+    draw_gray_scene();
+    demo.timer = ctx->now;
+
+    while (!(ctx->released & BUTTON_SEL_STATE_MASK))
+    {
+        if ((ctx->now - demo.timer) >= READOUT_MS)
+        {
+            demo.timer = ctx->now;
+            draw_gray_readout();
+        }
+        CO_YIELD(co, false);
+    }
+
+    pop_render_function();
+    CO_END(co);
+}
@@ -0,0 +1,10 @@
+#ifndef GRAYSCALE_DEMO_H_
+#define GRAYSCALE_DEMO_H_
+
+#include "renderer.h"
+
+#include <stdint.h>
+
+bool grayscale_demo_render(const render_context_t* ctx);
+
+#endif // GRAYSCALE_DEMO_H_
@@ -0,0 +1,99 @@
+#include "log_ticker.h"
+
+#include "buttons.h"
+#include "coroutine.h"
+#include "renderer.h"
+#include "scroll_console.h"
+#include "utility.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SCROLL_PX_PER_S 64
+#define UPTIME_MS 5000
+#define LINE_GAP "   "
+#define TITLE "LOG TICKER"
+
+typedef struct
+{
+    coroutine_t co;
+    // Scrolled pixels times 1000, carried between frames
+    uint32_t scroll;
+    uint32_t uptime_at;
+} log_ticker_t;
+
+static log_ticker_t ticker;
+
+static void queue_line(const char* line)
+{
+    uint8_t lane = 0;
+    for (uint8_t i = 1; i < SCROLL_CONSOLE_LANES; ++i)
+    {
+        if (scroll_console_pending(i) < scroll_console_pending(lane))
+        {
+            lane = i;
+        }
+    }
+    if (scroll_console_print(lane, line) > 0)
+    {
+        scroll_console_print(lane, LINE_GAP);
+    }
+}
+
+static void queue_uptime(uint32_t now)
+{
+    char text[16];
+    snprintf(text, sizeof(text), "UP %lus", (unsigned long)(now / 1000));
+    queue_line(text);
+}
+
+static void log_ticker_leave(bool popped)
+{
+    UNUSED(popped);
+    log_set_listener(NULL);
+    scroll_console_end();
+    CO_INIT(&ticker.co);
+}
+
+bool log_ticker_render(const render_context_t* ctx)
+{
+    coroutine_t* co = &ticker.co;
+    CO_BEGIN(co);
+
+    // The transition composes the frame, scrolling starts once it is over
+    display->clearDisplay();
+    display->setTextColor(MONOOLED_WHITE, MONOOLED_BLACK);
+    display->setTextSize(1);
+    display->setCursor((LCD_WIDTH - (sizeof(TITLE) - 1) * SCROLL_CONSOLE_CHAR_WIDTH) / 2, (LCD_HEIGHT - 8) / 2);
+    display->print(TITLE);
+    CO_YIELD(co, true);
+    CO_AWAIT(co, !render_transitioning());
+
+    scroll_console_begin();
+    render_on_leave(log_ticker_leave);
+    log_set_listener(queue_line);
+    ticker.scroll = 0;
+    ticker.uptime_at = ctx->now;
+    queue_line(TITLE);
+
+    while (!(ctx->released & BUTTON_SEL_STATE_MASK))
+    {
+        if ((ctx->now - ticker.uptime_at) >= UPTIME_MS)
+        {
+            ticker.uptime_at = ctx->now;
+            queue_uptime(ctx->now);
+        }
+        ticker.scroll += ctx->delta * SCROLL_PX_PER_S;
+        if (ticker.scroll >= 1000)
+        {
+            uint16_t columns = ticker.scroll / 1000;
+            ticker.scroll -= columns * 1000UL;
+            scroll_console_advance(columns);
+        }
+        // The console flushes the columns it scrolled itself
+        CO_YIELD(co, false);
+    }
+
+    pop_render_function();
+    CO_END(co);
+}
@@ -0,0 +1,14 @@
+#ifndef LOG_TICKER_H_
+#define LOG_TICKER_H_
+
+#include "renderer.h"
+
+#include <stdint.h>
+
+// Log() lines scrolling across the screen on the hardware scrolled
+// console (see scroll_console.h), each line on the least busy lane. The
+// uptime is queued every few seconds so the ticker moves while the log is
+// quiet. SEL leaves.
+bool log_ticker_render(const render_context_t* ctx);
+
+#endif // LOG_TICKER_H_
@@ -1,8 +1,11 @@
 #ifndef MAIN_MENU_H_
 #define MAIN_MENU_H_
 
+#include "renderer.h"
+
 #include <stdint.h>
 
-void main_menu_render(uint8_t* buffer);
+// Returns false when the menu did not change this frame
+bool main_menu_render(const render_context_t* ctx);
 
 #endif // SPLASH_SCREEN_H_
@@ -1,294 +1,301 @@
 #include "register_read.h"
 
-bool register_unlocked = false;
-
 #include "buttons.h"
+#include "coroutine.h"
 #include "renderer.h"
 #include "utility.h"
 
-#include <algorithm>
-#include <map>
-#include <queue>
-#include <set>
-
-#define KEY_ROTATE_MS 5000
-#define CYCLE_RATE_MS 1000
-#define FLASH_RATE_MS 500
-#define CYCLE_COUNT 6
-#define CELL_STATE_LOCKED 0x01
-#define CHARACTERS_PER_LINE 11
-#define UP_KEY 0
-#define DOWN_KEY 2
-#define SEL_KEY 1
-#define KEY_COUNT 3
-#define NBLINKS 5
-#define BLINK_TIME 250
-
-static const uint8_t ROWS = 3;
-static const uint8_t COLUMNS = CHARACTERS_PER_LINE;
-static const uint16_t CELLS = ROWS * COLUMNS;
+#include <stdint.h>
+
+#define REGISTER_READ_FPS 40
+#define DENIED_MS 1000
+#define EXIT_HOLD_MS 1000
+#define REPEAT_DELAY_MS 400
+#define REPEAT_MS 60
+// Held scrolls speed up: single rows, then pages, then 0x100 bytes per
+// step, so the far end of SRAM (0x2000 rows) is seconds away
+#define REPEAT_PAGE_AFTER 8
+#define REPEAT_FAST_AFTER 24
+#define REPEAT_FAST_ROWS 64
+
+#define CHAR_WIDTH 6
+#define CHAR_HEIGHT 8
+#define DATA_ROWS 7
+#define BYTES_PER_ROW 4
+
+#define OFFSET_COLUMN 0
+#define HEX_COLUMN 5
+#define ASCII_COLUMN 14
+
+// SAMD21 memory map
+#define SRAM_BASE       0x20000000
+#define SRAM_SIZE       0x8000
+#define PM_BASE         0x40000400
+#define SYSCTRL_BASE    0x40000800
+#define GCLK_BASE       0x40000C00
+#define WDT_BASE        0x40001000
+#define RTC_BASE        0x40001400
+#define EIC_BASE        0x40001800
+#define NVMCTRL_BASE    0x41004000
+#define PORT_BASE       0x41004400
 
 typedef struct
 {
-    uint8_t codepoint;
-    uint8_t state;
-} crypto_index_t;
+    const char* name;
+    uint32_t base;
+    uint32_t size;
+} memory_region_t;
 
-typedef enum
-{
-    REGISTER_READ_ENTER,
-    REGISTER_READ_STREAM,
-    REGISTER_READ_BLINK,
-    REGISTER_READ_EXIT,
-    REGISTER_READ_MAX
-} crypto_unlock_state_t;
-
-static crypto_index_t cell[CELLS];
-static crypto_unlock_state_t state;
-static uint32_t key_timer;
-static uint32_t cycle_timer;
-static uint8_t key_codepoints[KEY_COUNT];
-static const uint8_t key_icons[KEY_COUNT] = {
-    0x18, // Up Arrow
-    0x1A, // Right Arrow
-    0x19, // Down Arrow
+// Regions that are always clocked and have no read side effects
+static const memory_region_t regions[] = {
+    { "SRAM", SRAM_BASE, SRAM_SIZE },
+    { "PORT", PORT_BASE, 0x100 },
+    { "PM", PM_BASE, 0x20 },
+    { "SYSCTRL", SYSCTRL_BASE, 0x40 },
+    { "GCLK", GCLK_BASE, 0x10 },
+    { "WDT", WDT_BASE, 0x10 },
+    { "RTC", RTC_BASE, 0x20 },
+    { "EIC", EIC_BASE, 0x20 },
+    { "NVMCTRL", NVMCTRL_BASE, 0x20 },
 };
-static const uint8_t key_separator = 0x3A;
-static uint8_t buttons;
-static std::map<uint8_t, uint8_t> codepoint_set;
-static std::set<uint8_t> unlocked_set;
-static uint8_t blinks;
 
-void draw_cells()
+#define REGION_COUNT (sizeof(regions) / sizeof(regions[0]))
+
+typedef struct
 {
-    // Reduce tick to 0 or 1
-    uint8_t tick = (millis() % (2 * FLASH_RATE_MS)) > FLASH_RATE_MS;
-    for(uint16_t i = 0; i < CELLS; ++i)
-    {
-        uint8_t x = 5 + ((i % CHARACTERS_PER_LINE) * 11);
-        uint8_t y = 4 + ((i / CHARACTERS_PER_LINE) * 17);
-        display->drawChar(x,
-                          y,
-                          (char)cell[i].codepoint,
-                          ((cell[i].state & CELL_STATE_LOCKED) && tick) ? MONOOLED_BLACK : MONOOLED_WHITE,
-                          ((cell[i].state & CELL_STATE_LOCKED) && tick) ? MONOOLED_WHITE : MONOOLED_BLACK,
-                          2);
-    }
+    coroutine_t co;
+    uint8_t region;
+    uint32_t offset;
+    uint8_t previous_fps;
+    bool fps_raised;
+    uint32_t sel_down;
+    uint32_t repeat_at;
+    uint8_t repeats;
+    // Bytes currently on screen, only cells that differ are redrawn
+    uint8_t shown[DATA_ROWS][BYTES_PER_ROW];
+    bool shown_valid;
+    uint16_t cells_drawn;
+} register_read_t;
+
+static register_read_t reader;
+
+bool register_unlocked = false;
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+static void draw_text_char(uint8_t column, uint8_t row, char c)
+{
+    display->drawChar(column * CHAR_WIDTH, row * CHAR_HEIGHT, c, MONOOLED_WHITE, MONOOLED_BLACK, 1);
 }
 
-void draw_keys()
+static void draw_hex(uint8_t column, uint8_t row, uint32_t value, uint8_t digits)
 {
-    uint8_t y = 57;
-    uint8_t x = 18;
-    for (uint8_t i = 0; i < KEY_COUNT; ++i)
+    for (uint8_t i = 0; i < digits; ++i)
     {
-        display->drawChar(x, y, key_icons[i], MONOOLED_WHITE, MONOOLED_BLACK, 1);
-        x += 7;
-        display->drawChar(x, y, key_separator, MONOOLED_WHITE, MONOOLED_BLACK, 1);
-        x += 7;
-        display->drawChar(x, y, key_codepoints[i], MONOOLED_WHITE, MONOOLED_BLACK, 1);
-        x += 23;
+        uint8_t shift = (digits - 1 - i) * 4;
+        draw_text_char(column + i, row, hex_digits[(value >> shift) & 0x0F]);
     }
 }
 
-void redraw()
+static void draw_title()
 {
-    display->clearDisplay();
-    draw_cells();
-    draw_keys();
+    const memory_region_t& region = regions[reader.region];
+    display->fillRect(0, 0, LCD_WIDTH, CHAR_HEIGHT, MONOOLED_BLACK);
+    display->setTextColor(MONOOLED_WHITE, MONOOLED_BLACK);
+    display->setCursor(0, 0);
+    display->print(region.name);
+    draw_hex(10, 0, region.base + reader.offset, 8);
 }
 
-void lock_cells(uint8_t codepoint)
+static void draw_cell(uint8_t row, uint8_t index, uint8_t value)
 {
-    for(uint8_t i = 0; i < CELLS; ++i)
+    uint8_t line = row + 1;
+    draw_hex(HEX_COLUMN + (index * 2), line, value, 2);
+    char c = ((value >= 0x20) && (value < 0x7F)) ? (char)value : '.';
+    draw_text_char(ASCII_COLUMN + index, line, c);
+    ++reader.cells_drawn;
+}
+
+// Read the visible window and redraw only the cells that changed
+static bool update_cells()
+{
+    const memory_region_t& region = regions[reader.region];
+    bool changed = false;
+    reader.cells_drawn = 0;
+
+    for (uint8_t row = 0; row < DATA_ROWS; ++row)
     {
-        crypto_index_t& index = cell[i];
-        if ((index.codepoint != 0) &&
-            (index.codepoint == codepoint))
+        uint32_t offset = reader.offset + (row * BYTES_PER_ROW);
+        if (offset >= region.size)
         {
-            index.state |= CELL_STATE_LOCKED;
-            codepoint_set[codepoint]--;
-            if (codepoint_set[codepoint] == 0)
+            if (!reader.shown_valid)
             {
-                codepoint_set.erase(codepoint);
+                display->fillRect(0, (row + 1) * CHAR_HEIGHT, LCD_WIDTH, CHAR_HEIGHT, MONOOLED_BLACK);
+                changed = true;
+            }
+            continue;
+        }
+
+        // One aligned word per row, peripherals are read a register at a time
+        uint32_t word = *(volatile const uint32_t*)(uintptr_t)(region.base + offset);
+        if (!reader.shown_valid)
+        {
+            draw_hex(OFFSET_COLUMN, row + 1, offset, 4);
+            draw_text_char(OFFSET_COLUMN + 4, row + 1, ':');
+        }
+
+        for (uint8_t i = 0; i < BYTES_PER_ROW; ++i)
+        {
+            uint8_t value = (uint8_t)(word >> (i * 8));
+            if (!reader.shown_valid || (reader.shown[row][i] != value))
+            {
+                reader.shown[row][i] = value;
+                draw_cell(row, i, value);
+                changed = true;
             }
-            unlocked_set.erase(i);
         }
     }
+    reader.shown_valid = true;
+    return changed;
 }
 
-void crypto_unlock_render(uint8_t* back_buffer)
+static void scroll_rows(int8_t rows)
 {
-    switch(state)
+    const memory_region_t& region = regions[reader.region];
+    int32_t offset = (int32_t)reader.offset + ((int32_t)rows * BYTES_PER_ROW);
+    int32_t last = (int32_t)region.size - (DATA_ROWS * BYTES_PER_ROW);
+    if (last < 0)
     {
-        case CRYPTO_UNLOCK_ENTER:
-            Log("Crypto Unlock entered");
-            buttons = get_buttons();
-            key_timer = 0;
-            cycle_timer = 0;
-            unlocked_set.clear();
-            codepoint_set.clear();
-            for(uint8_t i = 0; i < CELLS; ++i)
-            {
-                crypto_index_t& index = cell[i];
-                index.codepoint = 1 + (rand() % 254);
-                codepoint_set[index.codepoint]++;
-                index.state = 0x00;
-                unlocked_set.insert(i);
-            }
-            key_codepoints[UP_KEY] = 1 + (rand() % 254);
-            key_codepoints[DOWN_KEY] = 1 + (rand() % 254);
-            key_codepoints[SEL_KEY] = 1 + (rand() % 254);
-            state = CRYPTO_UNLOCK_STEP;
-            break;
-        case CRYPTO_UNLOCK_STEP:
-            {
-                uint8_t nbtn = get_buttons();
-                if (nbtn != buttons)
-                {
-                    if ((nbtn & BUTTON_UP_STATE_MASK)
-                        && !(buttons & BUTTON_UP_STATE_MASK))
-                    {
-                        Log("CU UP: %c", (char)key_codepoints[UP_KEY]);
-                        lock_cells(key_codepoints[UP_KEY]);
-                    }
-
-                    if ((nbtn & BUTTON_SEL_STATE_MASK)
-                        && !(buttons & BUTTON_SEL_STATE_MASK))
-                    {
-                        Log("CU SEL: %c", key_codepoints[SEL_KEY]);
-                        lock_cells(key_codepoints[SEL_KEY]);
-                    }
-
-                    if ((nbtn & BUTTON_DOWN_STATE_MASK)
-                        && !(buttons & BUTTON_DOWN_STATE_MASK))
-                    {
-                        Log("CU DN: %c", key_codepoints[DOWN_KEY]);
-                        lock_cells(key_codepoints[DOWN_KEY]);
-                    }
-                }
-                buttons = nbtn;
-
-                if ((millis() - cycle_timer) > CYCLE_RATE_MS)
-                {
-                    cycle_timer = millis();
-                    // Cycle all non-locked cells
-                    std::set<uint8_t> indices_to_shift;
-                    if (unlocked_set.size() <= CYCLE_COUNT)
-                    {
-                        indices_to_shift = unlocked_set;
-                    }
-                    else
-                    {
-                        std::set<uint8_t> possible_indices = unlocked_set;
-                        while (indices_to_shift.size() < CYCLE_COUNT)
-                        {
-                            // Pick a random element in unlocked set
-                            auto iter = possible_indices.begin();
-                            std::advance(iter, rand() % possible_indices.size());
-                            indices_to_shift.insert(*iter);
-                            possible_indices.erase(iter);
-                        }
-                    }
-                    if (indices_to_shift.size() == 0)
-                    {
-                        cycle_timer = millis();
-                        register_unlocked = true;
-                        state = CRYPTO_UNLOCK_BLINK;
-                        break;
-                    }
-                    for(uint16_t i : indices_to_shift)
-                    {
-                        // Check if cell was locked
-                        crypto_index_t& index = cell[i];
-                        // If no other elements share a codepoint, remove it from the set
-                        uint8_t count = 0;
-                        codepoint_set[index.codepoint]--;
-                        if (codepoint_set[index.codepoint] == 0)
-                        {
-                            codepoint_set.erase(index.codepoint);
-                        }
-                        index.codepoint = (rand() % 254) + 1;
-                        codepoint_set[index.codepoint]++;
-                    }
-                }
-
-                if ((millis() - key_timer) > KEY_ROTATE_MS)
-                {
-                    key_timer = millis();
-                    // Pick 3 random codepoints that are different
-                    key_codepoints[UP_KEY] = 0;
-                    key_codepoints[SEL_KEY] = 0;
-                    key_codepoints[DOWN_KEY] = 0;
-
-                    if (codepoint_set.size() <= 3)
-                    {
-                        auto iter = codepoint_set.begin();
-                        for (uint8_t i = UP_KEY; i < codepoint_set.size(); ++i)
-                        {
-                            key_codepoints[i] = (iter++)->first;
-                            if (iter == codepoint_set.end())
-                            {
-                                iter = codepoint_set.begin();
-                            }
-                        }
-                    }
-                    else
-                    {
-                        while((key_codepoints[UP_KEY] == 0) ||
-                            (key_codepoints[UP_KEY] == key_codepoints[SEL_KEY]) ||
-                            (key_codepoints[UP_KEY] == key_codepoints[DOWN_KEY]))
-                        {
-                            auto it = codepoint_set.begin();
-                            std::advance(it, rand() % codepoint_set.size());
-                            key_codepoints[UP_KEY] = it->first;
-                        }
-
-                        while((key_codepoints[SEL_KEY] == 0) ||
-                            (key_codepoints[SEL_KEY] == key_codepoints[UP_KEY]) ||
-                            (key_codepoints[SEL_KEY] == key_codepoints[DOWN_KEY]))
-                        {
-                            auto it = codepoint_set.begin();
-                            std::advance(it, rand() % codepoint_set.size());
-                            key_codepoints[SEL_KEY] = it->first;
-                        }
-
-                        while((key_codepoints[DOWN_KEY] == 0) ||
-                            (key_codepoints[DOWN_KEY] == key_codepoints[UP_KEY]) ||
-                            (key_codepoints[DOWN_KEY] == key_codepoints[SEL_KEY]))
-                        {
-                            auto it = codepoint_set.begin();
-                            std::advance(it, rand() % codepoint_set.size());
-                            key_codepoints[DOWN_KEY] = it->first;
-                        }
-                    }
-                }
-                redraw();
-            }
-            break;
-        case CRYPTO_UNLOCK_BLINK:
-            if ((millis() - cycle_timer) > BLINK_TIME)
-            {
-                cycle_timer = millis();
-                display->clearDisplay();
-                if ((blinks % 2) == 0)
-                {
-                    redraw();
-                }
-                ++blinks;
-                if (blinks >= (2*NBLINKS))
-                {
-                    state = CRYPTO_UNLOCK_EXIT;
-                }
-            }
-            break;
-        case CRYPTO_UNLOCK_EXIT:
-            blinks = 0;
-            pop_render_function();
-            state = CRYPTO_UNLOCK_ENTER;
-            break;
-        default:
-            pop_render_function();
-            break;
+        last = 0;
     }
+    if (offset < 0)
+    {
+        offset = 0;
+    }
+    if (offset > last)
+    {
+        offset = last;
+    }
+
+    if ((uint32_t)offset != reader.offset)
+    {
+        reader.offset = offset;
+        reader.shown_valid = false;
+        draw_title();
+    }
+}
+
+static void select_region(uint8_t region)
+{
+    reader.region = region % REGION_COUNT;
+    reader.offset = 0;
+    reader.shown_valid = false;
+    draw_title();
+}
+
+// Returns false when the viewer should exit
+static bool handle_input(const render_context_t* ctx)
+{
+    if (ctx->pressed & BUTTON_SEL_STATE_MASK)
+    {
+        reader.sel_down = ctx->now;
+    }
+    if (ctx->released & BUTTON_SEL_STATE_MASK)
+    {
+        if ((ctx->now - reader.sel_down) >= EXIT_HOLD_MS)
+        {
+            return false;
+        }
+        select_region(reader.region + 1);
+    }
+
+    int8_t direction = 0;
+    if (ctx->pressed & BUTTON_UP_STATE_MASK)
+    {
+        direction = -1;
+        reader.repeat_at = ctx->now + REPEAT_DELAY_MS;
+        reader.repeats = 0;
+    }
+    else if (ctx->pressed & BUTTON_DOWN_STATE_MASK)
+    {
+        direction = 1;
+        reader.repeat_at = ctx->now + REPEAT_DELAY_MS;
+        reader.repeats = 0;
+    }
+    else if ((int32_t)(ctx->now - reader.repeat_at) >= 0)
+    {
+        // Buttons read 0 while held
+        if (!(ctx->buttons & BUTTON_UP_STATE_MASK))
+        {
+            direction = -1;
+        }
+        else if (!(ctx->buttons & BUTTON_DOWN_STATE_MASK))
+        {
+            direction = 1;
+        }
+        reader.repeat_at = ctx->now + REPEAT_MS;
+        if ((direction != 0) && (reader.repeats < REPEAT_FAST_AFTER))
+        {
+            ++reader.repeats;
+        }
+        if (reader.repeats >= REPEAT_FAST_AFTER)
+        {
+            direction *= REPEAT_FAST_ROWS;
+        }
+        else if (reader.repeats >= REPEAT_PAGE_AFTER)
+        {
+            direction *= DATA_ROWS;
+        }
+    }
+
+    if (direction != 0)
+    {
+        scroll_rows(direction);
+    }
+    return true;
+}
+
+static void register_read_leave(bool popped)
+{
+    UNUSED(popped);
+    if (reader.fps_raised)
+    {
+        render_set_target_fps(reader.previous_fps);
+        reader.fps_raised = false;
+    }
+    CO_INIT(&reader.co);
+}
+
+bool register_read_render(const render_context_t* ctx)
+{
+    coroutine_t* co = &reader.co;
+    CO_BEGIN(co);
+
+    render_on_leave(register_read_leave);
+    display->clearDisplay();
+    if (!register_unlocked)
+    {
+        display->setTextColor(MONOOLED_WHITE, MONOOLED_BLACK);
+        display->setTextSize(1);
+        display->setCursor(28, 28);
+        display->print("ACCESS DENIED");
+        CO_AWAIT_MS(co, ctx, DENIED_MS);
+    }
+    else
+    {
+        reader.previous_fps = render_target_fps();
+        render_set_target_fps(REGISTER_READ_FPS);
+        reader.fps_raised = true;
+        reader.sel_down = ctx->now;
+        reader.repeat_at = ctx->now;
+        select_region(0);
+
+        while (handle_input(ctx))
+        {
+            CO_YIELD(co, update_cells());
+        }
+    }
+
+    pop_render_function();
+    CO_END(co);
 }
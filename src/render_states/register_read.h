@@ -1,6 +1,12 @@
 #ifndef REGISTER_READ_H
 #define REGISTER_READ_H
 
+#include "renderer.h"
+
 extern bool register_unlocked;
 
+// Live hex/ASCII view of RAM and peripheral registers, UP/DN scroll,
+// SEL switches region and holding SEL leaves
+bool register_read_render(const render_context_t* ctx);
+
 #endif // REGISTER_READ_H
@@ -1,5 +1,9 @@
 #include "self_test.h"
 
+#include "animation.h"
+#include "coroutine.h"
+#include "highlight.h"
+#include "layers.h"
 #include "renderer.h"
 #include "utility.h"
 
@@ -13,134 +17,189 @@
 #define CHAR_HEIGHT 8
 #define CHARACTERS_PER_LINE 18
 #define LINES 7
-#define LOCK_IN_ACCELERATION 2
+#define CELLS (CHARACTERS_PER_LINE * LINES)
+#define LOCK_IN_RATE_MS 2
 #define LOCKS_PER_ACC 16
 #define UNLOCKED 0
 #define ROTATION_RATE 100
-#define NBLINKS 5
-#define BLINK_TIME 250
+
+#define ROTATION_TRACK 0
+#define LOCK_IN_TRACK 1
 
 #define COL(i) (i%CHARACTERS_PER_LINE)
 #define ROW(i) (i/CHARACTERS_PER_LINE)
 
-typedef enum
-{
-    SELF_TEST_ENTER,
-    SELF_TEST_RUN,
-    SELF_TEST_BLINK,
-    SELF_TEST_EXIT
-} self_test_state_t;
-
 typedef struct
 {
     uint8_t index;
     uint8_t value;
 } lock_in_t;
 
-// Each byte represents one column
-static self_test_state_t state = SELF_TEST_ENTER;
+typedef struct
+{
+    coroutine_t co;
+    animation_t anim;
+    std::deque<lock_in_t> lock_in;
+    uint32_t rotation;
+    uint16_t locked;
+    int16_t visible;
+} self_test_t;
+
+// Lock-in rate halves every LOCKS_PER_ACC + 1 cells
+#define LOCK_IN_GROUP (LOCKS_PER_ACC + 1)
+#define LOCK_IN_STAGE(n) { (uint16_t)(LOCK_IN_GROUP * (LOCK_IN_RATE_MS << (n))), \
+                           (int16_t)((n) * LOCK_IN_GROUP), \
+                           (int16_t)(((n) + 1) * LOCK_IN_GROUP), \
+                           EASE_LINEAR }
+
+static const tween_t rotation_tweens[] = {
+    { ROTATION_RATE, 0, 0, EASE_STEP },
+};
+
+static const tween_t lock_in_tweens[] = {
+    LOCK_IN_STAGE(0),
+    LOCK_IN_STAGE(1),
+    LOCK_IN_STAGE(2),
+    LOCK_IN_STAGE(3),
+    LOCK_IN_STAGE(4),
+    LOCK_IN_STAGE(5),
+    LOCK_IN_STAGE(6),
+    LOCK_IN_STAGE(7),
+};
+
+static const track_t self_test_tracks[] = {
+    TRACK(rotation_tweens, ANIMATION_REPEAT_FOREVER),
+    TRACK(lock_in_tweens, 1),
+};
+
+static const timeline_t self_test_timeline = TIMELINE(self_test_tracks);
+
+static self_test_t self_test;
+
+static void draw_cell(const lock_in_t& cell, uint8_t value)
+{
+    uint8_t x = COL(cell.index) * (CHAR_WIDTH + 1);
+    uint8_t y = ROW(cell.index) * (CHAR_HEIGHT + 1);
+    display->drawChar(x, y, (char)value, MONOOLED_WHITE, MONOOLED_BLACK, 1);
+}
 
+// A locked value no longer changes, it moves from the content layer to
+// the background layer and is not drawn again
+static void lock_cell(const lock_in_t& cell)
+{
+    uint8_t x = COL(cell.index) * (CHAR_WIDTH + 1);
+    uint8_t y = ROW(cell.index) * (CHAR_HEIGHT + 1);
+    display->fillRect(x, y, CHAR_WIDTH, CHAR_HEIGHT, MONOOLED_BLACK);
+    layer_select(LAYER_BACKGROUND);
+    draw_cell(cell, cell.value);
+    layer_select(LAYER_CONTENT);
+}
+
+// Only the unlocked cells rotate, drawn over their previous values
 void render_lock_in(std::deque<lock_in_t>& lock_in)
 {
-    for (uint16_t i = 0; i < CHARACTERS_PER_LINE * LINES; ++i)
+    for (uint16_t i = 0; i < CELLS; ++i)
     {
-        uint8_t x = COL(lock_in[i].index) * (CHAR_WIDTH + 1);
-        uint8_t y = ROW(lock_in[i].index) * (CHAR_HEIGHT + 1);
-
         if (lock_in[i].value == UNLOCKED)
         {
-            display->drawChar(x, y, (char)1 + (rand() % 254), MONOOLED_WHITE, MONOOLED_BLACK, 1);
-        }
-        else
-        {
-            display->drawChar(x, y, (char)lock_in[i].value, MONOOLED_WHITE, MONOOLED_BLACK, 1);
+            draw_cell(lock_in[i], 1 + (rand() % 254));
         }
     }
 }
 
-void self_test_render(uint8_t* back_buffer)
+// Locked cells into the background layer, e.g. after another state had
+// the screen
+static void render_locked(std::deque<lock_in_t>& lock_in)
+{
+    layer_select(LAYER_BACKGROUND);
+    for (uint16_t i = 0; i < self_test.locked; ++i)
+    {
+        draw_cell(lock_in[i], lock_in[i].value);
+    }
+    layer_select(LAYER_CONTENT);
+}
+
+void self_test_enter()
+{
+    Log("Self test entered");
+    self_test.lock_in.resize(CELLS);
+    for(uint16_t i = 0; i < CELLS; ++i)
+    {
+        self_test.lock_in[i].index = i;
+        self_test.lock_in[i].value = UNLOCKED;
+    }
+    std::random_shuffle(self_test.lock_in.begin(), self_test.lock_in.end());
+    self_test.rotation = 0;
+    self_test.locked = 0;
+    animation_start(&self_test.anim, &self_test_timeline);
+}
+
+// The renderer composes the layers, nothing to return
+bool self_test_step(const render_context_t* ctx)
+{
+    if (ctx->entered)
+    {
+        layers_begin();
+        render_locked(self_test.lock_in);
+        render_lock_in(self_test.lock_in);
+    }
+
+    int16_t target = animation_int(&self_test.anim, LOCK_IN_TRACK);
+    while ((self_test.locked < target) && (self_test.locked < CELLS))
+    {
+        self_test.lock_in[self_test.locked].value = 1 + (rand() % 254);
+        lock_cell(self_test.lock_in[self_test.locked]);
+        ++self_test.locked;
+    }
+
+    // Each character that remains unlocked should randomly rotate
+    if (animation_ticked(&self_test.anim, ROTATION_TRACK, &self_test.rotation))
+    {
+        render_lock_in(self_test.lock_in);
+    }
+    return false;
+}
+
+// The whole screen blinks, as a screen sized highlight that is the
+// panel's invert command rather than a redraw
+bool self_test_blink()
 {
-    static std::deque<lock_in_t> lock_in;
-    static uint32_t lock_in_rate = 2;
-    static uint32_t last_lock_in = 0;
-    static uint32_t last_rotate = 0;
-    static uint16_t locks = 0;
-    static uint8_t blinks = 0;
-    switch(state)
+    if (animation_changed(&self_test.anim, 0, &self_test.visible))
     {
-        case SELF_TEST_ENTER:
-            Log("Self test entered");
-            lock_in.resize(CHARACTERS_PER_LINE * LINES);
-            for(uint16_t i = 0; i < CHARACTERS_PER_LINE * LINES; ++i)
-            {
-                lock_in[i].index = i;
-                lock_in[i].value = UNLOCKED;
-            }
-            std::random_shuffle(lock_in.begin(), lock_in.end());
-            last_lock_in = millis();
-            last_rotate = millis();
-            lock_in_rate = 2;
-            locks = 0;
-            state = SELF_TEST_RUN;
-            break;
-        case SELF_TEST_RUN:
-            // Each character that remains in the lock-in deque
-            // should randomly rotate
-            if ((millis() - last_rotate) > ROTATION_RATE)
-            {
-                display->clearDisplay();
-                last_rotate = millis();
-                render_lock_in(lock_in);
-            }
-            if ((millis() - last_lock_in) > lock_in_rate)
-            {
-                last_lock_in = millis();
-                ++locks;
-                if (locks > LOCKS_PER_ACC)
-                {
-                    lock_in_rate *= LOCK_IN_ACCELERATION;
-                    locks = 0;
-                }
-                uint16_t i = 0;
-                while(i < CHARACTERS_PER_LINE * LINES)
-                {
-                    if (lock_in[i].value == UNLOCKED)
-                    {
-                        lock_in[i].value = 1 + (rand() % 254);
-                        break;
-                    }
-                    ++i;
-                }
-                if (i >= CHARACTERS_PER_LINE * LINES)
-                {
-                    state = SELF_TEST_BLINK;
-                    last_rotate = millis();
-                }
-            }
-            break;
-        case SELF_TEST_BLINK:
-            if ((millis() - last_rotate) > BLINK_TIME)
-            {
-                last_rotate = millis();
-                display->clearDisplay();
-                if ((blinks % 2) == 0)
-                {
-                    render_lock_in(lock_in);
-                }
-                ++blinks;
-                if (blinks >= (2*NBLINKS))
-                {
-                    state = SELF_TEST_EXIT;
-                }
-            }
-            break;
-        case SELF_TEST_EXIT:
-            blinks = 0;
-            pop_render_function();
-            state = SELF_TEST_ENTER;
-            break;
-        default:
-            pop_render_function();
-            break;
+        highlight_set(!self_test.visible);
     }
+    return false;
+}
+
+static void self_test_leave(bool popped)
+{
+    UNUSED(popped);
+    CO_INIT(&self_test.co);
+}
+
+bool self_test_render(const render_context_t* ctx)
+{
+    coroutine_t* co = &self_test.co;
+    CO_BEGIN(co);
+
+    render_on_leave(self_test_leave);
+    self_test_enter();
+    while (self_test.locked < CELLS)
+    {
+        CO_YIELD(co, self_test_step(ctx));
+    }
+
+    // Every value is in the background layer by now
+    highlight_add(0, 0, LCD_WIDTH, LCD_HEIGHT);
+    animation_start(&self_test.anim, &ANIM_BLINK);
+    self_test.visible = 1;
+    CO_YIELD(co, true);
+    while (!animation_done(&self_test.anim))
+    {
+        CO_YIELD(co, self_test_blink());
+    }
+
+    highlight_clear();
+    pop_render_function();
+    CO_END(co);
 }
@@ -1,8 +1,10 @@
 #ifndef SELF_TEST_H_
 #define SELF_TEST_H_
 
+#include "renderer.h"
+
 #include <stdint.h>
 
-void self_test_render(uint8_t* buffer);
+bool self_test_render(const render_context_t* ctx);
 
 #endif // SPLASH_SCREEN_H_
@@ -1,110 +1,134 @@
 #include "splash_screen.h"
 
+#include "animation.h"
+#include "coroutine.h"
 #include "images.h"
 #include "renderer.h"
 #include "utility.h"
 
-#include <algorithm>
-#include <deque>
-
-#define FADE_RATE_MS 1
+#define FADE_IN_MS 2000
 #define FADE_HOLD_MS 2500
-#define FADE_CHUNK_SIZE 64
+#define FADE_OUT_MS 2000
+#define FADE_PIXELS (LCD_WIDTH * LCD_HEIGHT)
 
-typedef enum {
-    CLEAR = 0,
-    FADE_IN,
-    HOLD,
-    FADE_OUT,
-    COMPLETE
-} splash_state_t;
+// The dissolve order is a 13 bit maximal length LFSR, which visits every
+// pixel index but 0 once, so nothing has to be allocated or shuffled
+// before the first frame. 0 is visited last. Consecutive LFSR states are
+// shifts of each other, an odd multiplier scatters them over the screen.
+#define FADE_INDEX_MASK (FADE_PIXELS - 1)
+#define FADE_LFSR_TAPS 0x100D
+#define FADE_LFSR_SEED 0x1ACE
+#define FADE_SCATTER 0x09E5
 
 typedef struct
 {
-    uint8_t x;
-    uint8_t y;
-} pixel_index_t;
+    coroutine_t co;
+    animation_t anim;
+    uint16_t lfsr;
+    uint16_t pixel;
+} splash_t;
+
+// Pixels of the logo dissolved in over time, then held. The fade out
+// covers the whole screen so it ramps the panel contrast instead.
+static const tween_t fade_tweens[] = {
+    { FADE_IN_MS, 0, FADE_PIXELS, EASE_LINEAR },
+    { FADE_HOLD_MS, FADE_PIXELS, FADE_PIXELS, EASE_STEP },
+};
+
+static const track_t splash_tracks[] = {
+    TRACK(fade_tweens, 1),
+};
+
+static const timeline_t splash_timeline = TIMELINE(splash_tracks);
+
+static splash_t splash;
+
+void prepare_fade()
+{
+    splash.lfsr = FADE_LFSR_SEED;
+    splash.pixel = 0;
+}
+
+static uint16_t next_fade_index()
+{
+    uint16_t state = 0;
+    if (splash.pixel < (FADE_PIXELS - 1))
+    {
+        state = splash.lfsr;
+        splash.lfsr = (state >> 1) ^ ((state & 1) ? FADE_LFSR_TAPS : 0);
+    }
+    return (uint16_t)(state * FADE_SCATTER) & FADE_INDEX_MASK;
+}
 
-void splash_screen_render(uint8_t* buffer)
+// Process pixels up to target, returns true if anything was drawn
+bool fade_to(uint16_t target)
 {
-    static uint32_t timer;
-    static splash_state_t state = CLEAR;
-    static std::deque<pixel_index_t> index_deque;
-    static std::deque<pixel_index_t>::iterator pixel_idx;
-    switch(state)
+    if (target > FADE_PIXELS)
+    {
+        target = FADE_PIXELS;
+    }
+    if (splash.pixel >= target)
     {
-        case CLEAR:
-            timer = millis();
-            index_deque.resize(LCD_WIDTH * LCD_HEIGHT);
-            // Clear the back buffer
-            display->clearDisplay();
-            for(uint8_t y = 0; y < LCD_HEIGHT; ++y)
-            {
-                for(uint8_t x = 0; x < LCD_WIDTH; ++x)
-                {
-                    index_deque[(y * LCD_WIDTH) + x].x = x;
-                    index_deque[(y * LCD_WIDTH) + x].y = y;
-                }
-            }
-            std::random_shuffle(index_deque.begin(), index_deque.end());
-            pixel_idx = index_deque.begin();
-            state = FADE_IN;
-            break;
-        case FADE_IN:
-            if ((millis() - timer) > FADE_RATE_MS)
-            {
-                for(uint8_t i = 0; i < FADE_CHUNK_SIZE; ++i)
-                {
-                    uint8_t image_byte = pgm_read_byte(&(DI_FULL.data[DATA_COORDINATE(pixel_idx->x, pixel_idx->y)]));
-                    if (((image_byte << (pixel_idx->x % 8) & 0x80)))
-                    {
-                        display->drawPixel(pixel_idx->x, pixel_idx->y, MONOOLED_WHITE);
-                        timer = millis();
-                    }
-
-                    ++pixel_idx;
-                    if (index_deque.end() == pixel_idx)
-                    {
-                        display->setTextColor(SH110X_WHITE);
-                        display->setTextSize(1);
-                        display->setCursor(12, 56);
-                        display->print("Digital Industries");
-                        pixel_idx = index_deque.begin();
-                        state = HOLD;
-                        break;
-                    }
-                }
-            }
-            break;
-        case HOLD:
-            if ((millis() - timer) > FADE_HOLD_MS)
-            {
-                timer = millis();
-                state = FADE_OUT;
-            }
-            break;
-        case FADE_OUT:
-            if ((millis() - timer) > FADE_RATE_MS)
-            {
-                for(uint8_t i = 0; i < FADE_CHUNK_SIZE; ++i)
-                {
-                    display->drawPixel(pixel_idx->x, pixel_idx->y, MONOOLED_BLACK);
-                    timer = millis();
-
-                    ++pixel_idx;
-                    if (index_deque.end() == pixel_idx)
-                    {
-                        pixel_idx = index_deque.begin();
-                        state = COMPLETE;
-                        break;
-                    }
-                }
-            }
-            break;
-        case COMPLETE:
-            pop_render_function();
-            break;
-        default:
-            break;
+        return false;
     }
+
+    while (splash.pixel < target)
+    {
+        uint16_t index = next_fade_index();
+        uint8_t x = index % LCD_WIDTH;
+        uint8_t y = index / LCD_WIDTH;
+        uint8_t image_byte = pgm_read_byte(&(DI_FULL.data[DATA_COORDINATE(x, y)]));
+        if (((image_byte << (x % 8) & 0x80)))
+        {
+            display->drawPixel(x, y, MONOOLED_WHITE);
+        }
+
+        ++splash.pixel;
+        if (splash.pixel == FADE_PIXELS)
+        {
+            display->setTextColor(SH110X_WHITE);
+            display->setTextSize(1);
+            display->setCursor(12, 56);
+            display->print("Digital Industries");
+        }
+    }
+    return true;
+}
+
+// Left mid fade the contrast is put back as well
+static void splash_screen_leave(bool popped)
+{
+    UNUSED(popped);
+    render_set_brightness(DEFAULT_BRIGHTNESS);
+    CO_INIT(&splash.co);
+}
+
+bool splash_screen_render(const render_context_t* ctx)
+{
+    UNUSED(ctx);
+    coroutine_t* co = &splash.co;
+    CO_BEGIN(co);
+
+    render_on_leave(splash_screen_leave);
+    prepare_fade();
+    // Clear the back buffer
+    display->clearDisplay();
+    animation_start(&splash.anim, &splash_timeline);
+    // Sending the blank frame straight away replaces whatever the
+    // controller RAM held at power on
+    CO_YIELD(co, true);
+
+    while (!animation_done(&splash.anim))
+    {
+        CO_YIELD(co, fade_to(animation_int(&splash.anim, 0)));
+    }
+
+    render_fade_to(0, FADE_OUT_MS);
+    CO_AWAIT(co, !render_fading());
+
+    // Blank the frame while the panel is dark, then restore the contrast
+    display->clearDisplay();
+    CO_YIELD(co, true);
+    pop_render_function();
+    CO_END(co);
 }
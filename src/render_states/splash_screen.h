@@ -1,8 +1,10 @@
 #ifndef SPLASH_SCREEN_H_
 #define SPLASH_SCREEN_H_
 
+#include "renderer.h"
+
 #include <stdint.h>
 
-void splash_screen_render(uint8_t* buffer);
+bool splash_screen_render(const render_context_t* ctx);
 
 #endif // SPLASH_SCREEN_H_
@@ -2,7 +2,15 @@
 
 #include "renderer.h"
 
+#include "animation.h"
+#include "boot.h"
+#include "buttons.h"
+#include "grayscale.h"
+#include "highlight.h"
 #include "images.h"
+#include "layers.h"
+#include "mirror.h"
+#include "transition.h"
 
 #include <SPI.h>
 #include <Wire.h>
@@ -10,48 +18,391 @@
 #include <Adafruit_SH110X.h>
 
 #include <stack>
+#include <string.h>
 #include <stdint.h>
 
-static uint8_t _lcd_buffer[LCD_HEIGHT * BYTES_PER_LINE];
 static std::stack<render_function_t> render_state;
-Adafruit_SH1107* display;
+static bool render_state_changed = true;
+static render_leave_t render_leave = NULL;
+static render_clock_t render_clock = millis;
+static render_context_t context;
+static uint8_t target_fps = DEFAULT_TARGET_FPS;
+static uint32_t frame_period_us = 1000000UL / DEFAULT_TARGET_FPS;
+static uint8_t last_buttons = BUTTON_ALL_MASK;
 
-void blitBuffer();
+static uint8_t brightness = DEFAULT_BRIGHTNESS;
+static tween_t fade_tweens[1];
+static track_t fade_tracks[1] = {
+    TRACK(fade_tweens, 1),
+};
+static const timeline_t fade_timeline = TIMELINE(fade_tracks);
+static animation_t fade = { NULL, 0 };
+
+// Outgoing frame and the composition currently on the panel
+static uint8_t transition_from[FRAME_BYTES] __attribute__((aligned(4)));
+static uint8_t transition_out[FRAME_BYTES] __attribute__((aligned(4)));
+static uint8_t transition_type = DEFAULT_TRANSITION;
+static uint16_t transition_ms = DEFAULT_TRANSITION_MS;
+static bool transition_reverse = false;
+static uint16_t transition_pending = 0;
+static tween_t transition_tweens[1];
+static track_t transition_tracks[1] = {
+    TRACK(transition_tweens, 1),
+};
+static const timeline_t transition_timeline = TIMELINE(transition_tracks);
+static animation_t transition = { NULL, 0 };
+static render_stats_t stats;
+// Static so the frame and the driver state are placed at link time rather
+// than allocated while booting, begin() lends the frame to the driver in
+// place of the buffer it would allocate
+static FrameDisplay frame_display(&Wire);
+FrameDisplay* display = &frame_display;
+
+void copy_pixel(const uint8_t* src,
+                uint8_t* dst,
+                int16_t x_src,
+                int16_t y_src,
+                int16_t x_dst,
+                int16_t y_dst)
+{
+    if (src[pixel_byte(x_src, y_src)] & pixel_bitmask(x_src))
+    {
+        set_pixel(dst, x_dst, y_dst);
+    }
+    else
+    {
+        reset_pixel(dst, x_dst, y_dst);
+    }
+}
+
+void copy_line(const uint8_t* src,
+               uint8_t* dst,
+               int16_t y_src,
+               int16_t y_dst)
+{
+    memcpy(&dst[pixel_byte(0, y_dst)], &src[pixel_byte(0, y_src)], BYTES_PER_LINE);
+}
+
+void copy_block(const uint8_t* src,
+                uint8_t* dst,
+                int16_t x_src,
+                int16_t y_src,
+                int16_t x_dst,
+                int16_t y_dst,
+                int16_t w,
+                int16_t h)
+{
+    for (int16_t y = 0; y < h; ++y)
+    {
+        for (int16_t x = 0; x < w; ++x)
+        {
+            copy_pixel(src, dst, x_src + x, y_src + y, x_dst + x, y_dst + y);
+        }
+    }
+}
 
 void blit_buffer(uint8_t* buffer)
 {
-    display->drawBitmap(0,0, buffer, LCD_WIDTH, LCD_HEIGHT, MONOOLED_WHITE);
+    memcpy(display->frame(), buffer, FRAME_BYTES);
+    display->mark_all_dirty();
+}
+
+void render_invalidate(int16_t x, int16_t w)
+{
+    display->mark_dirty(x, w);
 }
 
 void render_init()
 {
-    display = new Adafruit_SH1107(64, 128, &Wire);
-    // text display tests
     display->begin(0x3C, true); // Address 0x3C default
+    display->set_bus_speed(DEFAULT_BUS_HZ);
     display->cp437(true);
     display->setRotation(1);
     display->setTextSize(1);
     display->setTextColor(SH110X_WHITE);
+    display->set_contrast(brightness);
+}
+
+static void start_transition(bool reverse)
+{
+    // States pushed before the first frame just appear
+    if ((transition_type == TRANSITION_NONE) || (context.frame == 0) || (display == NULL))
+    {
+        return;
+    }
+
+    // Start from what the panel shows, including unflushed drawing
+    if (transition.timeline == NULL)
+    {
+        memcpy(transition_from, display->frame(), FRAME_BYTES);
+        transition_pending = display->dirty_pages();
+    }
+    else
+    {
+        memcpy(transition_from, transition_out, FRAME_BYTES);
+    }
+    memcpy(transition_out, transition_from, FRAME_BYTES);
+
+    transition_reverse = reverse;
+    transition_tweens[0].duration_ms = transition_ms;
+    transition_tweens[0].from = 0;
+    transition_tweens[0].to = TRANSITION_SPAN;
+    transition_tweens[0].easing = (transition_type == TRANSITION_DISSOLVE) ? EASE_LINEAR : EASE_OUT_QUAD;
+    animation_start(&transition, &transition_timeline);
+}
+
+static void update_transition()
+{
+    uint16_t progress = (uint16_t)animation_int(&transition, 0);
+    uint16_t pages = transition_compose(transition_type,
+                                        transition_reverse,
+                                        transition_from,
+                                        display->frame(),
+                                        progress,
+                                        transition_out);
+    display->present(transition_out, pages | transition_pending);
+    transition_pending = 0;
+
+    if (animation_done(&transition))
+    {
+        // The last composition is the frame itself
+        transition.timeline = NULL;
+        display->clear_dirty();
+    }
+}
+
+// Cleared before it runs, so it runs once per registration
+static void leave_top(bool popped)
+{
+    render_leave_t leave = render_leave;
+    render_leave = NULL;
+    if (leave != NULL)
+    {
+        leave(popped);
+    }
+}
+
+void render_on_leave(render_leave_t leave)
+{
+    render_leave = leave;
 }
 
 void push_render_function(render_function_t func)
 {
+    leave_top(false);
+    start_transition(false);
+    highlight_clear();
+    layers_end();
     render_state.push(func);
+    render_state_changed = true;
 }
 
 void pop_render_function()
 {
     if (!render_state.empty())
     {
+        leave_top(true);
+        start_transition(true);
+        highlight_clear();
+        layers_end();
         render_state.pop();
+        render_state_changed = true;
+    }
+}
+
+uint32_t render_frame_count()
+{
+    return context.frame;
+}
+
+void render_resume()
+{
+    context.frame_start_us = micros() - frame_period_us;
+}
+
+uint8_t render_depth()
+{
+    return (uint8_t)render_state.size();
+}
+
+render_function_t render_top()
+{
+    return render_state.empty() ? NULL : render_state.top();
+}
+
+void render_set_transition(uint8_t type, uint16_t duration_ms)
+{
+    transition_type = (type < TRANSITION_MAX) ? type : (uint8_t)TRANSITION_NONE;
+    transition_ms = duration_ms;
+}
+
+bool render_transitioning()
+{
+    return transition.timeline != NULL;
+}
+
+void render_set_clock(render_clock_t clock)
+{
+    render_clock = (clock != NULL) ? clock : millis;
+}
+
+void render_set_target_fps(uint8_t fps)
+{
+    target_fps = fps;
+    frame_period_us = (fps > 0) ? (1000000UL / fps) : 0;
+}
+
+uint8_t render_target_fps()
+{
+    return target_fps;
+}
+
+uint32_t render_budget_remaining_us(const render_context_t* ctx)
+{
+    uint32_t spent = micros() - ctx->frame_start_us;
+    if ((ctx->budget_us == 0) || (spent >= ctx->budget_us))
+    {
+        return 0;
+    }
+    return ctx->budget_us - spent;
+}
+
+void render_set_brightness(uint8_t level)
+{
+    fade.timeline = NULL;
+    if (level != brightness)
+    {
+        brightness = level;
+        display->set_contrast(level);
+    }
+}
+
+uint8_t render_brightness()
+{
+    return brightness;
+}
+
+void render_fade_to(uint8_t level, uint16_t duration_ms)
+{
+    fade_tweens[0].duration_ms = duration_ms;
+    fade_tweens[0].from = brightness;
+    fade_tweens[0].to = level;
+    fade_tweens[0].easing = (level < brightness) ? EASE_IN_QUAD : EASE_OUT_QUAD;
+    animation_start(&fade, &fade_timeline);
+}
+
+bool render_fading()
+{
+    return fade.timeline != NULL;
+}
+
+void render_set_visible(bool visible)
+{
+    display->set_panel_on(visible);
+}
+
+void render_set_inverted(bool inverted)
+{
+    display->set_inverted(inverted);
+}
+
+static void update_fade()
+{
+    if (fade.timeline == NULL)
+    {
+        return;
+    }
+
+    uint8_t level = (uint8_t)animation_int(&fade, 0);
+    if (level != brightness)
+    {
+        brightness = level;
+        display->set_contrast(level);
+    }
+    if (animation_done(&fade))
+    {
+        fade.timeline = NULL;
     }
 }
 
 void render()
 {
+    uint32_t frame_start_us = micros();
+    // Grayscale sub-frames run faster than the frame rate
+    grayscale_service(frame_start_us);
+    mirror_service();
+    if ((context.frame > 0)
+        && ((frame_start_us - context.frame_start_us) < frame_period_us))
+    {
+        return;
+    }
+
+    uint32_t now = render_clock();
+    uint8_t buttons = get_buttons();
+
+    context.back_buffer = display->frame();
+    context.delta = (context.frame > 0) ? (now - context.now) : 0;
+    context.now = now;
+    context.frame_start_us = frame_start_us;
+    // Unpaced frames get the default rate's budget, so work spread over
+    // frames still moves
+    context.budget_us = (frame_period_us > 0) ? frame_period_us : (1000000UL / DEFAULT_TARGET_FPS);
+    context.buttons = buttons;
+    context.pressed = last_buttons & ~buttons & BUTTON_ALL_MASK;
+    context.released = ~last_buttons & buttons & BUTTON_ALL_MASK;
+    context.entered = render_state_changed;
+    last_buttons = buttons;
+    render_state_changed = false;
+    if (context.pressed | context.released)
+    {
+        ++stats.input_events;
+    }
+    animation_tick(now);
+    update_fade();
+
+    bool changed = false;
     if (!render_state.empty())
     {
-        (render_state.top())(_lcd_buffer);
+        changed = (render_state.top())(&context);
     }
-    display->display();
+    // States drawing in layers leave the frame to be composed here
+    changed = layers_compose() || changed;
+    ++context.frame;
+
+    // While a transition runs the frame is composed, not sent directly,
+    // and in grayscale mode the planes own the panel
+    if (grayscale_active())
+    {
+        transition.timeline = NULL;
+    }
+    else if (transition.timeline != NULL)
+    {
+        update_transition();
+        mirror_frame(transition_out);
+    }
+    else if (changed)
+    {
+        display->display();
+        boot_mark(BOOT_FIRST_FRAME);
+        mirror_frame(display->frame());
+    }
+
+    uint32_t frame_us = micros() - frame_start_us;
+    ++stats.frames;
+    stats.frame_us = frame_us;
+    stats.frame_us_total += frame_us;
+    if (frame_us > stats.frame_us_max)
+    {
+        stats.frame_us_max = frame_us;
+    }
+}
+
+const render_stats_t* render_stats()
+{
+    return &stats;
+}
+
+void render_reset_stats()
+{
+    memset(&stats, 0, sizeof(stats));
 }
@@ -1,15 +1,64 @@
 #ifndef RENDERER_H_
 #define RENDERER_H_
 
+#include "display.h"
+#include "transition.h"
+
 #include <Adafruit_GFX.h>
 #include <Adafruit_SH110X.h>
 #include <stdint.h>
 
-#define LCD_WIDTH       (128)
-#define LCD_HEIGHT      (64)
-#define BYTES_PER_LINE  (16)
+#define DEFAULT_TARGET_FPS (30)
+#define DEFAULT_BRIGHTNESS (0x4F)
+#define DEFAULT_TRANSITION (TRANSITION_SLIDE)
+#define DEFAULT_TRANSITION_MS (300)
+// Fastest display clock to probe for, see FrameDisplay::set_bus_speed()
+#define DEFAULT_BUS_HZ (I2C_FAST_PLUS_HZ)
+
+// Everything a render state needs for one frame. Time is sampled once per
+// frame so every branch of a state sees the same timestamp.
+typedef struct
+{
+    uint8_t* back_buffer;
+    // Frame time in ms, from the render clock
+    uint32_t now;
+    // ms since the previous frame
+    uint32_t delta;
+    uint32_t frame;
+    // Debounced button state and the edges since the previous frame,
+    // using the BUTTON_*_STATE_MASK bits
+    uint8_t buttons;
+    uint8_t pressed;
+    uint8_t released;
+    // First frame this state is on top of the render stack, either
+    // because it was pushed or because the state above it was popped
+    bool entered;
+    // Frame budget, real time in us, the default rate's when unpaced
+    uint32_t frame_start_us;
+    uint32_t budget_us;
+} render_context_t;
+
+// Rendered frames and input since the last reset, frame time includes
+// the state and the flush
+typedef struct
+{
+    uint32_t frames;
+    uint32_t frame_us;
+    uint32_t frame_us_max;
+    uint32_t frame_us_total;
+    // Frames with a button pressed or released
+    uint32_t input_events;
+} render_stats_t;
+
+// Render states return true when they changed the frame, false lets the
+// renderer skip flushing the display
+typedef bool(*render_function_t)(const render_context_t* ctx);
+
+typedef uint32_t(*render_clock_t)();
 
-typedef void(*render_function_t)(uint8_t* back_buffer);
+// Run when a state stops being on top of the stack, popped is false when
+// another state was pushed over it
+typedef void(*render_leave_t)(bool popped);
 
 inline uint16_t pixel_byte(int16_t x, int16_t y)
 {
@@ -35,7 +84,10 @@ inline void reset_pixel(uint8_t* buffer, uint8_t x, uint8_t y)
     buffer[byte] &= ~mask;
 }
 
-extern Adafruit_SH1107* display;
+extern FrameDisplay* display;
+
+// Mark columns of the back buffer written without going through display
+void render_invalidate(int16_t x, int16_t w);
 
 // Copy a single pixel
 void copy_pixel(const uint8_t* src,
@@ -65,6 +117,46 @@ void blit_buffer(uint8_t* buffer);
 void render_init();
 void push_render_function(render_function_t func);
 void pop_render_function();
+// Teardown for the state on top, run once when it is popped or covered and
+// then forgotten. States that change global settings (frame rate, panel
+// modes, Serial ownership) undo them there and reset their coroutine, so
+// they start over rather than resume when they are on top again.
+void render_on_leave(render_leave_t leave);
+uint8_t render_depth();
+// State on top of the stack, NULL when it is empty
+render_function_t render_top();
 void render();
+// Frames rendered so far, render() does nothing between paced frames
+uint32_t render_frame_count();
+const render_stats_t* render_stats();
+void render_reset_stats();
+// Render on the next call instead of waiting out the frame period
+void render_resume();
+
+// Replace the frame clock, e.g. with a virtual clock, defaults to millis()
+void render_set_clock(render_clock_t clock);
+
+// Frames are paced to the target rate, 0 renders as fast as possible
+void render_set_target_fps(uint8_t fps);
+uint8_t render_target_fps();
+
+// Time left in this frame's budget, 0 once it has been spent
+uint32_t render_budget_remaining_us(const render_context_t* ctx);
+
+// Whole screen brightness and visibility through the controller, so fades
+// and blinks cost a command per step instead of redrawing the frame
+void render_set_brightness(uint8_t level);
+uint8_t render_brightness();
+// Ramp the contrast register to level, one step per frame
+void render_fade_to(uint8_t level, uint16_t duration_ms);
+bool render_fading();
+void render_set_visible(bool visible);
+void render_set_inverted(bool inverted);
+
+// Transition played on every push and pop (see transition.h). Pushes run
+// forwards, pops in reverse. The new state draws into the frame as usual
+// and the renderer sends the composition until the transition ends.
+void render_set_transition(uint8_t type, uint16_t duration_ms);
+bool render_transitioning();
 
 #endif // RENDERER_H_
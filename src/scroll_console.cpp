@@ -0,0 +1,153 @@
+#include "scroll_console.h"
+
+#include "renderer.h"
+
+#include <Adafruit_GFX.h>
+// Classic 5x7 font, column-major with bit 0 at the top
+#include <glcdfont.c>
+
+#include <string.h>
+
+#define GLYPH_COLUMNS 5
+
+typedef struct
+{
+    uint8_t text[SCROLL_CONSOLE_QUEUE];
+    uint8_t head;
+    uint8_t count;
+    uint8_t column;
+} console_lane_t;
+
+static console_lane_t lanes[SCROLL_CONSOLE_LANES];
+static uint32_t columns_scrolled = 0;
+static uint32_t bytes_sent = 0;
+
+void scroll_console_begin()
+{
+    memset(lanes, 0, sizeof(lanes));
+    display->clearDisplay();
+    display->display();
+    display->set_start_line(0);
+}
+
+void scroll_console_end()
+{
+    display->set_start_line(0);
+    display->clearDisplay();
+}
+
+uint16_t scroll_console_print(uint8_t lane, const char* text)
+{
+    if (lane >= SCROLL_CONSOLE_LANES)
+    {
+        return 0;
+    }
+
+    console_lane_t& l = lanes[lane];
+    uint16_t accepted = 0;
+    while ((*text != '\0') && (l.count < SCROLL_CONSOLE_QUEUE))
+    {
+        l.text[(l.head + l.count) % SCROLL_CONSOLE_QUEUE] = (uint8_t)*text++;
+        ++l.count;
+        ++accepted;
+    }
+    return accepted;
+}
+
+uint16_t scroll_console_pending(uint8_t lane)
+{
+    if (lane >= SCROLL_CONSOLE_LANES)
+    {
+        return 0;
+    }
+    return lanes[lane].count;
+}
+
+// Next glyph column of a lane, blank once its queue runs dry
+static uint8_t next_column(console_lane_t& l)
+{
+    if (l.count == 0)
+    {
+        return 0;
+    }
+
+    uint8_t bits = 0;
+    if (l.column < GLYPH_COLUMNS)
+    {
+        bits = pgm_read_byte(&font[(l.text[l.head] * GLYPH_COLUMNS) + l.column]);
+    }
+
+    ++l.column;
+    if (l.column >= SCROLL_CONSOLE_CHAR_WIDTH)
+    {
+        l.column = 0;
+        l.head = (l.head + 1) % SCROLL_CONSOLE_QUEUE;
+        --l.count;
+    }
+    return bits;
+}
+
+static void write_column(uint8_t* frame, uint8_t x)
+{
+    uint8_t* byte = &frame[x >> 3];
+    uint8_t mask = 1 << (x & 7);
+    for (uint8_t lane = 0; lane < SCROLL_CONSOLE_LANES; ++lane)
+    {
+        uint8_t bits = next_column(lanes[lane]);
+        for (uint8_t row = 0; row < 8; ++row)
+        {
+            if (bits & (1 << row))
+            {
+                *byte |= mask;
+            }
+            else
+            {
+                *byte &= ~mask;
+            }
+            byte += BYTES_PER_LINE;
+        }
+    }
+}
+
+uint16_t scroll_console_advance(uint16_t columns)
+{
+    if (columns > LCD_WIDTH)
+    {
+        columns = LCD_WIDTH;
+    }
+    if (columns == 0)
+    {
+        return 0;
+    }
+
+    // The frame column that leaves the screen is the one entering on the
+    // right, so draw into it before moving the start line past it
+    uint8_t* frame = display->frame();
+    uint8_t line = display->start_line();
+    for (uint16_t i = 0; i < columns; ++i)
+    {
+        uint8_t x = (line + i) % LCD_WIDTH;
+        write_column(frame, x);
+        display->mark_dirty(x, 1);
+    }
+
+    for (uint16_t pages = display->dirty_pages(); pages != 0; pages &= pages - 1)
+    {
+        bytes_sent += PAGE_BYTES;
+    }
+    display->display();
+    display->set_start_line(line + columns);
+    bytes_sent += 2;
+    columns_scrolled += columns;
+    return columns;
+}
+
+uint32_t scroll_console_columns()
+{
+    return columns_scrolled;
+}
+
+uint32_t scroll_console_bytes_sent()
+{
+    return bytes_sent;
+}
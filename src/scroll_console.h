@@ -0,0 +1,34 @@
+#ifndef SCROLL_CONSOLE_H_
+#define SCROLL_CONSOLE_H_
+
+#include <stdint.h>
+
+// Streaming text surface scrolled with the SH1107 display start line. The
+// controller can only scroll along its COM axis, which is horizontal with
+// the panel rotated, so the console is a ticker of eight 8 pixel lanes
+// moving right to left. Each scrolled column is drawn into the frame
+// column that just left the screen, then only that page (64 bytes) is
+// sent before the start line moves, instead of a full 1 KB frame.
+//
+// The console owns the screen between begin and end, ordinary drawing
+// assumes a start line of 0.
+
+#define SCROLL_CONSOLE_LANES 8
+#define SCROLL_CONSOLE_QUEUE 32
+#define SCROLL_CONSOLE_CHAR_WIDTH 6
+
+void scroll_console_begin();
+void scroll_console_end();
+
+// Queue text on a lane, returns the number of characters accepted
+uint16_t scroll_console_print(uint8_t lane, const char* text);
+uint16_t scroll_console_pending(uint8_t lane);
+
+// Scroll by up to columns pixels, writing and flushing only the exposed
+// columns. Returns the number of columns scrolled.
+uint16_t scroll_console_advance(uint16_t columns);
+
+uint32_t scroll_console_columns();
+uint32_t scroll_console_bytes_sent();
+
+#endif // SCROLL_CONSOLE_H_
@@ -0,0 +1,243 @@
+#include "sprite.h"
+
+#include "renderer.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define ROW_WORDS (WORDS_PER_LINE + 1)
+
+// A nibble with every bit repeated 2, 3 or 4 times
+static const uint16_t expand_nibble[SPRITE_MAX_SCALE - 1][16] = {
+    {
+        0x0000, 0x0003, 0x000C, 0x000F, 0x0030, 0x0033, 0x003C, 0x003F,
+        0x00C0, 0x00C3, 0x00CC, 0x00CF, 0x00F0, 0x00F3, 0x00FC, 0x00FF
+    },
+    {
+        0x0000, 0x0007, 0x0038, 0x003F, 0x01C0, 0x01C7, 0x01F8, 0x01FF,
+        0x0E00, 0x0E07, 0x0E38, 0x0E3F, 0x0FC0, 0x0FC7, 0x0FF8, 0x0FFF
+    },
+    {
+        0x0000, 0x000F, 0x00F0, 0x00FF, 0x0F00, 0x0F0F, 0x0FF0, 0x0FFF,
+        0xF000, 0xF00F, 0xF0F0, 0xF0FF, 0xFF00, 0xFF0F, 0xFFF0, 0xFFFF
+    },
+};
+
+static inline uint8_t reverse_bits(uint8_t v)
+{
+    v = ((v & 0xF0) >> 4) | ((v & 0x0F) << 4);
+    v = ((v & 0xCC) >> 2) | ((v & 0x33) << 2);
+    v = ((v & 0xAA) >> 1) | ((v & 0x55) << 1);
+    return v;
+}
+
+// 8 pixels starting at bit offset, least significant bit leftmost
+static inline uint8_t extract_pixels(const image_t* image, uint32_t offset, uint16_t size)
+{
+    uint16_t index = offset >> 3;
+    uint16_t pair = pgm_read_byte(&image->data[index]) << 8;
+    if ((index + 1) < size)
+    {
+        pair |= pgm_read_byte(&image->data[index + 1]);
+    }
+    return reverse_bits((uint8_t)((pair << (offset & 7)) >> 8));
+}
+
+static inline uint32_t expand_pixels(uint8_t bits, uint8_t scale)
+{
+    if (scale == 1)
+    {
+        return bits;
+    }
+    const uint16_t* table = expand_nibble[scale - 2];
+    return (uint32_t)table[bits & 0x0F] | ((uint32_t)table[bits >> 4] << (4 * scale));
+}
+
+// OR n <= 32 bits into a screen line at pos, clipping to the screen
+static inline void place_bits(uint32_t* row, int16_t pos, uint32_t bits, int16_t n)
+{
+    if (pos < 0)
+    {
+        if (-pos >= n)
+        {
+            return;
+        }
+        bits >>= -pos;
+        n += pos;
+        pos = 0;
+    }
+    if (pos >= LCD_WIDTH)
+    {
+        return;
+    }
+    if ((pos + n) > LCD_WIDTH)
+    {
+        n = LCD_WIDTH - pos;
+    }
+    if (n < 32)
+    {
+        bits &= (1UL << n) - 1;
+    }
+
+    uint8_t word = pos >> 5;
+    uint8_t shift = pos & 31;
+    row[word] |= bits << shift;
+    if ((shift > 0) && ((shift + n) > 32))
+    {
+        row[word + 1] |= bits >> (32 - shift);
+    }
+}
+
+// Build one scaled source line of image, positioned on the screen at x
+static void build_row(const image_t* image, uint16_t line, int16_t x, uint8_t scale, uint32_t* row)
+{
+    memset(row, 0, ROW_WORDS * sizeof(uint32_t));
+    uint16_t size = ((uint32_t)image->width * image->height + 7) >> 3;
+    uint32_t offset = (uint32_t)line * image->width;
+    for (uint16_t column = 0; column < image->width; column += 8)
+    {
+        int16_t pos = x + (column * scale);
+        if (pos >= LCD_WIDTH)
+        {
+            break;
+        }
+        int16_t n = min((int16_t)(image->width - column), (int16_t)8);
+        if ((pos + (n * scale)) <= 0)
+        {
+            continue;
+        }
+        uint8_t bits = extract_pixels(image, offset + column, size);
+        place_bits(row, pos, expand_pixels(bits, scale), n * scale);
+    }
+}
+
+static void build_box(int16_t x, int16_t w, uint32_t* row)
+{
+    memset(row, 0, ROW_WORDS * sizeof(uint32_t));
+    for (int16_t i = 0; i < w; i += 32)
+    {
+        place_bits(row, x + i, 0xFFFFFFFFUL, min((int16_t)(w - i), (int16_t)32));
+    }
+}
+
+static void blit(uint8_t* buffer,
+                 const image_t* image,
+                 const image_t* mask,
+                 uint16_t src_y,
+                 uint16_t src_h,
+                 int16_t x,
+                 int16_t y,
+                 uint8_t scale,
+                 uint8_t mode)
+{
+    if (scale == 0)
+    {
+        scale = 1;
+    }
+    if (scale > SPRITE_MAX_SCALE)
+    {
+        scale = SPRITE_MAX_SCALE;
+    }
+
+    int16_t dst_w = image->width * scale;
+    int16_t dst_h = src_h * scale;
+    if ((x >= LCD_WIDTH) || ((x + dst_w) <= 0) || (y >= LCD_HEIGHT) || ((y + dst_h) <= 0))
+    {
+        return;
+    }
+
+    uint32_t src_row[ROW_WORDS];
+    uint32_t mask_row[ROW_WORDS];
+    if ((mask == NULL) && (mode == SPRITE_COPY))
+    {
+        build_box(x, dst_w, mask_row);
+    }
+
+    for (uint16_t line = 0; line < src_h; ++line)
+    {
+        int16_t dy = y + (line * scale);
+        if ((dy + scale) <= 0)
+        {
+            continue;
+        }
+        if (dy >= LCD_HEIGHT)
+        {
+            break;
+        }
+
+        build_row(image, src_y + line, x, scale, src_row);
+        if (mask != NULL)
+        {
+            build_row(mask, src_y + line, x, scale, mask_row);
+        }
+
+        for (uint8_t repeat = 0; repeat < scale; ++repeat, ++dy)
+        {
+            if ((dy < 0) || (dy >= LCD_HEIGHT))
+            {
+                continue;
+            }
+            uint32_t* dst = (uint32_t*)&buffer[dy * BYTES_PER_LINE];
+            for (uint8_t i = 0; i < WORDS_PER_LINE; ++i)
+            {
+                if ((mask != NULL) || (mode == SPRITE_COPY))
+                {
+                    dst[i] = (dst[i] & ~mask_row[i]) | (src_row[i] & mask_row[i]);
+                }
+                else if (mode == SPRITE_XOR)
+                {
+                    dst[i] ^= src_row[i];
+                }
+                else
+                {
+                    dst[i] |= src_row[i];
+                }
+            }
+        }
+    }
+    render_invalidate(x, dst_w);
+}
+
+void sprite_draw(uint8_t* buffer,
+                 const image_t* image,
+                 int16_t x,
+                 int16_t y,
+                 uint8_t scale,
+                 uint8_t mode)
+{
+    blit(buffer, image, NULL, 0, image->height, x, y, scale, mode);
+}
+
+void sprite_draw_masked(uint8_t* buffer,
+                        const image_t* image,
+                        const image_t* mask,
+                        int16_t x,
+                        int16_t y,
+                        uint8_t scale)
+{
+    blit(buffer, image, mask, 0, image->height, x, y, scale, SPRITE_COPY);
+}
+
+void sprite_draw_frame(uint8_t* buffer,
+                       const sprite_sheet_t* sheet,
+                       uint8_t frame,
+                       int16_t x,
+                       int16_t y,
+                       uint8_t scale,
+                       uint8_t mode)
+{
+    if (sheet->frame_count == 0)
+    {
+        return;
+    }
+    frame %= sheet->frame_count;
+    blit(buffer,
+         sheet->image,
+         sheet->mask,
+         frame * sheet->frame_height,
+         sheet->frame_height,
+         x,
+         y,
+         scale,
+         mode);
+}
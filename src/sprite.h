@@ -0,0 +1,59 @@
+#ifndef SPRITE_H_
+#define SPRITE_H_
+
+#include "images.h"
+
+#include <stdint.h>
+
+// Sprites are image_t bitmaps: a packed bitstream, most significant bit
+// leftmost, width * height bits long. They are blitted a row at a time into
+// a row-major frame buffer (see display.h) using 32 bit word operations,
+// clipped to the screen. The destination buffer must be word aligned.
+
+#define SPRITE_MAX_SCALE 4
+
+typedef enum
+{
+    // Set pixels are drawn, clear pixels let the background through
+    SPRITE_OR,
+    // The sprite box is opaque
+    SPRITE_COPY,
+    SPRITE_XOR,
+    SPRITE_MODE_MAX
+} sprite_mode_t;
+
+// Animation frames stacked vertically in one image, frame_height lines
+// each. An optional mask with the same layout selects opaque pixels.
+typedef struct
+{
+    const image_t* image;
+    const image_t* mask;
+    uint8_t frame_height;
+    uint8_t frame_count;
+} sprite_sheet_t;
+
+void sprite_draw(uint8_t* buffer,
+                 const image_t* image,
+                 int16_t x,
+                 int16_t y,
+                 uint8_t scale,
+                 uint8_t mode);
+
+// Pixels set in mask are copied from image, others keep the background
+void sprite_draw_masked(uint8_t* buffer,
+                        const image_t* image,
+                        const image_t* mask,
+                        int16_t x,
+                        int16_t y,
+                        uint8_t scale);
+
+// Draw one frame of a sheet, mode is ignored when the sheet has a mask
+void sprite_draw_frame(uint8_t* buffer,
+                       const sprite_sheet_t* sheet,
+                       uint8_t frame,
+                       int16_t x,
+                       int16_t y,
+                       uint8_t scale,
+                       uint8_t mode);
+
+#endif // SPRITE_H_
@@ -0,0 +1,342 @@
+#include "stall.h"
+
+#include "renderer.h"
+#include "utility.h"
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <string.h>
+
+// OSCULP32K / 32 like the power module's generator, but without
+// RUNSTDBY, so the watchdog is also frozen should standby be entered
+// with it running
+#define STALL_GCLK 2
+#define WDT_HZ 1024
+#define TICKS_MIN 8
+// Below the reset period, the early warning has to come first
+#define TICKS_MAX (STALL_RESET_MS / 2)
+#define RECORD_MAGIC 0x5354414CUL
+
+typedef struct
+{
+    uint32_t magic;
+    stall_record_t record;
+    uint32_t check;
+} retained_t;
+
+typedef struct
+{
+    bool armed;
+    bool paused;
+    volatile bool captured;
+    uint16_t ticks;
+    uint32_t budget_us;
+    uint32_t last_feed_us;
+    stall_stats_t stats;
+} stall_t;
+
+// Not cleared by the startup code, checked with the magic and check word
+static retained_t retained __attribute__((section(".noinit")));
+static stall_t stall;
+
+static uint32_t record_check()
+{
+    const uint32_t* words = (const uint32_t*)&retained.record;
+    uint32_t check = RECORD_MAGIC;
+    for (uint8_t i = 0; i < (sizeof(stall_record_t) / 4); ++i)
+    {
+        check = ((check << 5) | (check >> 27)) ^ words[i];
+    }
+    return check;
+}
+
+static bool record_valid()
+{
+    return (retained.magic == RECORD_MAGIC) && (retained.check == record_check());
+}
+
+static void record_seal()
+{
+    retained.magic = RECORD_MAGIC;
+    retained.check = record_check();
+}
+
+// Called with the render stack as it was when the loop stalled
+static void record_state(uint32_t pc, uint32_t lr, uint32_t stack_bytes)
+{
+    uint32_t count = record_valid() ? retained.record.count : 0;
+    stall_record_t* record = &retained.record;
+    record->pc = pc;
+    record->lr = lr;
+    record->state = (uint32_t)(uintptr_t)render_top();
+    record->depth = render_depth();
+    record->stack_bytes = stack_bytes;
+    record->reset = false;
+    record->loop_us = 0;
+    record->count = count + 1;
+    record_seal();
+}
+
+static void report()
+{
+    const stall_record_t* record = &retained.record;
+    Log("stall: %lu us%s, state 0x%08lx depth %u, pc 0x%08lx lr 0x%08lx, stack %lu B, %lu since last report",
+        (unsigned long)record->loop_us,
+        record->reset ? " (never returned)" : "",
+        (unsigned long)record->state,
+        record->depth,
+        (unsigned long)record->pc,
+        (unsigned long)record->lr,
+        (unsigned long)record->stack_bytes,
+        (unsigned long)record->count);
+    retained.magic = 0;
+}
+
+static uint8_t log2_ticks(uint16_t ticks)
+{
+    uint8_t n = 0;
+    while ((1u << (n + 1)) <= ticks)
+    {
+        ++n;
+    }
+    return n;
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+extern uint32_t __StackTop;
+// From the Arduino SAMD linker script, the heap starts at __end__
+extern uint32_t __bss_end__;
+extern uint32_t __end__;
+
+// Without noinit.ld the orphan .noinit can land on the heap or in .bss
+static bool retained_placed()
+{
+    uintptr_t start = (uintptr_t)&retained;
+    return (start >= (uintptr_t)&__bss_end__)
+        && ((start + sizeof(retained)) <= (uintptr_t)&__end__);
+}
+
+static void gclk_sync()
+{
+    while (GCLK->STATUS.bit.SYNCBUSY);
+}
+
+static void wdt_sync()
+{
+    while (WDT->STATUS.bit.SYNCBUSY);
+}
+
+static void wdt_begin()
+{
+    // DIVSEL divides by 2^(DIV + 1)
+    GCLK->GENDIV.reg = GCLK_GENDIV_ID(STALL_GCLK) | GCLK_GENDIV_DIV(4);
+    gclk_sync();
+    GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(STALL_GCLK)
+                      | GCLK_GENCTRL_SRC_OSCULP32K
+                      | GCLK_GENCTRL_DIVSEL
+                      | GCLK_GENCTRL_GENEN;
+    gclk_sync();
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_WDT
+                      | GCLK_CLKCTRL_GEN(STALL_GCLK)
+                      | GCLK_CLKCTRL_CLKEN;
+    gclk_sync();
+
+    NVIC_DisableIRQ(WDT_IRQn);
+    NVIC_ClearPendingIRQ(WDT_IRQn);
+    // Above everything else, a stall inside another handler is still seen
+    NVIC_SetPriority(WDT_IRQn, 0);
+    NVIC_EnableIRQ(WDT_IRQn);
+}
+
+static void wdt_enable(bool enable)
+{
+    WDT->CTRL.reg = 0;
+    wdt_sync();
+    if (!enable)
+    {
+        return;
+    }
+    // Both count in 2^(n + 3) ticks
+    WDT->CONFIG.reg = WDT_CONFIG_PER(log2_ticks(STALL_RESET_MS) - 3);
+    WDT->EWCTRL.reg = WDT_EWCTRL_EWOFFSET(log2_ticks(stall.ticks) - 3);
+    WDT->INTFLAG.reg = WDT_INTFLAG_EW;
+    WDT->INTENSET.reg = WDT_INTENSET_EW;
+    WDT->CTRL.reg = WDT_CTRL_ENABLE;
+    wdt_sync();
+}
+
+static void wdt_clear()
+{
+    // Writing CLEAR while a previous one synchronizes stalls the bus for
+    // several watchdog ticks, skip it, the next feed gets through
+    if (!WDT->STATUS.bit.SYNCBUSY)
+    {
+        WDT->CLEAR.reg = WDT_CLEAR_CLEAR_KEY;
+    }
+}
+
+static bool reset_by_watchdog()
+{
+    return PM->RCAUSE.bit.WDT;
+}
+
+// frame is the exception frame the core pushed: r0-r3, r12, lr, pc, xPSR
+extern "C" void stall_capture(const uint32_t* frame)
+{
+    WDT->INTFLAG.reg = WDT_INTFLAG_EW;
+    uint32_t stack_bytes = (uint32_t)&__StackTop - (uint32_t)&frame[8];
+    record_state(frame[6], frame[5], stack_bytes);
+    stall.captured = true;
+}
+
+// Only the main stack is in use, so sp points at the exception frame
+extern "C" __attribute__((naked)) void WDT_Handler()
+{
+    __asm__ volatile(
+        "mov r0, sp\n"
+        "ldr r1, =stall_capture\n"
+        "bx r1\n");
+}
+
+#else
+
+static void wdt_begin()
+{
+}
+
+static void wdt_enable(bool enable)
+{
+    UNUSED(enable);
+}
+
+static void wdt_clear()
+{
+}
+
+static bool reset_by_watchdog()
+{
+    return false;
+}
+
+static bool retained_placed()
+{
+    return true;
+}
+
+#endif
+
+void stall_init()
+{
+    if (!retained_placed())
+    {
+        // Whatever is there was cleared or overwritten, do not report it
+        Log("stall: record at 0x%08lx is not in .noinit, check noinit.ld",
+            (unsigned long)(uintptr_t)&retained);
+        retained.magic = 0;
+    }
+    else if (record_valid())
+    {
+        // Reported records are invalidated, whatever ended that loop
+        // iteration, it never came back
+        retained.record.reset = true;
+        if (reset_by_watchdog())
+        {
+            Log("stall: reset by the watchdog");
+        }
+        report();
+    }
+    stall_reset_stats();
+    stall_set_bus_hz(display->bus_speed());
+    wdt_begin();
+    wdt_enable(true);
+    stall.armed = true;
+    stall.paused = false;
+    stall.last_feed_us = micros();
+}
+
+void stall_feed()
+{
+    uint32_t now = micros();
+    uint32_t loop_us = now - stall.last_feed_us;
+    stall.last_feed_us = now;
+    if (!stall.armed || stall.paused)
+    {
+        return;
+    }
+    wdt_clear();
+
+    if (loop_us > stall.stats.loop_us_max)
+    {
+        stall.stats.loop_us_max = loop_us;
+    }
+    // The watchdog counts from the last clear that got through, so it may
+    // fire a little before the software budget
+    if (!stall.captured && (loop_us <= stall.budget_us))
+    {
+        return;
+    }
+    ++stall.stats.stalls;
+    if (!stall.captured)
+    {
+        // No early warning, off the SAMD21 or when the watchdog was
+        // cleared late, so there is no PC to report
+        record_state(0, 0, 0);
+    }
+    stall.captured = false;
+    retained.record.loop_us = loop_us;
+    record_seal();
+    report();
+}
+
+void stall_pause(bool pause)
+{
+    if (!stall.armed || (pause == stall.paused))
+    {
+        return;
+    }
+    wdt_enable(!pause);
+    stall.paused = pause;
+    stall.last_feed_us = micros();
+}
+
+uint32_t stall_set_budget_ms(uint32_t ms)
+{
+    uint16_t ticks = TICKS_MIN;
+    while ((ticks < ms) && (ticks < TICKS_MAX))
+    {
+        ticks <<= 1;
+    }
+    stall.ticks = ticks;
+    stall.budget_us = ((uint32_t)ticks * 1000000UL) / WDT_HZ;
+    if (stall.armed && !stall.paused)
+    {
+        wdt_enable(true);
+    }
+    return stall_budget_ms();
+}
+
+uint32_t stall_set_bus_hz(uint32_t hz)
+{
+    if (hz == 0)
+    {
+        hz = I2C_STANDARD_HZ;
+    }
+    uint32_t flush_ms = ((STALL_FLUSH_CLOCKS * 1000UL) + hz - 1) / hz;
+    return stall_set_budget_ms(STALL_BUDGET_MS + flush_ms);
+}
+
+uint32_t stall_budget_ms()
+{
+    return stall.budget_us / 1000;
+}
+
+const stall_stats_t* stall_stats()
+{
+    return &stall.stats;
+}
+
+void stall_reset_stats()
+{
+    memset(&stall.stats, 0, sizeof(stall.stats));
+}
@@ -0,0 +1,74 @@
+#ifndef STALL_H_
+#define STALL_H_
+
+#include "display.h"
+
+#include <stdint.h>
+
+// Main loop stall detector. stall_feed() runs at the top of every loop()
+// iteration and restarts the SAMD21 watchdog. When an iteration runs past
+// the budget the watchdog's early warning interrupt records where the
+// core was: the interrupted PC and LR, the render state on top of the
+// stack, the render stack depth and how much of the main stack is in use.
+// The record sits in .noinit, RAM that startup code does not clear, so a
+// stall that never returns and ends in the watchdog reset is still there
+// after the reboot. The stock Arduino SAMD linker script has no .noinit,
+// noinit.ld inserts one after .bss and stall_init() checks the record
+// landed between the end of .bss and the heap.
+//
+// A stall that returns is reported with Log() from the next stall_feed(),
+// together with how long the iteration ran; one carried over a reset is
+// reported from stall_init(). PCs and states are addresses, look them up
+// in the firmware's ELF with tools/profile.py symbolize.
+//
+// The watchdog runs from OSCULP32K / 32, so budgets are powers of two
+// between 8 and 2048 ticks of about 1 ms. Off the SAMD21 the loop time is
+// still checked in stall_feed(), without a PC.
+
+// Budget for one loop() iteration, about two frames at 30 FPS, on top of
+// the time a full frame flush takes at the probed bus clock
+#define STALL_BUDGET_MS 64
+// A full flush on the wire: every page with its addressing commands, at 9
+// clocks per byte with the acknowledge
+#define STALL_FLUSH_BYTES (DISPLAY_PAGES * (PAGE_BYTES + 8))
+#define STALL_FLUSH_CLOCKS (STALL_FLUSH_BYTES * 9UL)
+// An iteration this long is taken as a hang and resets the device
+#define STALL_RESET_MS 4096
+
+typedef struct
+{
+    uint32_t pc;
+    uint32_t lr;
+    // render_function_t on top of the stack, 0 when it was empty
+    uint32_t state;
+    uint32_t stack_bytes;
+    uint8_t depth;
+    // The record survived a reset
+    bool reset;
+    // Length of the stalled iteration, 0 if it never returned
+    uint32_t loop_us;
+    // Stalls since the last report, only the latest is kept in full
+    uint32_t count;
+} stall_record_t;
+
+typedef struct
+{
+    uint32_t stalls;
+    uint32_t loop_us_max;
+} stall_stats_t;
+
+// Reports a record left by a watchdog reset and starts the watchdog
+void stall_init();
+void stall_feed();
+// Stop the watchdog around standby, it would otherwise count sleep
+void stall_pause(bool pause);
+// Rounded up to what the watchdog can do, returns the budget in effect
+uint32_t stall_set_budget_ms(uint32_t ms);
+// STALL_BUDGET_MS plus a full flush at hz, 0 for the slowest clock, e.g.
+// after the bus speed changed. Returns the budget in effect.
+uint32_t stall_set_bus_hz(uint32_t hz);
+uint32_t stall_budget_ms();
+const stall_stats_t* stall_stats();
+void stall_reset_stats();
+
+#endif // STALL_H_
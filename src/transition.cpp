@@ -0,0 +1,152 @@
+#include "transition.h"
+
+#include "display.h"
+
+#include <stdint.h>
+
+static const uint8_t bayer[4][4] = {
+    { 0, 8, 2, 10 },
+    { 12, 4, 14, 6 },
+    { 3, 11, 1, 9 },
+    { 15, 7, 13, 5 },
+};
+
+// 32 pixels of a line starting at column bit, blank off screen
+static inline uint32_t line_bits(const uint32_t* line, int16_t bit)
+{
+    if ((bit <= -32) || (bit >= LCD_WIDTH))
+    {
+        return 0;
+    }
+    int8_t word = bit >> 5;
+    uint8_t shift = bit & 31;
+    uint32_t lo = ((word >= 0) && (word < WORDS_PER_LINE)) ? line[word] : 0;
+    if (shift == 0)
+    {
+        return lo;
+    }
+    uint32_t hi = ((word + 1) < WORDS_PER_LINE) ? line[word + 1] : 0;
+    return (lo >> shift) | (hi << (32 - shift));
+}
+
+// Columns [first, last) of word w
+static inline uint32_t column_mask(uint8_t w, int16_t first, int16_t last)
+{
+    int16_t lo = first - (w * 32);
+    int16_t hi = last - (w * 32);
+    uint32_t mask = (hi >= 32) ? 0xFFFFFFFFUL : ((hi <= 0) ? 0 : ((1UL << hi) - 1));
+    if (lo > 0)
+    {
+        mask &= (lo >= 32) ? 0 : ~((1UL << lo) - 1);
+    }
+    return mask;
+}
+
+static uint32_t dither_mask(uint8_t row, uint8_t level)
+{
+    uint32_t pattern = 0;
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        if (bayer[row][i] < level)
+        {
+            pattern |= 1 << i;
+        }
+    }
+    return pattern * 0x11111111UL;
+}
+
+uint16_t transition_compose(uint8_t type,
+                            bool reverse,
+                            const uint8_t* from,
+                            const uint8_t* to,
+                            uint16_t progress,
+                            uint8_t* out)
+{
+    if (progress > TRANSITION_SPAN)
+    {
+        progress = TRANSITION_SPAN;
+    }
+    if ((type == TRANSITION_NONE) || (type >= TRANSITION_MAX))
+    {
+        progress = TRANSITION_SPAN;
+    }
+
+    const uint32_t* src = (const uint32_t*)from;
+    const uint32_t* dst = (const uint32_t*)to;
+    uint32_t* result = (uint32_t*)out;
+
+    // Per frame setup so the inner loop is only word operations
+    int16_t offset = progress;
+    uint32_t masks[4];
+    uint32_t invert_from = 0;
+    uint32_t invert_to = 0;
+    uint32_t keep_from = 0xFFFFFFFFUL;
+    uint32_t keep_to = 0;
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        if (type == TRANSITION_WIPE)
+        {
+            masks[i] = reverse ? column_mask(i, LCD_WIDTH - offset, LCD_WIDTH) : column_mask(i, 0, offset);
+        }
+        else
+        {
+            masks[i] = dither_mask(i, progress >> 3);
+        }
+    }
+    if (type == TRANSITION_XOR_FLASH)
+    {
+        uint8_t stage = (progress * 3) >> 7;
+        keep_from = (stage < 2) ? 0xFFFFFFFFUL : 0;
+        keep_to = (stage > 0) ? 0xFFFFFFFFUL : 0;
+        invert_from = (stage == 0) ? 0xFFFFFFFFUL : 0;
+        invert_to = (stage == 2) ? 0xFFFFFFFFUL : 0;
+    }
+
+    uint32_t changed[WORDS_PER_LINE] = { 0 };
+    for (uint8_t y = 0; y < LCD_HEIGHT; ++y)
+    {
+        const uint32_t* a = &src[y * WORDS_PER_LINE];
+        const uint32_t* b = &dst[y * WORDS_PER_LINE];
+        uint32_t* line = &result[y * WORDS_PER_LINE];
+        for (uint8_t w = 0; w < WORDS_PER_LINE; ++w)
+        {
+            uint32_t value;
+            if (progress == TRANSITION_SPAN)
+            {
+                value = b[w];
+            }
+            else if (type == TRANSITION_SLIDE)
+            {
+                int16_t bit = w * 32;
+                value = reverse
+                    ? line_bits(a, bit - offset) | line_bits(b, bit - offset + LCD_WIDTH)
+                    : line_bits(a, bit + offset) | line_bits(b, bit + offset - LCD_WIDTH);
+            }
+            else if (type == TRANSITION_XOR_FLASH)
+            {
+                value = ((a[w] & keep_from) ^ (b[w] & keep_to)) ^ invert_from ^ invert_to;
+            }
+            else
+            {
+                uint32_t mask = (type == TRANSITION_WIPE) ? masks[w] : masks[y & 3];
+                value = (a[w] & ~mask) | (b[w] & mask);
+            }
+            changed[w] |= line[w] ^ value;
+            line[w] = value;
+        }
+    }
+
+    // Each byte column of the frame is one display page
+    uint16_t pages = 0;
+    for (uint8_t w = 0; w < WORDS_PER_LINE; ++w)
+    {
+        for (uint8_t i = 0; i < 4; ++i)
+        {
+            if (changed[w] & (0xFFUL << (i * 8)))
+            {
+                pages |= 1 << ((w * 4) + i);
+            }
+        }
+    }
+    return pages;
+}
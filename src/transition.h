@@ -0,0 +1,35 @@
+#ifndef TRANSITION_H_
+#define TRANSITION_H_
+
+#include <stdint.h>
+
+// Full screen transitions between two row-major frames, composed a 32 bit
+// word at a time. Progress runs from 0 (all outgoing) to TRANSITION_SPAN
+// (all incoming). Reverse runs the spatial ones the other way, for pops.
+
+#define TRANSITION_SPAN (128)
+
+typedef enum
+{
+    TRANSITION_NONE,
+    // Incoming frame uncovered behind a moving edge
+    TRANSITION_WIPE,
+    // Incoming frame pushes the outgoing one off screen
+    TRANSITION_SLIDE,
+    // Ordered dither mask that fills in 16 steps
+    TRANSITION_DISSOLVE,
+    // Inverted outgoing, both XORed, inverted incoming
+    TRANSITION_XOR_FLASH,
+    TRANSITION_MAX
+} transition_t;
+
+// Compose into out, which holds the previous composition, and return the
+// display pages whose contents changed
+uint16_t transition_compose(uint8_t type,
+                            bool reverse,
+                            const uint8_t* from,
+                            const uint8_t* to,
+                            uint16_t progress,
+                            uint8_t* out);
+
+#endif // TRANSITION_H_
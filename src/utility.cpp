@@ -4,8 +4,30 @@
 
 #define BUFFER_LENGTH 128
 
+static uint8_t mask = LOG_ALL;
+static log_listener_t listener = NULL;
+
+void log_set_mask(uint8_t new_mask)
+{
+    mask = new_mask;
+}
+
+uint8_t log_mask()
+{
+    return mask;
+}
+
+void log_set_listener(log_listener_t new_listener)
+{
+    listener = new_listener;
+}
+
 void Log(const __FlashStringHelper *format, ...)
 {
+  if (!(mask & LOG_GENERAL) && (listener == NULL))
+  {
+    return;
+  }
   char buffer[BUFFER_LENGTH];
   va_list args;
   va_start (args, format);
@@ -15,17 +37,37 @@ void Log(const __FlashStringHelper *format, ...)
   vsnprintf(buffer, sizeof(buffer), (const char *)format, args);
 #endif
   va_end(args);
+  if (listener != NULL)
+  {
+    listener(buffer);
+  }
+  if (!(mask & LOG_GENERAL))
+  {
+    return;
+  }
   Serial.print(buffer);
   Serial.flush();
 }
 
 void Log(const char* format, ...)
 {
+    if (!(mask & LOG_GENERAL) && (listener == NULL))
+    {
+        return;
+    }
     char buffer[BUFFER_LENGTH];
     va_list args;
     va_start(args, format);
     vsnprintf(buffer, BUFFER_LENGTH, format, args);
     va_end(args);
+    if (listener != NULL)
+    {
+        listener(buffer);
+    }
+    if (!(mask & LOG_GENERAL))
+    {
+        return;
+    }
     Serial.println(buffer);
     Serial.flush();
 }
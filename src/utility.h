@@ -10,7 +10,20 @@
 
 #define UNUSED(x) ((void)(x))
 
+// Log() output is dropped unless LOG_GENERAL is in the mask, e.g. while a
+// host talks the binary protocol (see protocol.h)
+#define LOG_GENERAL  0x01
+#define LOG_PROTOCOL 0x02
+#define LOG_ALL      0xFF
+
+// Receives every formatted Log() line whatever the mask, e.g. to show it
+// on screen
+typedef void(*log_listener_t)(const char* line);
+
 void Log(const __FlashStringHelper *fmt, ... );
 void Log(const char* format, ...);
+void log_set_mask(uint8_t mask);
+uint8_t log_mask();
+void log_set_listener(log_listener_t listener);
 
 #endif //UTILITY_H
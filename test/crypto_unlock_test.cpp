@@ -0,0 +1,148 @@
+// CRYPTO UNLOCK per frame work: after the first frame only changed cells
+// are drawn, so a frame's glyphs and pixels are bounded by the cells that
+// cycle or lock in it and not by the size of the grid. Each level is
+// played with scripted buttons on the virtual clock, and the slowest
+// frame, which is the emulated bus time of its flush, has to fit the
+// default frame rate.
+
+#include "host.h"
+
+#include "buttons.h"
+#include "renderer.h"
+#include "render_states/crypto_unlock.h"
+#include "render_states/register_read.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SEED 0x1234
+#define FRAME_MS 33
+#define PLAY_MS 8000
+#define PRESS_MS 200
+#define FRAME_BUDGET_US (1000000UL / DEFAULT_TARGET_FPS)
+// Cells that may change in one frame on any level: the largest cycle
+// count and the cells locked by one key
+#define CHANGED_CELLS_MAX 32
+// The key bar is three icon, separator and codepoint glyphs
+#define KEY_GLYPHS 9
+// Box cleared, filled in the overlay when locked, and a size 2 glyph
+#define CELL_PIXELS_MAX ((2 * 11 * 16) + (5 * 7 * 4))
+
+typedef struct
+{
+    crypto_level_t level;
+    const char* name;
+    // rows * columns, as in crypto_unlock.cpp
+    uint16_t cells;
+} level_case_t;
+
+static const level_case_t levels[] = {
+    { CRYPTO_LEVEL_EASY, "EASY", 3 * 11 },
+    { CRYPTO_LEVEL_NORMAL, "NORMAL", 5 * 16 },
+    { CRYPTO_LEVEL_HARD, "HARD", 7 * 21 },
+};
+
+static const uint8_t keys[] = {
+    BUTTON_UP_STATE_MASK,
+    BUTTON_SEL_STATE_MASK,
+    BUTTON_DOWN_STATE_MASK,
+};
+
+static uint32_t now_ms = 0;
+static uint8_t buttons = BUTTON_ALL_MASK;
+
+static uint32_t test_clock()
+{
+    return now_ms;
+}
+
+static uint8_t test_buttons()
+{
+    return buttons;
+}
+
+static bool play(const level_case_t* test)
+{
+    srand(SEED);
+    register_unlocked = false;
+    crypto_unlock_set_level(test->level);
+    push_render_function(crypto_unlock_render);
+    render_reset_stats();
+
+    bool pass = true;
+    uint32_t glyphs_max = 0;
+    uint32_t pixels_max = 0;
+    uint32_t start_ms = now_ms;
+    for (uint32_t t = 0; (t < PLAY_MS) && (render_top() == crypto_unlock_render); t += FRAME_MS)
+    {
+        // A key is held for every other PRESS_MS, in turn
+        uint32_t press = t / PRESS_MS;
+        buttons = (press & 1) ? (uint8_t)(BUTTON_ALL_MASK & ~keys[(press / 2) % sizeof(keys)]) : BUTTON_ALL_MASK;
+        now_ms = start_ms + t;
+
+        uint32_t glyphs = host_glyphs();
+        const display_stats_t& stats = display->stats();
+        uint32_t pixels = stats.pixel_ops + stats.rect_pixels;
+        render();
+        glyphs = host_glyphs() - glyphs;
+        pixels = (stats.pixel_ops + stats.rect_pixels) - pixels;
+
+        if (t == 0)
+        {
+            // The whole grid is drawn once on entry
+            if (glyphs < test->cells)
+            {
+                printf("    %s entry drew %u glyphs for %u cells\n", test->name, glyphs, test->cells);
+                pass = false;
+            }
+            continue;
+        }
+        if (glyphs > (CHANGED_CELLS_MAX + KEY_GLYPHS))
+        {
+            printf("    %s frame at %u ms drew %u glyphs\n", test->name, t, glyphs);
+            pass = false;
+        }
+        if (pixels > (glyphs * CELL_PIXELS_MAX))
+        {
+            printf("    %s frame at %u ms drew %u pixels for %u glyphs\n", test->name, t, pixels, glyphs);
+            pass = false;
+        }
+        glyphs_max = (glyphs > glyphs_max) ? glyphs : glyphs_max;
+        pixels_max = (pixels > pixels_max) ? pixels : pixels_max;
+    }
+
+    uint32_t worst_us = render_stats()->frame_us_max;
+    if (worst_us > FRAME_BUDGET_US)
+    {
+        printf("    %s worst frame %u us over the %u us budget\n", test->name, worst_us, (unsigned)FRAME_BUDGET_US);
+        pass = false;
+    }
+    printf("%-6s %3u cells, at most %u glyphs and %u pixels a frame, %u us worst\n",
+           test->name, test->cells, glyphs_max, pixels_max, worst_us);
+
+    buttons = BUTTON_ALL_MASK;
+    while (render_depth() > 0)
+    {
+        pop_render_function();
+    }
+    now_ms += PLAY_MS;
+    render();
+    return pass;
+}
+
+int main()
+{
+    render_init();
+    render_set_clock(test_clock);
+    set_button_source(test_buttons);
+    render_set_target_fps(0);
+
+    bool pass = true;
+    for (uint8_t i = 0; i < (sizeof(levels) / sizeof(levels[0])); ++i)
+    {
+        pass &= play(&levels[i]);
+    }
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
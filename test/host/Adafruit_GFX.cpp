@@ -0,0 +1,239 @@
+#include "Adafruit_GFX.h"
+
+#include "host.h"
+
+#include "glcdfont.c"
+
+#define CHAR_COLUMNS 5
+#define CHAR_ADVANCE 6
+#define CHAR_LINES 8
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h)
+    : WIDTH(w),
+      HEIGHT(h),
+      _width(w),
+      _height(h),
+      cursor_x(0),
+      cursor_y(0),
+      textcolor(0xFFFF),
+      textbgcolor(0xFFFF),
+      textsize_x(1),
+      textsize_y(1),
+      rotation(0),
+      wrap(true),
+      _cp437(false)
+{
+}
+
+void Adafruit_GFX::writePixel(int16_t x, int16_t y, uint16_t color)
+{
+    drawPixel(x, y, color);
+}
+
+void Adafruit_GFX::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    fillRect(x, y, w, h, color);
+}
+
+void Adafruit_GFX::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    drawFastVLine(x, y, h, color);
+}
+
+void Adafruit_GFX::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    drawFastHLine(x, y, w, color);
+}
+
+void Adafruit_GFX::setRotation(uint8_t r)
+{
+    rotation = r & 3;
+    bool swap = (rotation & 1) != 0;
+    _width = swap ? HEIGHT : WIDTH;
+    _height = swap ? WIDTH : HEIGHT;
+}
+
+void Adafruit_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    startWrite();
+    for (int16_t i = y; i < y + h; ++i)
+    {
+        writePixel(x, i, color);
+    }
+    endWrite();
+}
+
+void Adafruit_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    startWrite();
+    for (int16_t i = x; i < x + w; ++i)
+    {
+        writePixel(i, y, color);
+    }
+    endWrite();
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    startWrite();
+    for (int16_t i = x; i < x + w; ++i)
+    {
+        writeFastVLine(i, y, h, color);
+    }
+    endWrite();
+}
+
+void Adafruit_GFX::fillScreen(uint16_t color)
+{
+    fillRect(0, 0, _width, _height, color);
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    startWrite();
+    writeFastHLine(x, y, w, color);
+    writeFastHLine(x, y + h - 1, w, color);
+    writeFastVLine(x, y, h, color);
+    writeFastVLine(x + w - 1, y, h, color);
+    endWrite();
+}
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size)
+{
+    if ((x >= _width) || (y >= _height)
+        || ((x + (CHAR_ADVANCE * size) - 1) < 0)
+        || ((y + (CHAR_LINES * size) - 1) < 0))
+    {
+        return;
+    }
+    // The library's original table skipped code 176
+    if (!_cp437 && (c >= 176))
+    {
+        ++c;
+    }
+    host_count_glyph();
+
+    startWrite();
+    for (int8_t i = 0; i < CHAR_COLUMNS; ++i)
+    {
+        uint8_t line = pgm_read_byte(&font[(c * CHAR_COLUMNS) + i]);
+        for (int8_t j = 0; j < CHAR_LINES; ++j, line >>= 1)
+        {
+            if (line & 1)
+            {
+                if (size == 1)
+                {
+                    writePixel(x + i, y + j, color);
+                }
+                else
+                {
+                    writeFillRect(x + (i * size), y + (j * size), size, size, color);
+                }
+            }
+            else if (bg != color)
+            {
+                if (size == 1)
+                {
+                    writePixel(x + i, y + j, bg);
+                }
+                else
+                {
+                    writeFillRect(x + (i * size), y + (j * size), size, size, bg);
+                }
+            }
+        }
+    }
+    // Opaque text also fills the gap column
+    if (bg != color)
+    {
+        if (size == 1)
+        {
+            writeFastVLine(x + CHAR_COLUMNS, y, CHAR_LINES, bg);
+        }
+        else
+        {
+            writeFillRect(x + (CHAR_COLUMNS * size), y, size, CHAR_LINES * size, bg);
+        }
+    }
+    endWrite();
+}
+
+void Adafruit_GFX::setCursor(int16_t x, int16_t y)
+{
+    cursor_x = x;
+    cursor_y = y;
+}
+
+void Adafruit_GFX::setTextColor(uint16_t c)
+{
+    // Same color for both means a transparent background
+    textcolor = c;
+    textbgcolor = c;
+}
+
+void Adafruit_GFX::setTextColor(uint16_t c, uint16_t bg)
+{
+    textcolor = c;
+    textbgcolor = bg;
+}
+
+void Adafruit_GFX::setTextSize(uint8_t s)
+{
+    textsize_x = (s > 0) ? s : 1;
+    textsize_y = textsize_x;
+}
+
+void Adafruit_GFX::setTextWrap(bool w)
+{
+    wrap = w;
+}
+
+void Adafruit_GFX::cp437(bool x)
+{
+    _cp437 = x;
+}
+
+size_t Adafruit_GFX::write(uint8_t c)
+{
+    if (c == '\n')
+    {
+        cursor_x = 0;
+        cursor_y += textsize_y * CHAR_LINES;
+    }
+    else if (c != '\r')
+    {
+        if (wrap && ((cursor_x + (textsize_x * CHAR_ADVANCE)) > _width))
+        {
+            cursor_x = 0;
+            cursor_y += textsize_y * CHAR_LINES;
+        }
+        drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x);
+        cursor_x += textsize_x * CHAR_ADVANCE;
+    }
+    return 1;
+}
+
+int16_t Adafruit_GFX::width() const
+{
+    return _width;
+}
+
+int16_t Adafruit_GFX::height() const
+{
+    return _height;
+}
+
+uint8_t Adafruit_GFX::getRotation() const
+{
+    return rotation;
+}
+
+int16_t Adafruit_GFX::getCursorX() const
+{
+    return cursor_x;
+}
+
+int16_t Adafruit_GFX::getCursorY() const
+{
+    return cursor_y;
+}
@@ -0,0 +1,68 @@
+#ifndef HOST_ADAFRUIT_GFX_H_
+#define HOST_ADAFRUIT_GFX_H_
+
+#include <Arduino.h>
+
+// The part of Adafruit GFX CipherPal draws with, for the host tests. The
+// primitives follow the library's code (classic font text, rotation,
+// rectangles) so pixel and rectangle counts match it. The glyphs come
+// from glcdfont.c next to this file: printable ASCII is the classic 5x7
+// font, the other codes are placeholders, so golden frames pin the
+// firmware's drawing and layout rather than the library's glyphs.
+class Adafruit_GFX : public Print
+{
+public:
+    Adafruit_GFX(int16_t w, int16_t h);
+    virtual ~Adafruit_GFX() {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    virtual void startWrite() {}
+    virtual void writePixel(int16_t x, int16_t y, uint16_t color);
+    virtual void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    virtual void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    virtual void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    virtual void endWrite() {}
+
+    virtual void setRotation(uint8_t r);
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    virtual void fillScreen(uint16_t color);
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size);
+
+    void setCursor(int16_t x, int16_t y);
+    void setTextColor(uint16_t c);
+    void setTextColor(uint16_t c, uint16_t bg);
+    void setTextSize(uint8_t s);
+    void setTextWrap(bool w);
+    void cp437(bool x = true);
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    int16_t width() const;
+    int16_t height() const;
+    uint8_t getRotation() const;
+    int16_t getCursorX() const;
+    int16_t getCursorY() const;
+
+protected:
+    const int16_t WIDTH;
+    const int16_t HEIGHT;
+    int16_t _width;
+    int16_t _height;
+    int16_t cursor_x;
+    int16_t cursor_y;
+    uint16_t textcolor;
+    uint16_t textbgcolor;
+    uint8_t textsize_x;
+    uint8_t textsize_y;
+    uint8_t rotation;
+    bool wrap;
+    bool _cp437;
+};
+
+#endif // HOST_ADAFRUIT_GFX_H_
@@ -0,0 +1,270 @@
+// Glyph table for the host Adafruit GFX, 5 bytes per code, column-major
+// with bit 0 at the top. Printable ASCII and the menu arrows (0x18,
+// 0x19) are the classic 5x7 font, the other codes are boxes holding
+// the code's bits.
+
+#ifndef FONT5X7_H
+#define FONT5X7_H
+
+#include <Arduino.h>
+
+static const unsigned char font[] PROGMEM = {
+    0x7F, 0x41, 0x41, 0x41, 0x7F,
+    0x7F, 0x43, 0x41, 0x43, 0x7F,
+    0x7F, 0x45, 0x41, 0x45, 0x7F,
+    0x7F, 0x47, 0x41, 0x47, 0x7F,
+    0x7F, 0x49, 0x41, 0x49, 0x7F,
+    0x7F, 0x4B, 0x41, 0x4B, 0x7F,
+    0x7F, 0x4D, 0x41, 0x4D, 0x7F,
+    0x7F, 0x4F, 0x41, 0x4F, 0x7F,
+    0x7F, 0x51, 0x41, 0x51, 0x7F,
+    0x7F, 0x53, 0x41, 0x53, 0x7F,
+    0x7F, 0x55, 0x41, 0x55, 0x7F,
+    0x7F, 0x57, 0x41, 0x57, 0x7F,
+    0x7F, 0x59, 0x41, 0x59, 0x7F,
+    0x7F, 0x5B, 0x41, 0x5B, 0x7F,
+    0x7F, 0x5D, 0x41, 0x5D, 0x7F,
+    0x7F, 0x5F, 0x41, 0x5F, 0x7F,
+    0x7F, 0x61, 0x41, 0x61, 0x7F,
+    0x7F, 0x63, 0x41, 0x63, 0x7F,
+    0x7F, 0x65, 0x41, 0x65, 0x7F,
+    0x7F, 0x67, 0x41, 0x67, 0x7F,
+    0x7F, 0x69, 0x41, 0x69, 0x7F,
+    0x7F, 0x6B, 0x41, 0x6B, 0x7F,
+    0x7F, 0x6D, 0x41, 0x6D, 0x7F,
+    0x7F, 0x6F, 0x41, 0x6F, 0x7F,
+    0x04, 0x02, 0x7F, 0x02, 0x04,
+    0x10, 0x20, 0x7F, 0x20, 0x10,
+    0x7F, 0x75, 0x41, 0x75, 0x7F,
+    0x7F, 0x77, 0x41, 0x77, 0x7F,
+    0x7F, 0x79, 0x41, 0x79, 0x7F,
+    0x7F, 0x7B, 0x41, 0x7B, 0x7F,
+    0x7F, 0x7D, 0x41, 0x7D, 0x7F,
+    0x7F, 0x7F, 0x41, 0x7F, 0x7F,
+    0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x5F, 0x00, 0x00,
+    0x00, 0x07, 0x00, 0x07, 0x00,
+    0x14, 0x7F, 0x14, 0x7F, 0x14,
+    0x24, 0x2A, 0x7F, 0x2A, 0x12,
+    0x23, 0x13, 0x08, 0x64, 0x62,
+    0x36, 0x49, 0x56, 0x20, 0x50,
+    0x00, 0x08, 0x07, 0x03, 0x00,
+    0x00, 0x1C, 0x22, 0x41, 0x00,
+    0x00, 0x41, 0x22, 0x1C, 0x00,
+    0x2A, 0x1C, 0x7F, 0x1C, 0x2A,
+    0x08, 0x08, 0x3E, 0x08, 0x08,
+    0x00, 0x80, 0x70, 0x30, 0x00,
+    0x08, 0x08, 0x08, 0x08, 0x08,
+    0x00, 0x00, 0x60, 0x60, 0x00,
+    0x20, 0x10, 0x08, 0x04, 0x02,
+    0x3E, 0x51, 0x49, 0x45, 0x3E,
+    0x00, 0x42, 0x7F, 0x40, 0x00,
+    0x72, 0x49, 0x49, 0x49, 0x46,
+    0x21, 0x41, 0x49, 0x4D, 0x33,
+    0x18, 0x14, 0x12, 0x7F, 0x10,
+    0x27, 0x45, 0x45, 0x45, 0x39,
+    0x3C, 0x4A, 0x49, 0x49, 0x31,
+    0x41, 0x21, 0x11, 0x09, 0x07,
+    0x36, 0x49, 0x49, 0x49, 0x36,
+    0x46, 0x49, 0x49, 0x29, 0x1E,
+    0x00, 0x00, 0x14, 0x00, 0x00,
+    0x00, 0x40, 0x34, 0x00, 0x00,
+    0x00, 0x08, 0x14, 0x22, 0x41,
+    0x14, 0x14, 0x14, 0x14, 0x14,
+    0x00, 0x41, 0x22, 0x14, 0x08,
+    0x02, 0x01, 0x59, 0x09, 0x06,
+    0x3E, 0x41, 0x5D, 0x59, 0x4E,
+    0x7C, 0x12, 0x11, 0x12, 0x7C,
+    0x7F, 0x49, 0x49, 0x49, 0x36,
+    0x3E, 0x41, 0x41, 0x41, 0x22,
+    0x7F, 0x41, 0x41, 0x41, 0x3E,
+    0x7F, 0x49, 0x49, 0x49, 0x41,
+    0x7F, 0x09, 0x09, 0x09, 0x01,
+    0x3E, 0x41, 0x41, 0x51, 0x73,
+    0x7F, 0x08, 0x08, 0x08, 0x7F,
+    0x00, 0x41, 0x7F, 0x41, 0x00,
+    0x20, 0x40, 0x41, 0x3F, 0x01,
+    0x7F, 0x08, 0x14, 0x22, 0x41,
+    0x7F, 0x40, 0x40, 0x40, 0x40,
+    0x7F, 0x02, 0x1C, 0x02, 0x7F,
+    0x7F, 0x04, 0x08, 0x10, 0x7F,
+    0x3E, 0x41, 0x41, 0x41, 0x3E,
+    0x7F, 0x09, 0x09, 0x09, 0x06,
+    0x3E, 0x41, 0x51, 0x21, 0x5E,
+    0x7F, 0x09, 0x19, 0x29, 0x46,
+    0x26, 0x49, 0x49, 0x49, 0x32,
+    0x03, 0x01, 0x7F, 0x01, 0x03,
+    0x3F, 0x40, 0x40, 0x40, 0x3F,
+    0x1F, 0x20, 0x40, 0x20, 0x1F,
+    0x3F, 0x40, 0x38, 0x40, 0x3F,
+    0x63, 0x14, 0x08, 0x14, 0x63,
+    0x03, 0x04, 0x78, 0x04, 0x03,
+    0x61, 0x59, 0x49, 0x4D, 0x43,
+    0x00, 0x7F, 0x41, 0x41, 0x41,
+    0x02, 0x04, 0x08, 0x10, 0x20,
+    0x00, 0x41, 0x41, 0x41, 0x7F,
+    0x04, 0x02, 0x01, 0x02, 0x04,
+    0x40, 0x40, 0x40, 0x40, 0x40,
+    0x00, 0x03, 0x07, 0x08, 0x00,
+    0x20, 0x54, 0x54, 0x78, 0x40,
+    0x7F, 0x28, 0x44, 0x44, 0x38,
+    0x38, 0x44, 0x44, 0x44, 0x28,
+    0x38, 0x44, 0x44, 0x28, 0x7F,
+    0x38, 0x54, 0x54, 0x54, 0x18,
+    0x00, 0x08, 0x7E, 0x09, 0x02,
+    0x18, 0xA4, 0xA4, 0x9C, 0x78,
+    0x7F, 0x08, 0x04, 0x04, 0x78,
+    0x00, 0x44, 0x7D, 0x40, 0x00,
+    0x20, 0x40, 0x40, 0x3D, 0x00,
+    0x7F, 0x10, 0x28, 0x44, 0x00,
+    0x00, 0x41, 0x7F, 0x40, 0x00,
+    0x7C, 0x04, 0x78, 0x04, 0x78,
+    0x7C, 0x08, 0x04, 0x04, 0x78,
+    0x38, 0x44, 0x44, 0x44, 0x38,
+    0xFC, 0x18, 0x24, 0x24, 0x18,
+    0x18, 0x24, 0x24, 0x18, 0xFC,
+    0x7C, 0x08, 0x04, 0x04, 0x08,
+    0x48, 0x54, 0x54, 0x54, 0x24,
+    0x04, 0x04, 0x3F, 0x44, 0x24,
+    0x3C, 0x40, 0x40, 0x20, 0x7C,
+    0x1C, 0x20, 0x40, 0x20, 0x1C,
+    0x3C, 0x40, 0x30, 0x40, 0x3C,
+    0x44, 0x28, 0x10, 0x28, 0x44,
+    0x4C, 0x90, 0x90, 0x90, 0x7C,
+    0x44, 0x64, 0x54, 0x4C, 0x44,
+    0x00, 0x08, 0x36, 0x41, 0x00,
+    0x00, 0x00, 0x77, 0x00, 0x00,
+    0x00, 0x41, 0x36, 0x08, 0x00,
+    0x02, 0x01, 0x02, 0x04, 0x02,
+    0x7F, 0x7F, 0x4D, 0x7F, 0x7F,
+    0x7F, 0x41, 0x51, 0x41, 0x7F,
+    0x7F, 0x43, 0x51, 0x43, 0x7F,
+    0x7F, 0x45, 0x51, 0x45, 0x7F,
+    0x7F, 0x47, 0x51, 0x47, 0x7F,
+    0x7F, 0x49, 0x51, 0x49, 0x7F,
+    0x7F, 0x4B, 0x51, 0x4B, 0x7F,
+    0x7F, 0x4D, 0x51, 0x4D, 0x7F,
+    0x7F, 0x4F, 0x51, 0x4F, 0x7F,
+    0x7F, 0x51, 0x51, 0x51, 0x7F,
+    0x7F, 0x53, 0x51, 0x53, 0x7F,
+    0x7F, 0x55, 0x51, 0x55, 0x7F,
+    0x7F, 0x57, 0x51, 0x57, 0x7F,
+    0x7F, 0x59, 0x51, 0x59, 0x7F,
+    0x7F, 0x5B, 0x51, 0x5B, 0x7F,
+    0x7F, 0x5D, 0x51, 0x5D, 0x7F,
+    0x7F, 0x5F, 0x51, 0x5F, 0x7F,
+    0x7F, 0x61, 0x51, 0x61, 0x7F,
+    0x7F, 0x63, 0x51, 0x63, 0x7F,
+    0x7F, 0x65, 0x51, 0x65, 0x7F,
+    0x7F, 0x67, 0x51, 0x67, 0x7F,
+    0x7F, 0x69, 0x51, 0x69, 0x7F,
+    0x7F, 0x6B, 0x51, 0x6B, 0x7F,
+    0x7F, 0x6D, 0x51, 0x6D, 0x7F,
+    0x7F, 0x6F, 0x51, 0x6F, 0x7F,
+    0x7F, 0x71, 0x51, 0x71, 0x7F,
+    0x7F, 0x73, 0x51, 0x73, 0x7F,
+    0x7F, 0x75, 0x51, 0x75, 0x7F,
+    0x7F, 0x77, 0x51, 0x77, 0x7F,
+    0x7F, 0x79, 0x51, 0x79, 0x7F,
+    0x7F, 0x7B, 0x51, 0x7B, 0x7F,
+    0x7F, 0x7D, 0x51, 0x7D, 0x7F,
+    0x7F, 0x7F, 0x51, 0x7F, 0x7F,
+    0x7F, 0x41, 0x55, 0x41, 0x7F,
+    0x7F, 0x43, 0x55, 0x43, 0x7F,
+    0x7F, 0x45, 0x55, 0x45, 0x7F,
+    0x7F, 0x47, 0x55, 0x47, 0x7F,
+    0x7F, 0x49, 0x55, 0x49, 0x7F,
+    0x7F, 0x4B, 0x55, 0x4B, 0x7F,
+    0x7F, 0x4D, 0x55, 0x4D, 0x7F,
+    0x7F, 0x4F, 0x55, 0x4F, 0x7F,
+    0x7F, 0x51, 0x55, 0x51, 0x7F,
+    0x7F, 0x53, 0x55, 0x53, 0x7F,
+    0x7F, 0x55, 0x55, 0x55, 0x7F,
+    0x7F, 0x57, 0x55, 0x57, 0x7F,
+    0x7F, 0x59, 0x55, 0x59, 0x7F,
+    0x7F, 0x5B, 0x55, 0x5B, 0x7F,
+    0x7F, 0x5D, 0x55, 0x5D, 0x7F,
+    0x7F, 0x5F, 0x55, 0x5F, 0x7F,
+    0x7F, 0x61, 0x55, 0x61, 0x7F,
+    0x7F, 0x63, 0x55, 0x63, 0x7F,
+    0x7F, 0x65, 0x55, 0x65, 0x7F,
+    0x7F, 0x67, 0x55, 0x67, 0x7F,
+    0x7F, 0x69, 0x55, 0x69, 0x7F,
+    0x7F, 0x6B, 0x55, 0x6B, 0x7F,
+    0x7F, 0x6D, 0x55, 0x6D, 0x7F,
+    0x7F, 0x6F, 0x55, 0x6F, 0x7F,
+    0x7F, 0x71, 0x55, 0x71, 0x7F,
+    0x7F, 0x73, 0x55, 0x73, 0x7F,
+    0x7F, 0x75, 0x55, 0x75, 0x7F,
+    0x7F, 0x77, 0x55, 0x77, 0x7F,
+    0x7F, 0x79, 0x55, 0x79, 0x7F,
+    0x7F, 0x7B, 0x55, 0x7B, 0x7F,
+    0x7F, 0x7D, 0x55, 0x7D, 0x7F,
+    0x7F, 0x7F, 0x55, 0x7F, 0x7F,
+    0x7F, 0x41, 0x59, 0x41, 0x7F,
+    0x7F, 0x43, 0x59, 0x43, 0x7F,
+    0x7F, 0x45, 0x59, 0x45, 0x7F,
+    0x7F, 0x47, 0x59, 0x47, 0x7F,
+    0x7F, 0x49, 0x59, 0x49, 0x7F,
+    0x7F, 0x4B, 0x59, 0x4B, 0x7F,
+    0x7F, 0x4D, 0x59, 0x4D, 0x7F,
+    0x7F, 0x4F, 0x59, 0x4F, 0x7F,
+    0x7F, 0x51, 0x59, 0x51, 0x7F,
+    0x7F, 0x53, 0x59, 0x53, 0x7F,
+    0x7F, 0x55, 0x59, 0x55, 0x7F,
+    0x7F, 0x57, 0x59, 0x57, 0x7F,
+    0x7F, 0x59, 0x59, 0x59, 0x7F,
+    0x7F, 0x5B, 0x59, 0x5B, 0x7F,
+    0x7F, 0x5D, 0x59, 0x5D, 0x7F,
+    0x7F, 0x5F, 0x59, 0x5F, 0x7F,
+    0x7F, 0x61, 0x59, 0x61, 0x7F,
+    0x7F, 0x63, 0x59, 0x63, 0x7F,
+    0x7F, 0x65, 0x59, 0x65, 0x7F,
+    0x7F, 0x67, 0x59, 0x67, 0x7F,
+    0x7F, 0x69, 0x59, 0x69, 0x7F,
+    0x7F, 0x6B, 0x59, 0x6B, 0x7F,
+    0x7F, 0x6D, 0x59, 0x6D, 0x7F,
+    0x7F, 0x6F, 0x59, 0x6F, 0x7F,
+    0x7F, 0x71, 0x59, 0x71, 0x7F,
+    0x7F, 0x73, 0x59, 0x73, 0x7F,
+    0x7F, 0x75, 0x59, 0x75, 0x7F,
+    0x7F, 0x77, 0x59, 0x77, 0x7F,
+    0x7F, 0x79, 0x59, 0x79, 0x7F,
+    0x7F, 0x7B, 0x59, 0x7B, 0x7F,
+    0x7F, 0x7D, 0x59, 0x7D, 0x7F,
+    0x7F, 0x7F, 0x59, 0x7F, 0x7F,
+    0x7F, 0x41, 0x5D, 0x41, 0x7F,
+    0x7F, 0x43, 0x5D, 0x43, 0x7F,
+    0x7F, 0x45, 0x5D, 0x45, 0x7F,
+    0x7F, 0x47, 0x5D, 0x47, 0x7F,
+    0x7F, 0x49, 0x5D, 0x49, 0x7F,
+    0x7F, 0x4B, 0x5D, 0x4B, 0x7F,
+    0x7F, 0x4D, 0x5D, 0x4D, 0x7F,
+    0x7F, 0x4F, 0x5D, 0x4F, 0x7F,
+    0x7F, 0x51, 0x5D, 0x51, 0x7F,
+    0x7F, 0x53, 0x5D, 0x53, 0x7F,
+    0x7F, 0x55, 0x5D, 0x55, 0x7F,
+    0x7F, 0x57, 0x5D, 0x57, 0x7F,
+    0x7F, 0x59, 0x5D, 0x59, 0x7F,
+    0x7F, 0x5B, 0x5D, 0x5B, 0x7F,
+    0x7F, 0x5D, 0x5D, 0x5D, 0x7F,
+    0x7F, 0x5F, 0x5D, 0x5F, 0x7F,
+    0x7F, 0x61, 0x5D, 0x61, 0x7F,
+    0x7F, 0x63, 0x5D, 0x63, 0x7F,
+    0x7F, 0x65, 0x5D, 0x65, 0x7F,
+    0x7F, 0x67, 0x5D, 0x67, 0x7F,
+    0x7F, 0x69, 0x5D, 0x69, 0x7F,
+    0x7F, 0x6B, 0x5D, 0x6B, 0x7F,
+    0x7F, 0x6D, 0x5D, 0x6D, 0x7F,
+    0x7F, 0x6F, 0x5D, 0x6F, 0x7F,
+    0x7F, 0x71, 0x5D, 0x71, 0x7F,
+    0x7F, 0x73, 0x5D, 0x73, 0x7F,
+    0x7F, 0x75, 0x5D, 0x75, 0x7F,
+    0x7F, 0x77, 0x5D, 0x77, 0x7F,
+    0x7F, 0x79, 0x5D, 0x79, 0x7F,
+    0x7F, 0x7B, 0x5D, 0x7B, 0x7F,
+    0x7F, 0x7D, 0x5D, 0x7D, 0x7F,
+    0x7F, 0x7F, 0x5D, 0x7F, 0x7F
+};
+
+#endif // FONT5X7_H
@@ -0,0 +1,152 @@
+#include "host.h"
+
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/display.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/kernel.h>
+
+#include <deque>
+#include <stdarg.h>
+#include <stdio.h>
+
+const struct device host_console = { "host" };
+
+static uint64_t now_us = 0;
+static std::deque<uint8_t> serial_in;
+static std::string console_out;
+static uint8_t panel[HOST_PANEL_WIDTH * HOST_PANEL_HEIGHT];
+static uint32_t glyphs = 0;
+
+void host_advance_us(uint32_t us)
+{
+    now_us += us;
+}
+
+uint32_t host_now_us()
+{
+    return (uint32_t)now_us;
+}
+
+void host_serial_input(const void* data, size_t length)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    serial_in.insert(serial_in.end(), bytes, bytes + length);
+}
+
+size_t host_serial_pending()
+{
+    return serial_in.size();
+}
+
+std::string host_take_output()
+{
+    std::string output;
+    output.swap(console_out);
+    return output;
+}
+
+const uint8_t* host_panel()
+{
+    return panel;
+}
+
+void host_count_glyph()
+{
+    ++glyphs;
+}
+
+uint32_t host_glyphs()
+{
+    return glyphs;
+}
+
+uint32_t k_uptime_get_32()
+{
+    return (uint32_t)(now_us / 1000);
+}
+
+uint32_t k_cycle_get_32()
+{
+    return (uint32_t)now_us;
+}
+
+uint32_t k_cyc_to_us_floor32(uint32_t cycles)
+{
+    return cycles;
+}
+
+void k_busy_wait(uint32_t usec)
+{
+    now_us += usec;
+}
+
+void k_msleep(int32_t ms)
+{
+    now_us += (uint64_t)ms * 1000;
+}
+
+void k_yield()
+{
+}
+
+void printk(const char* format, ...)
+{
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length <= 0)
+    {
+        return;
+    }
+    // ConsoleSerial prints raw bytes with %.*s and %c, a zero byte is kept
+    if ((format[0] == '%') && (format[1] == 'c') && (format[2] == '\0'))
+    {
+        console_out.push_back(text[0]);
+        return;
+    }
+    console_out.append(text, (length < (int)sizeof(text)) ? length : sizeof(text) - 1);
+}
+
+bool device_is_ready(const struct device* dev)
+{
+    return dev != NULL;
+}
+
+int uart_poll_in(const struct device* dev, unsigned char* c)
+{
+    (void)dev;
+    if (serial_in.empty())
+    {
+        return -1;
+    }
+    *c = serial_in.front();
+    serial_in.pop_front();
+    return 0;
+}
+
+int display_write(const struct device* dev,
+                  uint16_t x,
+                  uint16_t y,
+                  const struct display_buffer_descriptor* desc,
+                  const void* buf)
+{
+    (void)dev;
+    const uint32_t* pixels = (const uint32_t*)buf;
+    for (uint16_t row = 0; row < desc->height; ++row)
+    {
+        for (uint16_t column = 0; column < desc->width; ++column)
+        {
+            uint16_t px = x + column;
+            uint16_t py = y + row;
+            if ((px < HOST_PANEL_WIDTH) && (py < HOST_PANEL_HEIGHT))
+            {
+                // Unlit pixels are opaque black
+                panel[(py * HOST_PANEL_WIDTH) + px] = (pixels[(row * desc->pitch) + column] & 0x00FFFFFF) != 0;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef HOST_H_
+#define HOST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Host side of the tests: the kernel calls behind the Zephyr compat shims
+// on a virtual clock, the console, and the panel the SH1107 emulator
+// draws to. Time only moves when the tests advance it or when the
+// emulated bus holds the caller for a transfer, so every run is the same.
+
+#define HOST_PANEL_WIDTH 128
+#define HOST_PANEL_HEIGHT 64
+
+void host_advance_us(uint32_t us);
+uint32_t host_now_us();
+
+// Bytes for Serial to read, in order
+void host_serial_input(const void* data, size_t length);
+size_t host_serial_pending();
+
+// Everything printed to the console since the last take
+std::string host_take_output();
+
+// Panel pixels as last presented, one byte per pixel, non-zero when lit
+const uint8_t* host_panel();
+
+// Glyphs drawn through Adafruit_GFX::drawChar() so far
+void host_count_glyph();
+uint32_t host_glyphs();
+
+#endif // HOST_H_
@@ -0,0 +1,11 @@
+#ifndef HOST_ZEPHYR_DEVICE_H_
+#define HOST_ZEPHYR_DEVICE_H_
+
+struct device
+{
+    const char* name;
+};
+
+bool device_is_ready(const struct device* dev);
+
+#endif // HOST_ZEPHYR_DEVICE_H_
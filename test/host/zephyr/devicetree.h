@@ -0,0 +1,12 @@
+#ifndef HOST_ZEPHYR_DEVICETREE_H_
+#define HOST_ZEPHYR_DEVICETREE_H_
+
+#include <zephyr/device.h>
+
+// Every chosen node is the host console
+#define DT_CHOSEN(node) host_console
+#define DEVICE_DT_GET(node) (&node)
+
+extern const struct device host_console;
+
+#endif // HOST_ZEPHYR_DEVICETREE_H_
@@ -0,0 +1,24 @@
+#ifndef HOST_ZEPHYR_DISPLAY_H_
+#define HOST_ZEPHYR_DISPLAY_H_
+
+#include <zephyr/device.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct display_buffer_descriptor
+{
+    uint32_t buf_size;
+    uint16_t width;
+    uint16_t height;
+    uint16_t pitch;
+};
+
+// The panel image is kept by host.cpp, see host_panel()
+int display_write(const struct device* dev,
+                  uint16_t x,
+                  uint16_t y,
+                  const struct display_buffer_descriptor* desc,
+                  const void* buf);
+
+#endif // HOST_ZEPHYR_DISPLAY_H_
@@ -0,0 +1,9 @@
+#ifndef HOST_ZEPHYR_UART_H_
+#define HOST_ZEPHYR_UART_H_
+
+#include <zephyr/device.h>
+
+// Bytes queued with host_serial_input(), -1 when there are none
+int uart_poll_in(const struct device* dev, unsigned char* c);
+
+#endif // HOST_ZEPHYR_UART_H_
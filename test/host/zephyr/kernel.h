@@ -0,0 +1,18 @@
+#ifndef HOST_ZEPHYR_KERNEL_H_
+#define HOST_ZEPHYR_KERNEL_H_
+
+// The kernel calls the compat shims use, on the virtual clock in host.cpp.
+// A cycle is a microsecond.
+
+#include <zephyr/sys/printk.h>
+
+#include <stdint.h>
+
+uint32_t k_uptime_get_32();
+uint32_t k_cycle_get_32();
+uint32_t k_cyc_to_us_floor32(uint32_t cycles);
+void k_busy_wait(uint32_t usec);
+void k_msleep(int32_t ms);
+void k_yield();
+
+#endif // HOST_ZEPHYR_KERNEL_H_
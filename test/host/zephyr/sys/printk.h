@@ -0,0 +1,7 @@
+#ifndef HOST_ZEPHYR_PRINTK_H_
+#define HOST_ZEPHYR_PRINTK_H_
+
+// Console output, collected by host.cpp
+void printk(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+#endif // HOST_ZEPHYR_PRINTK_H_
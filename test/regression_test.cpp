@@ -0,0 +1,288 @@
+// Host regression test: every render state run by regression_run() (see
+// regression.h) on the virtual clock, and compared with test/golden/.
+// Each golden state's last frame is a PBM there, and thresholds.txt has
+// a line per state with the CRC over all of its frames and the work
+// counters. A counter may grow by THRESHOLD_PERCENT before the state
+// fails, the slowest frame is the emulated bus time of its flushes. The
+// CIPHER STREAM case is given a job on Serial and has to send back what
+// cipher.cpp makes of it, with nothing else in between.
+//
+//   regression_test <golden dir>            check
+//   regression_test <golden dir> --record   write the goldens again
+
+#include "host.h"
+
+#include "cipher.h"
+#include "regression.h"
+#include "renderer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+#define THRESHOLD_PERCENT 10
+#define STREAM_BYTES 600
+#define STREAM_KEY "CIPHERPAL"
+
+typedef struct
+{
+    uint32_t crc;
+    uint32_t pixel_ops;
+    uint32_t rect_pixels;
+    uint32_t flushes;
+    uint32_t flushed_bytes;
+    uint32_t worst_us;
+} threshold_t;
+
+static std::string golden_dir;
+static bool recording = false;
+static std::map<std::string, threshold_t> thresholds;
+static std::map<std::string, threshold_t> recorded;
+
+static std::string file_name(const char* name)
+{
+    std::string file(name);
+    for (size_t i = 0; i < file.size(); ++i)
+    {
+        file[i] = (file[i] == ' ') ? '_' : (char)tolower(file[i]);
+    }
+    return file;
+}
+
+static bool load_thresholds()
+{
+    FILE* f = fopen((golden_dir + "/thresholds.txt").c_str(), "r");
+    if (f == NULL)
+    {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        char name[64];
+        threshold_t t;
+        if ((line[0] != '#')
+            && (sscanf(line, "%63s %x %u %u %u %u %u", name, &t.crc, &t.pixel_ops, &t.rect_pixels,
+                       &t.flushes, &t.flushed_bytes, &t.worst_us) == 7))
+        {
+            thresholds[name] = t;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static bool save_thresholds()
+{
+    FILE* f = fopen((golden_dir + "/thresholds.txt").c_str(), "w");
+    if (f == NULL)
+    {
+        return false;
+    }
+    fprintf(f, "# state crc pixel_ops rect_pixels flushes flushed_bytes worst_us\n");
+    for (std::map<std::string, threshold_t>::const_iterator i = recorded.begin(); i != recorded.end(); ++i)
+    {
+        const threshold_t& t = i->second;
+        fprintf(f, "%s %08x %u %u %u %u %u\n", i->first.c_str(), t.crc, t.pixel_ops, t.rect_pixels,
+                t.flushes, t.flushed_bytes, t.worst_us);
+    }
+    fclose(f);
+    return true;
+}
+
+static uint8_t reversed(uint8_t value)
+{
+    uint8_t out = 0;
+    for (uint8_t bit = 0; bit < 8; ++bit)
+    {
+        out |= ((value >> bit) & 1) << (7 - bit);
+    }
+    return out;
+}
+
+// PBM rows are most significant bit leftmost, the frame is the reverse
+static bool write_pbm(const std::string& path, const uint8_t* frame)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f == NULL)
+    {
+        return false;
+    }
+    fprintf(f, "P4\n%d %d\n", LCD_WIDTH, LCD_HEIGHT);
+    for (uint16_t i = 0; i < FRAME_BYTES; ++i)
+    {
+        fputc(reversed(frame[i]), f);
+    }
+    fclose(f);
+    return true;
+}
+
+// Returns the pixels that differ, -1 when there is no golden frame
+static int32_t compare_pbm(const std::string& path, const uint8_t* frame)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+    {
+        return -1;
+    }
+    int width = 0;
+    int height = 0;
+    uint8_t data[FRAME_BYTES];
+    bool valid = (fscanf(f, "P4 %d %d", &width, &height) == 2)
+        && (fgetc(f) == '\n')
+        && (width == LCD_WIDTH)
+        && (height == LCD_HEIGHT)
+        && (fread(data, 1, FRAME_BYTES, f) == FRAME_BYTES);
+    fclose(f);
+    if (!valid)
+    {
+        return -1;
+    }
+    int32_t differing = 0;
+    for (uint16_t i = 0; i < FRAME_BYTES; ++i)
+    {
+        differing += __builtin_popcount(reversed(data[i]) ^ frame[i]);
+    }
+    return differing;
+}
+
+static bool within(const char* what, uint32_t value, uint32_t threshold)
+{
+    if (value <= (threshold + ((threshold * THRESHOLD_PERCENT) / 100)))
+    {
+        return true;
+    }
+    printf("    %s %u over the threshold of %u\n", what, value, threshold);
+    return false;
+}
+
+static bool check_state(const regression_result_t* result)
+{
+    std::string name = file_name(result->name);
+    threshold_t measured = {
+        result->crc,
+        result->pixel_ops,
+        result->rect_pixels,
+        result->flushes,
+        result->flushed_bytes,
+        result->worst_us,
+    };
+    printf("%-14s crc %08x, %u frames, %u pixels, %u rect pixels, %u flushes, %u bytes, %u us worst\n",
+           result->name, result->crc, result->frames, result->pixel_ops, result->rect_pixels,
+           result->flushes, result->flushed_bytes, result->worst_us);
+
+    std::string pbm = golden_dir + "/" + name + ".pbm";
+    if (recording)
+    {
+        recorded[name] = measured;
+        return !result->golden || write_pbm(pbm, result->frame);
+    }
+
+    std::map<std::string, threshold_t>::const_iterator found = thresholds.find(name);
+    if (found == thresholds.end())
+    {
+        printf("    no thresholds\n");
+        return false;
+    }
+    const threshold_t& t = found->second;
+    bool pass = within("pixel ops", measured.pixel_ops, t.pixel_ops)
+        & within("rect pixels", measured.rect_pixels, t.rect_pixels)
+        & within("flushes", measured.flushes, t.flushes)
+        & within("flushed bytes", measured.flushed_bytes, t.flushed_bytes)
+        & within("worst frame us", measured.worst_us, t.worst_us);
+    if (result->golden)
+    {
+        if (measured.crc != t.crc)
+        {
+            printf("    frames differ, crc %08x was %08x\n", measured.crc, t.crc);
+            pass = false;
+        }
+        int32_t differing = compare_pbm(pbm, result->frame);
+        if (differing != 0)
+        {
+            if (differing < 0)
+            {
+                printf("    no golden frame %s\n", pbm.c_str());
+            }
+            else
+            {
+                printf("    %d pixels of the last frame differ, it is in %s.actual.pbm\n", differing, name.c_str());
+                write_pbm(name + ".actual.pbm", result->frame);
+            }
+            pass = false;
+        }
+    }
+    if (result->budget_us != 0)
+    {
+        printf("    %u of %u us budget\n", result->worst_us, result->budget_us);
+    }
+    return pass;
+}
+
+static void queue_stream_job(uint8_t* expected)
+{
+    char header[64];
+    snprintf(header, sizeof(header), "XOR e %u %s\n", (unsigned)STREAM_BYTES, STREAM_KEY);
+    host_serial_input(header, strlen(header));
+
+    static const char text[] = "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG. ";
+    for (uint16_t i = 0; i < STREAM_BYTES; ++i)
+    {
+        expected[i] = text[i % (sizeof(text) - 1)];
+    }
+    host_serial_input(expected, STREAM_BYTES);
+
+    cipher_t cipher;
+    cipher_init(&cipher, CIPHER_XOR, false, (const uint8_t*)STREAM_KEY, strlen(STREAM_KEY));
+    cipher_apply(&cipher, expected, STREAM_BYTES);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <golden dir> [--record]\n", argv[0]);
+        return 2;
+    }
+    golden_dir = argv[1];
+    recording = (argc > 2) && (strcmp(argv[2], "--record") == 0);
+    if (!recording && !load_thresholds())
+    {
+        printf("no %s/thresholds.txt, record it with --record\n", golden_dir.c_str());
+        return 1;
+    }
+
+    render_init();
+    uint8_t expected[STREAM_BYTES];
+    queue_stream_job(expected);
+    host_take_output();
+
+    bool pass = regression_run(check_state);
+
+    std::string output = host_take_output();
+    std::string streamed((const char*)expected, STREAM_BYTES);
+    if (host_serial_pending() != 0)
+    {
+        printf("CIPHER STREAM left %u bytes unread\n", (unsigned)host_serial_pending());
+        pass = false;
+    }
+    if (output.find(streamed) == std::string::npos)
+    {
+        printf("CIPHER STREAM output is not the ciphertext, or something was sent inside it\n");
+        pass = false;
+    }
+
+    if (recording)
+    {
+        if (!save_thresholds())
+        {
+            printf("could not write %s/thresholds.txt\n", golden_dir.c_str());
+            return 1;
+        }
+        printf("goldens written to %s\n", golden_dir.c_str());
+    }
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+// Host throughput benchmark for src/cipher.cpp, and a check that chunked
+// streaming matches one-shot output and decrypts back.
+//
+//   g++ -O2 -std=gnu++11 -Isrc tools/cipher_bench.cpp src/cipher.cpp -o cipher_bench
+//   ./cipher_bench
+//
+// The target numbers come from the bench environment
+// (pio run -e adafruit_feather_m0_bench).
+
+#include "cipher.h"
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_BYTES 4096
+#define BENCH_SECONDS 0.5
+
+static const uint8_t bench_key[] = "CIPHERPAL";
+
+// RFC 8439 section 2.4.2
+static bool check_chacha_vector()
+{
+    static const char plaintext[] =
+        "Ladies and Gentlemen of the class of '99: If I could offer you only "
+        "one tip for the future, sunscreen would be it.";
+    static const uint8_t expected[16] = {
+        0x6e, 0x2e, 0x35, 0x9a, 0x25, 0x68, 0xf9, 0x80,
+        0x41, 0xba, 0x07, 0x28, 0xdd, 0x0d, 0x69, 0x81,
+    };
+    static const uint8_t expected_tail[2] = { 0x87, 0x4d };
+    uint8_t key[32];
+    for (uint8_t i = 0; i < sizeof(key); ++i)
+    {
+        key[i] = i;
+    }
+    static const uint8_t nonce[CIPHER_NONCE_BYTES] = { 0, 0, 0, 0, 0, 0, 0, 0x4a, 0, 0, 0, 0 };
+
+    cipher_t cipher;
+    cipher_init(&cipher, CIPHER_CHACHA20, false, key, sizeof(key));
+    cipher_set_nonce(&cipher, nonce, 1);
+    uint8_t data[sizeof(plaintext)];
+    uint16_t length = sizeof(plaintext) - 1;
+    memcpy(data, plaintext, length);
+    cipher_apply(&cipher, data, length);
+    return (memcmp(data, expected, sizeof(expected)) == 0)
+        && (memcmp(&data[length - 2], expected_tail, 2) == 0);
+}
+
+// Odd chunk sizes and offsets against one call over the whole buffer
+static bool check_streaming(uint8_t mode)
+{
+    static uint8_t plain[BENCH_BYTES + 4];
+    static uint8_t whole[BENCH_BYTES + 4];
+    static uint8_t chunked[BENCH_BYTES + 4];
+    for (uint16_t i = 0; i < BENCH_BYTES; ++i)
+    {
+        plain[i] = (uint8_t)rand();
+    }
+
+    cipher_t cipher;
+    cipher_init(&cipher, mode, false, bench_key, sizeof(bench_key) - 1);
+    memcpy(whole, plain, BENCH_BYTES);
+    cipher_apply(&cipher, whole, BENCH_BYTES);
+
+    cipher_init(&cipher, mode, false, bench_key, sizeof(bench_key) - 1);
+    uint8_t* unaligned = chunked + 1;
+    memcpy(unaligned, plain, BENCH_BYTES);
+    for (uint16_t done = 0; done < BENCH_BYTES;)
+    {
+        uint16_t chunk = 1 + (rand() % 97);
+        if (chunk > (BENCH_BYTES - done))
+        {
+            chunk = BENCH_BYTES - done;
+        }
+        cipher_apply(&cipher, unaligned + done, chunk);
+        done += chunk;
+    }
+    if (memcmp(whole, unaligned, BENCH_BYTES) != 0)
+    {
+        return false;
+    }
+
+    cipher_init(&cipher, mode, true, bench_key, sizeof(bench_key) - 1);
+    cipher_apply(&cipher, whole, BENCH_BYTES);
+    return memcmp(whole, plain, BENCH_BYTES) == 0;
+}
+
+int main()
+{
+    printf("chacha20 rfc8439 vector: %s\n", check_chacha_vector() ? "ok" : "FAIL");
+
+    static uint8_t buffer[BENCH_BYTES] __attribute__((aligned(4)));
+    for (uint8_t mode = 0; mode < CIPHER_MODES; ++mode)
+    {
+        bool streaming = check_streaming(mode);
+
+        cipher_t cipher;
+        cipher_init(&cipher, mode, false, bench_key, sizeof(bench_key) - 1);
+        for (uint16_t i = 0; i < BENCH_BYTES; ++i)
+        {
+            buffer[i] = 'A' + (i % 26);
+        }
+
+        uint64_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        while (elapsed < BENCH_SECONDS)
+        {
+            cipher_apply(&cipher, buffer, BENCH_BYTES);
+            bytes += BENCH_BYTES;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        printf("%-9s %10.1f MB/s  streaming %s\n",
+               cipher_name(mode),
+               (bytes / elapsed) / 1e6,
+               streaming ? "ok" : "FAIL");
+    }
+    return 0;
+}
@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+"""Host side of the CipherPal command protocol (see src/protocol.h).
+
+Usable as a library:
+
+    from cipherpal_client import CipherPal
+    with CipherPal("/dev/ttyACM0") as pal:
+        print(pal.counters())
+        pal.set_param("target_fps", 60)
+
+or from the command line:
+
+    cipherpal_client.py --port /dev/ttyACM0 counters
+    cipherpal_client.py --port /dev/ttyACM0 set target_fps 60
+    cipherpal_client.py --port /dev/ttyACM0 push self_test
+    cipherpal_client.py --port /dev/ttyACM0 watch --interval 1
+
+Needs pyserial. Log() text and mirror packets arriving between replies
+are skipped, text lines are handed to an optional callback.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+SYNC = b"\x00P"
+HEADER_BYTES = 5
+CRC_BYTES = 2
+PAYLOAD_MAX = 64
+REPLY = 0x80
+
+PING = 0x01
+GET_COUNTERS = 0x02
+SET_PARAM = 0x03
+GET_PARAM = 0x04
+PUSH_STATE = 0x05
+POP_STATE = 0x06
+RESET_COUNTERS = 0x07
+
+STATUS = ["ok", "bad command", "bad argument", "bad length"]
+
+PARAMS = ["target_fps", "log_mask", "brightness", "bus_hz", "stall_ms", "crypto_level"]
+
+STATES = [
+    "main_menu",
+    "self_test",
+    "register_read",
+    "buffer_deconstruct",
+    "grayscale_demo",
+    "crypto_unlock",
+    "cipher_stream",
+    "splash",
+    "clip_player",
+    "log_ticker",
+]
+
+COUNTERS = [
+    "frames",
+    "frame_us",
+    "frame_us_max",
+    "frame_us_avg",
+    "flushes",
+    "flushed_bytes",
+    "flush_us",
+    "input_events",
+    "rx_frames",
+    "crc_errors",
+    "slice_us_max",
+    "slice_us_avg",
+    "uptime_ms",
+    "stalls",
+    "loop_us_max",
+]
+
+LOG_GENERAL = 0x01
+LOG_PROTOCOL = 0x02
+LOG_ALL = 0xFF
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as protocol_crc()."""
+    for value in data:
+        crc ^= value << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def encode(kind, sequence, payload=b""):
+    if len(payload) > PAYLOAD_MAX:
+        raise ValueError("payload longer than %d bytes" % PAYLOAD_MAX)
+    body = bytes([kind, sequence & 0xFF, len(payload)]) + bytes(payload)
+    return SYNC + body + struct.pack("<H", crc16(body))
+
+
+class ProtocolError(Exception):
+    pass
+
+
+class FrameDecoder:
+    """Incremental decoder, feed() returns ('text', line) and
+    ('frame', type, sequence, payload) events. Frames with a bad CRC are
+    counted and dropped."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.crc_errors = 0
+
+    def feed(self, data):
+        self.buffer += data
+        events = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                end = self.buffer.rfind(b"\n") + 1
+                self.text(self.buffer[:end], events)
+                del self.buffer[:end]
+                return events
+            if start > 0:
+                self.text(self.buffer[:start], events)
+                del self.buffer[:start]
+            if len(self.buffer) < HEADER_BYTES:
+                return events
+
+            length = self.buffer[4]
+            if length > PAYLOAD_MAX:
+                del self.buffer[:len(SYNC)]
+                continue
+            total = HEADER_BYTES + length + CRC_BYTES
+            if len(self.buffer) < total:
+                return events
+            body = bytes(self.buffer[2:HEADER_BYTES + length])
+            (crc,) = struct.unpack_from("<H", self.buffer, HEADER_BYTES + length)
+            if crc != crc16(body):
+                # Corrupt, or text that happened to contain the sync
+                self.crc_errors += 1
+                del self.buffer[:len(SYNC)]
+                continue
+            del self.buffer[:total]
+            events.append(("frame", body[0], body[1], body[3:]))
+
+    @staticmethod
+    def text(data, events):
+        for line in bytes(data).splitlines():
+            line = line.strip(b"\x00\r")
+            if line:
+                events.append(("text", line.decode("ascii", "replace")))
+
+
+class CipherPal:
+    def __init__(self, port, baud=115200, timeout=1.0, on_text=None, retries=2):
+        import serial
+
+        self.serial = serial.Serial(port, baud, timeout=0.05)
+        self.timeout = timeout
+        self.retries = retries
+        self.on_text = on_text
+        self.decoder = FrameDecoder()
+        self.sequence = 0
+
+    def close(self):
+        self.serial.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def request(self, kind, payload=b"", retry=True):
+        """Send a request and return the reply payload after the status.
+        Raises ProtocolError on a non-OK status or no reply. Requests that
+        change the render stack are not resent, a lost reply would
+        otherwise push twice."""
+        for _ in range((self.retries if retry else 0) + 1):
+            self.sequence = (self.sequence + 1) & 0xFF
+            self.serial.write(encode(kind, self.sequence, payload))
+            reply = self.wait_reply(kind | REPLY, self.sequence)
+            if reply is None:
+                continue
+            if not reply:
+                raise ProtocolError("empty reply")
+            if reply[0] != 0:
+                status = STATUS[reply[0]] if reply[0] < len(STATUS) else reply[0]
+                raise ProtocolError("request 0x%02x: %s" % (kind, status))
+            return reply[1:]
+        raise ProtocolError("no reply to request 0x%02x" % kind)
+
+    def wait_reply(self, kind, sequence):
+        deadline = time.monotonic() + self.timeout
+        while time.monotonic() < deadline:
+            for event in self.decoder.feed(self.serial.read(256)):
+                if event[0] == "text":
+                    if self.on_text:
+                        self.on_text(event[1])
+                elif event[1] == kind and event[2] == sequence:
+                    return event[3]
+        return None
+
+    def ping(self, data=b"cipherpal"):
+        start = time.monotonic()
+        echo = self.request(PING, data)
+        if echo != data:
+            raise ProtocolError("ping echo mismatch")
+        return time.monotonic() - start
+
+    def counters(self):
+        values = self.request(GET_COUNTERS)
+        count = len(values) // 4
+        numbers = struct.unpack("<%dI" % count, values[:count * 4])
+        return dict(zip(COUNTERS, numbers))
+
+    def reset_counters(self):
+        self.request(RESET_COUNTERS)
+
+    @staticmethod
+    def param_id(name):
+        return name if isinstance(name, int) else PARAMS.index(name)
+
+    def set_param(self, name, value):
+        reply = self.request(SET_PARAM, struct.pack("<BI", self.param_id(name), value))
+        return struct.unpack("<I", reply)[0]
+
+    def get_param(self, name):
+        reply = self.request(GET_PARAM, bytes([self.param_id(name)]))
+        return struct.unpack("<I", reply)[0]
+
+    def push_state(self, name):
+        state = name if isinstance(name, int) else STATES.index(name)
+        return self.request(PUSH_STATE, bytes([state]), retry=False)[0]
+
+    def pop_state(self):
+        return self.request(POP_STATE, retry=False)[0]
+
+
+def print_counters(counters):
+    for name in COUNTERS:
+        if name in counters:
+            print("%-14s %10d" % (name, counters[name]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--port", required=True)
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--quiet", action="store_true", help="clear LOG_GENERAL first")
+    commands = parser.add_subparsers(dest="command", required=True)
+    commands.add_parser("ping")
+    commands.add_parser("counters")
+    commands.add_parser("reset")
+    watch = commands.add_parser("watch")
+    watch.add_argument("--interval", type=float, default=1.0)
+    get = commands.add_parser("get")
+    get.add_argument("param", choices=PARAMS)
+    set_ = commands.add_parser("set")
+    set_.add_argument("param", choices=PARAMS)
+    set_.add_argument("value", type=lambda v: int(v, 0))
+    push = commands.add_parser("push")
+    push.add_argument("state", choices=STATES)
+    commands.add_parser("pop")
+    args = parser.parse_args()
+
+    def show_text(line):
+        print("log: " + line, file=sys.stderr)
+
+    with CipherPal(args.port, args.baud, on_text=show_text) as pal:
+        if args.quiet:
+            pal.set_param("log_mask", LOG_ALL & ~LOG_GENERAL)
+        if args.command == "ping":
+            print("%.1f ms" % (pal.ping() * 1000))
+        elif args.command == "counters":
+            print_counters(pal.counters())
+        elif args.command == "reset":
+            pal.reset_counters()
+        elif args.command == "watch":
+            while True:
+                print_counters(pal.counters())
+                print()
+                time.sleep(args.interval)
+        elif args.command == "get":
+            print(pal.get_param(args.param))
+        elif args.command == "set":
+            print(pal.set_param(args.param, args.value))
+        elif args.command == "push":
+            print("depth %d" % pal.push_state(args.state))
+        elif args.command == "pop":
+            print("depth %d" % pal.pop_state())
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+"""Encode a frame sequence into a CipherPal animation clip (see src/clip.h).
+
+Frames are 128x64 PBM files (as written by mirror_view.py) or any image
+Pillow can open, thresholded at half intensity. A frame's duration can
+follow its name after a colon, otherwise --frame-ms applies:
+
+    clip_encode.py --name CLIP_INTRO --out src/clip_intro.h intro/*.pbm
+    clip_encode.py --name CLIP_INTRO --frame-ms 40 a.png b.png:500 c.png
+    clip_encode.py --name CLIP_DEMO --test-pattern 64 --out src/clip_demo.h
+
+--test-pattern generates a sweep across every page instead of reading
+files. --bin writes the raw clip instead of a C header. Every clip is
+decoded again and compared with its input before it is written.
+"""
+
+import argparse
+import sys
+
+WIDTH = 128
+HEIGHT = 64
+BYTES_PER_LINE = WIDTH // 8
+FRAME_BYTES = BYTES_PER_LINE * HEIGHT
+PAGES = BYTES_PER_LINE
+PAGE_BYTES = HEIGHT
+TOKEN_MAX = 128
+
+MAGIC = b"CLP"
+VERSION = 1
+KEYFRAME = 0x01
+
+
+def reverse_bits(v):
+    v = ((v & 0xF0) >> 4) | ((v & 0x0F) << 4)
+    v = ((v & 0xCC) >> 2) | ((v & 0x33) << 2)
+    v = ((v & 0xAA) >> 1) | ((v & 0x55) << 1)
+    return v
+
+
+REVERSED = bytes(reverse_bits(i) for i in range(256))
+
+
+def read_pbm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    fields = []
+    pos = 0
+    # Magic, width and height, skipping comments
+    while len(fields) < 3:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b"#":
+            pos = data.index(b"\n", pos)
+            continue
+        end = pos
+        while not data[end:end + 1].isspace():
+            end += 1
+        fields.append(data[pos:end])
+        pos = end
+    if fields[0] != b"P4":
+        return None
+    if (int(fields[1]), int(fields[2])) != (WIDTH, HEIGHT):
+        raise ValueError("%s is not %dx%d" % (path, WIDTH, HEIGHT))
+    pixels = data[pos + 1:pos + 1 + FRAME_BYTES]
+    # PBM is most significant bit leftmost, the frame least
+    return bytes(pixels).translate(REVERSED)
+
+
+def read_image(path):
+    from PIL import Image
+
+    image = Image.open(path).convert("L")
+    if image.size != (WIDTH, HEIGHT):
+        raise ValueError("%s is not %dx%d" % (path, WIDTH, HEIGHT))
+    frame = bytearray(FRAME_BYTES)
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            if image.getpixel((x, y)) >= 128:
+                frame[y * BYTES_PER_LINE + x // 8] |= 1 << (x % 8)
+    return bytes(frame)
+
+
+def read_frame(path):
+    frame = read_pbm(path) if path.lower().endswith(".pbm") else None
+    return frame if frame is not None else read_image(path)
+
+
+def test_pattern(count):
+    """A bar sweeping across all pages with a block bouncing against it,
+    so every page changes at some point and most frames are sparse."""
+    frames = []
+    for i in range(count):
+        frame = bytearray(FRAME_BYTES)
+        bar = (i * WIDTH // count) % WIDTH
+        for y in range(HEIGHT):
+            frame[y * BYTES_PER_LINE + bar // 8] |= 1 << (bar % 8)
+        phase = i % 32
+        top = phase * 2 if phase < 16 else (31 - phase) * 2
+        left = (WIDTH - 1 - bar) & ~7
+        for y in range(top, min(top + 8, HEIGHT)):
+            frame[y * BYTES_PER_LINE + left // 8] = 0xFF
+        frames.append(bytes(frame))
+    return frames
+
+
+def page_bytes(frame, page):
+    return bytes(frame[y * BYTES_PER_LINE + page] for y in range(PAGE_BYTES))
+
+
+def encode_page(delta):
+    """Mirror style tokens covering all 64 bytes: 0x80 | (n - 1) skips n
+    bytes, n - 1 < 0x80 is followed by n bytes to XOR in."""
+    out = bytearray()
+    i = 0
+    while i < PAGE_BYTES:
+        start = i
+        if delta[i] == 0:
+            while i < PAGE_BYTES and delta[i] == 0 and i - start < TOKEN_MAX:
+                i += 1
+            out.append(0x80 | (i - start - 1))
+            continue
+        # Literals run through single unchanged bytes
+        while i < PAGE_BYTES and i - start < TOKEN_MAX:
+            if delta[i] == 0 and (i + 1 >= PAGE_BYTES or delta[i + 1] == 0):
+                break
+            i += 1
+        out.append(i - start - 1)
+        out += bytes(delta[start:i])
+    return out
+
+
+def encode(frames, durations, keyframe_interval):
+    clip = bytearray(MAGIC + bytes([VERSION]))
+    clip += len(frames).to_bytes(2, "little") + bytes(2)
+    previous = bytes(FRAME_BYTES)
+    for index, (frame, duration) in enumerate(zip(frames, durations)):
+        keyframe = index == 0 or (keyframe_interval and index % keyframe_interval == 0)
+        base = bytes(FRAME_BYTES) if keyframe else previous
+        mask = 0
+        pages = bytearray()
+        for page in range(PAGES):
+            delta = bytes(a ^ b for a, b in zip(page_bytes(frame, page), page_bytes(base, page)))
+            if any(delta):
+                mask |= 1 << page
+                pages += encode_page(delta)
+        clip += duration.to_bytes(2, "little") + mask.to_bytes(2, "little")
+        clip.append(KEYFRAME if keyframe else 0)
+        clip += pages
+        previous = frame
+    return bytes(clip)
+
+
+def decode(clip):
+    """Reference decoder, mirrors clip_next()."""
+    if clip[:3] != MAGIC or clip[3] != VERSION:
+        raise ValueError("not a clip")
+    count = int.from_bytes(clip[4:6], "little")
+    pos = 8
+    frame = bytearray(FRAME_BYTES)
+    for _ in range(count):
+        mask = int.from_bytes(clip[pos + 2:pos + 4], "little")
+        flags = clip[pos + 4]
+        pos += 5
+        if flags & KEYFRAME:
+            frame = bytearray(FRAME_BYTES)
+        for page in range(PAGES):
+            if not mask & (1 << page):
+                continue
+            y = 0
+            while y < PAGE_BYTES:
+                token = clip[pos]
+                pos += 1
+                n = (token & 0x7F) + 1
+                if token & 0x80:
+                    y += n
+                    continue
+                for value in clip[pos:pos + n]:
+                    frame[y * BYTES_PER_LINE + page] ^= value
+                    y += 1
+                pos += n
+        yield bytes(frame)
+
+
+def write_header(path, name, clip, frames, total_ms, source):
+    guard = "%s_H_" % name.upper()
+    lines = [
+        "#ifndef %s" % guard,
+        "#define %s" % guard,
+        "",
+        "#include <Arduino.h>",
+        "#include <stdint.h>",
+        "",
+        "// Generated by tools/clip_encode.py from %s" % source,
+        "// %d frames, %d ms, %d bytes (%d raw)" % (
+            frames, total_ms, len(clip), frames * FRAME_BYTES),
+        "const uint8_t %s[] PROGMEM = {" % name,
+    ]
+    for i in range(0, len(clip), 16):
+        lines.append("    " + ", ".join("0x%02X" % b for b in clip[i:i + 16]) + ",")
+    lines += ["};", "", "#endif // %s" % guard]
+    text = "\n".join(lines) + "\n"
+    if path == "-":
+        sys.stdout.write(text)
+    else:
+        with open(path, "w") as f:
+            f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("frames", nargs="*", help="frame files, name:ms sets a duration")
+    parser.add_argument("--name", default="CLIP")
+    parser.add_argument("--out", default="-")
+    parser.add_argument("--bin", action="store_true")
+    parser.add_argument("--frame-ms", type=int, default=33)
+    parser.add_argument("--keyframe-interval", type=int, default=0,
+                        help="extra keyframes every n frames, the first frame always is one")
+    parser.add_argument("--test-pattern", type=int, metavar="FRAMES")
+    args = parser.parse_args()
+
+    if args.test_pattern:
+        frames = test_pattern(args.test_pattern)
+        durations = [args.frame_ms] * len(frames)
+        source = "--test-pattern %d --frame-ms %d" % (args.test_pattern, args.frame_ms)
+    else:
+        if not args.frames:
+            parser.error("no frames")
+        frames = []
+        durations = []
+        for spec in args.frames:
+            path, _, ms = spec.partition(":")
+            if ms and not ms.isdigit():
+                path, ms = spec, ""
+            frames.append(read_frame(path))
+            durations.append(int(ms) if ms else args.frame_ms)
+        source = "%d files" % len(frames)
+    if any(not 0 < ms < 65536 for ms in durations):
+        parser.error("durations must be 1 to 65535 ms")
+
+    clip = encode(frames, durations, args.keyframe_interval)
+    for index, (decoded, frame) in enumerate(zip(decode(clip), frames)):
+        if decoded != frame:
+            sys.exit("frame %d does not decode back" % index)
+
+    if args.bin:
+        with open(args.out, "wb") as f:
+            f.write(clip)
+    else:
+        write_header(args.out, args.name, clip, len(frames), sum(durations), source)
+    print("%d frames, %d bytes, %.1f%% of raw" % (
+        len(frames), len(clip), 100.0 * len(clip) / (len(frames) * FRAME_BYTES)),
+        file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""Decode the CipherPal screen mirror stream (see src/mirror.h).
+
+Reads a serial port or a raw capture, prints Log() lines as they arrive
+and writes every reconstructed frame as a PBM, optionally also an
+animated GIF (needs Pillow).
+
+    mirror_view.py --port /dev/ttyACM0 --out frames/
+    mirror_view.py --file capture.bin --gif session.gif
+"""
+
+import argparse
+import os
+import sys
+
+WIDTH = 128
+HEIGHT = 64
+FRAME_BYTES = WIDTH * HEIGHT // 8
+SYNC = b"\x00MIR"
+HEADER_BYTES = 9
+
+
+def reverse_bits(v):
+    v = ((v & 0xF0) >> 4) | ((v & 0x0F) << 4)
+    v = ((v & 0xCC) >> 2) | ((v & 0x33) << 2)
+    v = ((v & 0xAA) >> 1) | ((v & 0x55) << 1)
+    return v
+
+
+REVERSED = bytes(reverse_bits(i) for i in range(256))
+
+
+class MirrorDecoder:
+    """Incremental decoder, feed() returns ('log', text) and
+    ('frame', sequence, frame bytes) events."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.frame = bytearray(FRAME_BYTES)
+        self.sequence = None
+        self.synced = False
+        self.dropped = 0
+
+    def feed(self, data):
+        self.buffer += data
+        events = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                # Keep an unterminated line, it may be a partial sync
+                end = self.buffer.rfind(b"\n") + 1
+                self.text(self.buffer[:end], events)
+                del self.buffer[:end]
+                return events
+            if start > 0:
+                self.text(self.buffer[:start], events)
+                del self.buffer[:start]
+            if len(self.buffer) < HEADER_BYTES:
+                return events
+
+            kind = bytes(self.buffer[4:5])
+            sequence = self.buffer[5] | (self.buffer[6] << 8)
+            length = self.buffer[7] | (self.buffer[8] << 8)
+            total = HEADER_BYTES + length + 1
+            if kind not in (b"K", b"D") or length > FRAME_BYTES * 2:
+                del self.buffer[:len(SYNC)]
+                continue
+            if len(self.buffer) < total:
+                return events
+            payload = bytes(self.buffer[HEADER_BYTES:HEADER_BYTES + length])
+            checksum = self.buffer[total - 1]
+            del self.buffer[:total]
+            event = self.apply(kind, sequence, payload, checksum)
+            if event is not None:
+                events.append(event)
+
+    @staticmethod
+    def text(data, events):
+        for line in bytes(data).splitlines():
+            if line.strip():
+                events.append(("log", line.decode("ascii", "replace").rstrip()))
+
+    def apply(self, kind, sequence, payload, checksum):
+        if (sum(payload) & 0xFF) != checksum:
+            self.synced = False
+            self.dropped += 1
+            return None
+        if kind == b"K":
+            self.frame = bytearray(FRAME_BYTES)
+            self.synced = True
+        elif not self.synced or sequence != ((self.sequence + 1) & 0xFFFF):
+            # Missed a packet, wait for the next keyframe
+            self.synced = False
+            self.dropped += 1
+            return None
+        self.sequence = sequence
+
+        pos = 0
+        i = 0
+        while i < len(payload):
+            token = payload[i]
+            i += 1
+            if token & 0x80:
+                pos += (token & 0x7F) + 1
+                continue
+            count = token + 1
+            for value in payload[i:i + count]:
+                if pos < FRAME_BYTES:
+                    self.frame[pos] ^= value
+                pos += 1
+            i += count
+        return ("frame", sequence, bytes(self.frame))
+
+
+def to_pbm(frame):
+    # PBM rows are most significant bit leftmost, the frame is the reverse
+    return b"P4\n%d %d\n" % (WIDTH, HEIGHT) + frame.translate(REVERSED)
+
+
+def save_gif(path, frames):
+    try:
+        from PIL import Image
+    except ImportError:
+        print("Pillow is needed for --gif", file=sys.stderr)
+        return
+    images = [Image.frombytes("1", (WIDTH, HEIGHT), f.translate(REVERSED)) for f in frames]
+    if images:
+        images[0].save(path, save_all=True, append_images=images[1:], duration=33, loop=0)
+
+
+def open_source(args):
+    if args.file:
+        return open(args.file, "rb")
+    import serial
+    return serial.Serial(args.port, args.baud, timeout=0.1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial port of the device")
+    source.add_argument("--file", help="raw capture of the serial stream")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--out", help="directory for frame_NNNNN.pbm files")
+    parser.add_argument("--gif", help="write all frames to an animated GIF")
+    parser.add_argument("--frames", type=int, default=0, help="stop after this many frames")
+    args = parser.parse_args()
+
+    if args.out:
+        os.makedirs(args.out, exist_ok=True)
+    decoder = MirrorDecoder()
+    frames = []
+    count = 0
+    stream = open_source(args)
+    try:
+        while True:
+            data = stream.read(4096)
+            if not data:
+                if args.file:
+                    break
+                continue
+            for event in decoder.feed(data):
+                if event[0] == "log":
+                    print(event[1])
+                    continue
+                _, sequence, frame = event
+                count += 1
+                if args.out:
+                    with open(os.path.join(args.out, "frame_%05d.pbm" % count), "wb") as f:
+                        f.write(to_pbm(frame))
+                if args.gif:
+                    frames.append(frame)
+            if args.frames and count >= args.frames:
+                break
+    except KeyboardInterrupt:
+        pass
+    finally:
+        stream.close()
+
+    if args.gif:
+        save_gif(args.gif, frames)
+    print("%d frames, %d packets dropped" % (count, decoder.dropped), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
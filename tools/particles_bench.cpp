@@ -0,0 +1,111 @@
+// Host benchmark for src/particles.cpp: time per particle for the free and
+// homing steps with plotting, the particles that fit in a frame at the
+// default rate, and a check that a scattered frame settles back exactly.
+//
+//   g++ -O2 -std=gnu++11 -Izephyr/compat -I<Adafruit-GFX-Library> -Isrc
+//       tools/particles_bench.cpp src/particles.cpp -o particles_bench
+//   ./particles_bench
+//
+// Only the GFX headers are needed. The target numbers come from the bench
+// environment (pio run -e adafruit_feather_m0_bench), the pool itself is
+// capped at one fragment per frame byte (PARTICLE_MAX).
+
+#include "particles.h"
+
+#include "renderer.h"
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_STEPS 32
+#define BENCH_SECONDS 0.5
+#define SETTLE_STEPS 2000
+
+static uint32_t invalidated;
+
+void render_invalidate(int16_t x, int16_t w)
+{
+    (void)x;
+    (void)w;
+    ++invalidated;
+}
+
+// Every byte set, the largest pool, or a sparse text-like frame
+static void fill_frame(uint8_t* frame, bool full)
+{
+    for (uint16_t i = 0; i < FRAME_BYTES; ++i)
+    {
+        frame[i] = full ? 0xFF : (((i / BYTES_PER_LINE) % 10) < 7 ? (uint8_t)rand() & 0x7E : 0);
+    }
+}
+
+static bool check_settles(const uint8_t* original)
+{
+    static uint8_t frame[FRAME_BYTES] __attribute__((aligned(4)));
+    memcpy(frame, original, FRAME_BYTES);
+    particles_capture(frame);
+    particles_scatter(LCD_WIDTH / 2, LCD_HEIGHT / 2);
+    for (uint8_t i = 0; i < BENCH_STEPS; ++i)
+    {
+        particles_step_free();
+    }
+    for (uint16_t i = 0; i < SETTLE_STEPS; ++i)
+    {
+        if (particles_step_home())
+        {
+            particles_draw(frame);
+            return memcmp(frame, original, FRAME_BYTES) == 0;
+        }
+    }
+    return false;
+}
+
+static void bench(const char* name, bool full)
+{
+    static uint8_t original[FRAME_BYTES] __attribute__((aligned(4)));
+    static uint8_t frame[FRAME_BYTES] __attribute__((aligned(4)));
+    fill_frame(original, full);
+    bool settles = check_settles(original);
+
+    memcpy(frame, original, FRAME_BYTES);
+    uint16_t count = particles_capture(frame);
+    uint64_t steps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < BENCH_SECONDS)
+    {
+        particles_scatter(LCD_WIDTH / 2, LCD_HEIGHT / 2);
+        for (uint8_t i = 0; i < BENCH_STEPS; ++i)
+        {
+            particles_step_free();
+            particles_draw(frame);
+        }
+        for (uint8_t i = 0; i < BENCH_STEPS; ++i)
+        {
+            particles_step_home();
+            particles_draw(frame);
+        }
+        steps += 2 * BENCH_STEPS;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double ns_each = (elapsed * 1e9) / ((double)steps * count);
+    double frame_ns = 1e9 / DEFAULT_TARGET_FPS;
+    printf("%-6s %4u fragments %8.2f ns each %10.0f per frame (pool %u)  settles %s\n",
+           name,
+           count,
+           ns_each,
+           frame_ns / ns_each,
+           (unsigned)PARTICLE_MAX,
+           settles ? "ok" : "FAIL");
+}
+
+int main()
+{
+    bench("full", true);
+    bench("text", false);
+    return 0;
+}
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Flat profile from the CipherPal PC sampling profiler (see src/profiler.h).
+
+Runs the profiler through the command protocol, reads the histogram and
+maps the sampled 32 byte bins to functions with the firmware ELF:
+
+    pio run -e adafruit_feather_m0_profile -t upload
+    profile.py --elf .pio/build/adafruit_feather_m0_profile/firmware.elf \\
+        run --port /dev/ttyACM0 --seconds 10 --push self_test
+
+Functions are grouped by class or namespace with --by-class, which puts
+Adafruit_GFX, TwoWire and the render states side by side. Single
+addresses, e.g. from a stall report, are looked up with:
+
+    profile.py --elf firmware.elf symbolize 0x00004a2c 0x00001f10
+
+Symbols come from arm-none-eabi-nm (the PlatformIO toolchain has one,
+pass --nm when it is not on PATH).
+"""
+
+import argparse
+import bisect
+import struct
+import subprocess
+import sys
+import time
+
+import cipherpal_client as client
+
+PROFILE_START = 0x08
+PROFILE_STOP = 0x09
+PROFILE_READ = 0x0A
+SLOTS = 512
+BIN_SHIFT = 5
+
+
+class Symbols:
+    def __init__(self, elf, nm="arm-none-eabi-nm"):
+        output = subprocess.run(
+            [nm, "--numeric-sort", "--print-size", "--demangle", "--defined-only", elf],
+            check=True, capture_output=True, text=True).stdout
+        self.starts = []
+        self.entries = []
+        for line in output.splitlines():
+            fields = line.split(None, 3)
+            if len(fields) < 4 or fields[2] not in "TtWw":
+                continue
+            start = int(fields[0], 16) & ~1
+            size = int(fields[1], 16)
+            self.starts.append(start)
+            self.entries.append((start, size, fields[3]))
+
+    def lookup(self, address):
+        i = bisect.bisect_right(self.starts, address) - 1
+        if i >= 0:
+            start, size, name = self.entries[i]
+            if address < start + size:
+                return name, address - start
+        return "0x%08x" % address, 0
+
+    def overlapping(self, start, end):
+        """(name, bytes) of every function in [start, end)."""
+        i = max(bisect.bisect_right(self.starts, start) - 1, 0)
+        found = []
+        while i < len(self.entries) and self.entries[i][0] < end:
+            entry_start, size, name = self.entries[i]
+            overlap = min(end, entry_start + size) - max(start, entry_start)
+            if overlap > 0:
+                found.append((name, overlap))
+            i += 1
+        return found
+
+
+def class_of(name):
+    """Adafruit_GFX::drawChar(...) -> Adafruit_GFX, free functions keep
+    their own name."""
+    name = name.split("(")[0]
+    return name.rsplit("::", 1)[0] if "::" in name else name
+
+
+def read_histogram(pal):
+    bins = {}
+    first = 0
+    while first < SLOTS:
+        reply = pal.request(PROFILE_READ, struct.pack("<H", first))
+        count = reply[2]
+        if count == 0:
+            # Firmware with a smaller table, nothing more to read
+            break
+        for i in range(count):
+            flash_bin, samples = struct.unpack_from("<HH", reply, 3 + i * 4)
+            if samples:
+                bins[flash_bin] = bins.get(flash_bin, 0) + samples
+        first += count
+    return bins
+
+
+def flat_profile(bins, symbols, by_class):
+    """A bin's samples are shared between the functions in it by size."""
+    totals = {}
+    for flash_bin, samples in bins.items():
+        start = flash_bin << BIN_SHIFT
+        functions = symbols.overlapping(start, start + (1 << BIN_SHIFT))
+        if not functions:
+            functions = [(symbols.lookup(start)[0], 1)]
+        covered = sum(size for _, size in functions)
+        for name, size in functions:
+            key = class_of(name) if by_class else name
+            totals[key] = totals.get(key, 0) + samples * size / covered
+    return sorted(totals.items(), key=lambda item: item[1], reverse=True)
+
+
+def print_profile(profile, samples, top):
+    print("%8s %6s  %s" % ("samples", "%", "function"))
+    for name, count in profile[:top]:
+        print("%8.0f %5.1f%%  %s" % (count, 100.0 * count / max(samples, 1), name))
+
+
+def run(args, symbols):
+    with client.CipherPal(args.port, args.baud) as pal:
+        if args.push:
+            pal.push_state(args.push)
+        reply = pal.request(PROFILE_START, struct.pack("<H", args.hz))
+        (hz,) = struct.unpack("<H", reply)
+        print("sampling at %d Hz for %.1f s" % (hz, args.seconds), file=sys.stderr)
+        time.sleep(args.seconds)
+        samples, dropped, outside = struct.unpack("<3I", pal.request(PROFILE_STOP))
+        bins = read_histogram(pal)
+        if args.push:
+            pal.pop_state()
+
+    print("%d samples, %d dropped, %d outside flash" % (samples, dropped, outside))
+    if dropped:
+        print("warning: %d samples (%.1f%%) found the histogram full or their count "
+              "saturated and are missing, profile a shorter run"
+              % (dropped, 100.0 * dropped / max(samples, 1)), file=sys.stderr)
+    print_profile(flat_profile(bins, symbols, args.by_class), samples, args.top)
+
+
+def symbolize(args, symbols):
+    for text in args.addresses:
+        address = int(text, 0)
+        name, offset = symbols.lookup(address & ~1)
+        print("0x%08x  %s+0x%x" % (address, name, offset))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--elf", required=True)
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    run_parser = commands.add_parser("run")
+    run_parser.add_argument("--port", required=True)
+    run_parser.add_argument("--baud", type=int, default=115200)
+    run_parser.add_argument("--hz", type=int, default=1000)
+    run_parser.add_argument("--seconds", type=float, default=5.0)
+    run_parser.add_argument("--push", choices=client.STATES, help="profile this render state")
+    run_parser.add_argument("--by-class", action="store_true")
+    run_parser.add_argument("--top", type=int, default=30)
+
+    symbolize_parser = commands.add_parser("symbolize")
+    symbolize_parser.add_argument("addresses", nargs="+")
+
+    args = parser.parse_args()
+    symbols = Symbols(args.elf, args.nm)
+    if args.command == "run":
+        run(args, symbols)
+    else:
+        symbolize(args, symbols)
+
+
+if __name__ == "__main__":
+    main()
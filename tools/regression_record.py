@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Record or check CipherPal regression baselines (see src/regression.h).
+
+Reads the Log() output of a regression build, from a serial port or a
+saved log, writes the last frame of every golden state as a PBM and
+prints each state's counters:
+
+    pio run -e adafruit_feather_m0_regression -t upload
+    regression_record.py --port /dev/ttyACM0 --golden tools/golden
+
+With --check the frames are compared against the PBMs already in
+--golden instead, the differing pixels are counted and the exit status
+is 1 when a frame differs or the run failed. These are target frames,
+the host test keeps its own in test/golden/.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+from mirror_view import FRAME_BYTES, HEIGHT, REVERSED, WIDTH, to_pbm
+
+COST = re.compile(r"regression (.+?): (\d+) pixels, (\d+) rect pixels, (\d+) bytes flushed")
+RESULT = re.compile(r"regression (.+?): (PASS|FAIL) crc ([0-9a-f]{8}), (\d+) flushes, (\d+) us worst")
+FRAME = re.compile(r"regression (.+?): frame ([0-9a-f]{4}) ([0-9a-f]+)")
+DONE = re.compile(r"regression done, (\d+) of (\d+) failed")
+
+
+def file_name(name):
+    return name.lower().replace(" ", "_") + ".pbm"
+
+
+def read_lines(args):
+    if args.file:
+        with open(args.file, errors="replace") as f:
+            yield from f
+        return
+    import serial
+    with serial.Serial(args.port, args.baud, timeout=1) as port:
+        while True:
+            line = port.readline().decode(errors="replace")
+            if line:
+                yield line
+
+
+def read_run(args):
+    results = []
+    costs = {}
+    frames = {}
+    failed = None
+    for line in read_lines(args):
+        line = line.strip()
+        if args.echo:
+            print(line, file=sys.stderr)
+        match = FRAME.search(line)
+        if match:
+            name, offset, data = match.groups()
+            frame = frames.setdefault(name, bytearray(FRAME_BYTES))
+            chunk = bytes.fromhex(data)
+            frame[int(offset, 16):int(offset, 16) + len(chunk)] = chunk
+            continue
+        match = COST.search(line)
+        if match:
+            costs[match.group(1)] = match.groups()[1:]
+            continue
+        match = RESULT.search(line)
+        if match:
+            name, status, crc, flushes, worst_us = match.groups()
+            results.append((name, status, crc) + costs.get(name, ("0", "0", "0")) + (flushes, worst_us))
+            continue
+        match = DONE.search(line)
+        if match:
+            failed = int(match.group(1))
+            break
+    return results, frames, failed
+
+
+def read_pbm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    header = b"P4\n%d %d\n" % (WIDTH, HEIGHT)
+    if not data.startswith(header):
+        raise ValueError("%s is not a %dx%d PBM" % (path, WIDTH, HEIGHT))
+    return data[len(header):].translate(REVERSED)
+
+
+def pixels_differing(a, b):
+    return sum(bin(x ^ y).count("1") for x, y in zip(a, b))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial port of the device")
+    source.add_argument("--file", help="saved Log() output of a run")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--golden", default=os.path.join(os.path.dirname(__file__), "golden"))
+    parser.add_argument("--check", action="store_true", help="compare with the golden frames")
+    parser.add_argument("--echo", action="store_true", help="print the log as it is read")
+    args = parser.parse_args()
+
+    results, frames, failed = read_run(args)
+    if failed is None:
+        print("the log ended before the run did", file=sys.stderr)
+        return 1
+
+    if args.check:
+        differing = 0
+        for name, frame in frames.items():
+            path = os.path.join(args.golden, file_name(name))
+            if not os.path.exists(path):
+                print("%-14s no golden frame" % name)
+                differing += 1
+                continue
+            count = pixels_differing(frame, read_pbm(path))
+            print("%-14s %s" % (name, "ok" if count == 0 else "%d pixels differ" % count))
+            differing += count > 0
+        print("%d of %d cases failed on target" % (failed, len(results)))
+        return 1 if (differing or failed) else 0
+
+    os.makedirs(args.golden, exist_ok=True)
+    for name, frame in frames.items():
+        with open(os.path.join(args.golden, file_name(name)), "wb") as f:
+            f.write(to_pbm(bytes(frame)))
+    for name, status, crc, pixels, rect_pixels, flushed, flushes, worst_us in results:
+        print("%-14s %s crc %s, %s pixels, %s rect pixels, %s flushes, %s bytes, %s us worst"
+              % (name, status, crc, pixels, rect_pixels, flushes, flushed, worst_us))
+    print("%d golden frames written to %s" % (len(frames), args.golden), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,25 @@
+#ifndef ADAFRUIT_I2CDEVICE_COMPAT_H_
+#define ADAFRUIT_I2CDEVICE_COMPAT_H_
+
+#include "Wire.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Same interface as Adafruit BusIO, transfers go to the emulated SH1107
+class Adafruit_I2CDevice
+{
+public:
+    Adafruit_I2CDevice(uint8_t addr, TwoWire* theWire = &Wire) : address(addr) { (void)theWire; }
+    bool begin(bool addr_detect = true) { (void)addr_detect; return true; }
+    bool write(const uint8_t* buffer,
+               size_t len,
+               bool stop = true,
+               const uint8_t* prefix_buffer = NULL,
+               size_t prefix_len = 0);
+    bool setSpeed(uint32_t desiredclk);
+    size_t maxBufferSize() { return 250; }
+    uint8_t address;
+};
+
+#endif // ADAFRUIT_I2CDEVICE_COMPAT_H_
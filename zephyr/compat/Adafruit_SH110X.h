@@ -0,0 +1,42 @@
+#ifndef ADAFRUIT_SH110X_COMPAT_H_
+#define ADAFRUIT_SH110X_COMPAT_H_
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_I2CDevice.h>
+#include <Wire.h>
+
+#define MONOOLED_BLACK 0
+#define MONOOLED_WHITE 1
+#define MONOOLED_INVERSE 2
+#define SH110X_BLACK MONOOLED_BLACK
+#define SH110X_WHITE MONOOLED_WHITE
+#define SH110X_INVERSE MONOOLED_INVERSE
+
+// Stand-in for the Adafruit SH1107 driver with the members FrameDisplay
+// builds on. begin() attaches the emulated controller.
+class Adafruit_SH1107 : public Adafruit_GFX
+{
+public:
+    Adafruit_SH1107(uint16_t w,
+                    uint16_t h,
+                    TwoWire* twi = &Wire,
+                    int8_t rst_pin = -1,
+                    uint32_t preclk = 400000,
+                    uint32_t postclk = 100000);
+    virtual ~Adafruit_SH1107();
+
+    bool begin(uint8_t i2caddr = 0x3C, bool reset = true);
+    virtual void display() {}
+    void clearDisplay() {}
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override { (void)x; (void)y; (void)color; }
+
+protected:
+    // Adafruit_GrayOLED's frame buffer, set by FrameDisplay::begin()
+    uint8_t* buffer;
+    Adafruit_I2CDevice* i2c_dev;
+    uint32_t i2c_preclk;
+    uint32_t i2c_postclk;
+    uint8_t _page_start_offset;
+};
+
+#endif // ADAFRUIT_SH110X_COMPAT_H_
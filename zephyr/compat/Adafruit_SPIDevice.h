@@ -0,0 +1,6 @@
+#ifndef ADAFRUIT_SPIDEVICE_COMPAT_H_
+#define ADAFRUIT_SPIDEVICE_COMPAT_H_
+
+// Included by Adafruit_GFX.h for the SPI TFT classes, unused here
+
+#endif // ADAFRUIT_SPIDEVICE_COMPAT_H_
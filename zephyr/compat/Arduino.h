@@ -0,0 +1,61 @@
+#ifndef ARDUINO_COMPAT_H_
+#define ARDUINO_COMPAT_H_
+
+// The subset of the Arduino core CipherPal and Adafruit GFX use, on top of
+// the Zephyr kernel
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_pointer(addr) ((void*)*(void* const*)(addr))
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+template<class T> const T& min(const T& a, const T& b) { return (b < a) ? b : a; }
+template<class T> const T& max(const T& a, const T& b) { return (a < b) ? b : a; }
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+class String
+{
+public:
+    String(const char* text = "") : text(text) {}
+    const char* c_str() const { return text; }
+    unsigned int length() const { return strlen(text); }
+
+private:
+    const char* text;
+};
+
+#include "Print.h"
+#include "HardwareSerial.h"
+
+#endif // ARDUINO_COMPAT_H_
@@ -0,0 +1,25 @@
+#ifndef HARDWARE_SERIAL_COMPAT_H_
+#define HARDWARE_SERIAL_COMPAT_H_
+
+#include "Print.h"
+
+// Serial goes to the Zephyr console, input is polled from its UART
+class ConsoleSerial : public Print
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override;
+    // The polling API cannot count waiting bytes, this is 1 or 0
+    int available();
+    int read();
+    // Only what has arrived, never waits
+    size_t readBytes(uint8_t* buffer, size_t length);
+    operator bool() { return true; }
+};
+
+extern ConsoleSerial Serial;
+
+#endif // HARDWARE_SERIAL_COMPAT_H_
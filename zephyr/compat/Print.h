@@ -0,0 +1,30 @@
+#ifndef PRINT_COMPAT_H_
+#define PRINT_COMPAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+class __FlashStringHelper;
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text);
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char* text);
+    size_t print(const __FlashStringHelper* text);
+    size_t print(char c);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(int value) { return print((long)value); }
+    size_t print(unsigned int value) { return print((unsigned long)value); }
+    size_t println(const char* text);
+    size_t println();
+};
+
+#endif // PRINT_COMPAT_H_
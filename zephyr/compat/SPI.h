@@ -0,0 +1,4 @@
+#ifndef SPI_COMPAT_H_
+#define SPI_COMPAT_H_
+
+#endif // SPI_COMPAT_H_
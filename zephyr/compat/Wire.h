@@ -0,0 +1,16 @@
+#ifndef WIRE_COMPAT_H_
+#define WIRE_COMPAT_H_
+
+#include <stdint.h>
+
+// Only passed around, the display traffic goes to the emulated SH1107
+class TwoWire
+{
+public:
+    void begin() {}
+    void setClock(uint32_t clock) { (void)clock; }
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_COMPAT_H_
@@ -0,0 +1,222 @@
+#include "Arduino.h"
+
+#include <Adafruit_SH110X.h>
+#include <Wire.h>
+
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include <stdio.h>
+
+ConsoleSerial Serial;
+TwoWire Wire;
+
+static const struct device* const console_uart = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+// Byte polled by available() and not read yet, -1 when none
+static int console_lookahead = -1;
+
+uint32_t millis()
+{
+    return k_uptime_get_32();
+}
+
+uint32_t micros()
+{
+#ifdef CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+    return (uint32_t)k_cyc_to_us_floor64(k_cycle_get_64());
+#else
+    return k_cyc_to_us_floor32(k_cycle_get_32());
+#endif
+}
+
+void delay(uint32_t ms)
+{
+    k_msleep(ms);
+}
+
+void yield()
+{
+    k_yield();
+}
+
+// Buttons are read by the input thread, pins read as released
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+int digitalRead(uint8_t pin)
+{
+    (void)pin;
+    return HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    (void)pin;
+    (void)value;
+}
+
+long random(long howbig)
+{
+    return (howbig > 0) ? (rand() % howbig) : 0;
+}
+
+long random(long howsmall, long howbig)
+{
+    return (howsmall >= howbig) ? howsmall : (howsmall + random(howbig - howsmall));
+}
+
+void randomSeed(unsigned long seed)
+{
+    srand(seed);
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t n = 0;
+    while (n < size)
+    {
+        if (write(buffer[n]) == 0)
+        {
+            break;
+        }
+        ++n;
+    }
+    return n;
+}
+
+size_t Print::write(const char* text)
+{
+    return (text != NULL) ? write((const uint8_t*)text, strlen(text)) : 0;
+}
+
+size_t Print::print(const char* text)
+{
+    return write(text);
+}
+
+size_t Print::print(const __FlashStringHelper* text)
+{
+    return write((const char*)text);
+}
+
+size_t Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t Print::print(long value)
+{
+    char text[12];
+    snprintf(text, sizeof(text), "%ld", value);
+    return write(text);
+}
+
+size_t Print::print(unsigned long value)
+{
+    char text[12];
+    snprintf(text, sizeof(text), "%lu", value);
+    return write(text);
+}
+
+size_t Print::println(const char* text)
+{
+    return print(text) + println();
+}
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
+
+size_t ConsoleSerial::write(uint8_t c)
+{
+    printk("%c", c);
+    return 1;
+}
+
+size_t ConsoleSerial::write(const uint8_t* buffer, size_t size)
+{
+    // %.*s stops at a zero byte, binary data goes a byte at a time
+    if (memchr(buffer, 0, size) != NULL)
+    {
+        return Print::write(buffer, size);
+    }
+    printk("%.*s", (int)size, (const char*)buffer);
+    return size;
+}
+
+int ConsoleSerial::availableForWrite()
+{
+    return 256;
+}
+
+int ConsoleSerial::available()
+{
+    unsigned char c;
+    if ((console_lookahead < 0)
+        && device_is_ready(console_uart)
+        && (uart_poll_in(console_uart, &c) == 0))
+    {
+        console_lookahead = c;
+    }
+    return (console_lookahead >= 0) ? 1 : 0;
+}
+
+int ConsoleSerial::read()
+{
+    if (available() == 0)
+    {
+        return -1;
+    }
+    int c = console_lookahead;
+    console_lookahead = -1;
+    return c;
+}
+
+size_t ConsoleSerial::readBytes(uint8_t* buffer, size_t length)
+{
+    size_t n = 0;
+    while ((n < length) && (available() > 0))
+    {
+        buffer[n++] = (uint8_t)read();
+    }
+    return n;
+}
+
+Adafruit_SH1107::Adafruit_SH1107(uint16_t w,
+                                 uint16_t h,
+                                 TwoWire* twi,
+                                 int8_t rst_pin,
+                                 uint32_t preclk,
+                                 uint32_t postclk)
+    : Adafruit_GFX(w, h),
+      buffer(NULL),
+      i2c_dev(NULL),
+      i2c_preclk(preclk),
+      i2c_postclk(postclk),
+      _page_start_offset(0)
+{
+    (void)twi;
+    (void)rst_pin;
+}
+
+Adafruit_SH1107::~Adafruit_SH1107()
+{
+    delete i2c_dev;
+}
+
+bool Adafruit_SH1107::begin(uint8_t i2caddr, bool reset)
+{
+    (void)reset;
+    if (i2c_dev == NULL)
+    {
+        i2c_dev = new Adafruit_I2CDevice(i2caddr, &Wire);
+    }
+    return i2c_dev->begin();
+}
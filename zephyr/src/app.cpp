@@ -0,0 +1,268 @@
+// Zephyr entry point. Replaces Arduino setup()/loop() with an input thread
+// that debounces the buttons and a render thread that runs the render
+// stack, joined by a message queue. The render thread waits on the queue
+// between frames, so an input wakes it immediately, and it reports frame
+// rate, input to frame latency and display bus use every few seconds.
+
+#include "buttons.h"
+#include "renderer.h"
+#include "sh1107_emul.h"
+#include "utility.h"
+#include "render_states/main_menu.h"
+#include "render_states/splash_screen.h"
+
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/display.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#if DT_HAS_COMPAT_STATUS_OKAY(zephyr_gpio_emul)
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#define HAS_STIMULUS 1
+#endif
+
+#include <stdint.h>
+
+#define INPUT_STACK_SIZE 1024
+#define INPUT_PRIORITY 4
+#define INPUT_POLL_MS 2
+#define RENDER_STACK_SIZE 8192
+#define RENDER_PRIORITY 6
+#define RENDER_WAIT_US 1000
+#define STATS_PERIOD_MS 5000
+#define QUEUE_DEPTH 16
+
+typedef struct
+{
+    uint8_t buttons;
+    uint32_t time_us;
+} input_event_t;
+
+typedef struct
+{
+    uint32_t events;
+    uint32_t dropped;
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+    uint64_t latency_total_us;
+    uint32_t frames;
+    uint32_t window_start_ms;
+} app_stats_t;
+
+K_MSGQ_DEFINE(input_queue, sizeof(input_event_t), QUEUE_DEPTH, 4);
+
+static const struct gpio_dt_spec button_pins[] = {
+    GPIO_DT_SPEC_GET(DT_ALIAS(sw0), gpios),
+    GPIO_DT_SPEC_GET(DT_ALIAS(sw1), gpios),
+    GPIO_DT_SPEC_GET(DT_ALIAS(sw2), gpios),
+};
+
+static const uint8_t button_masks[] = {
+    BUTTON_UP_STATE_MASK,
+    BUTTON_SEL_STATE_MASK,
+    BUTTON_DOWN_STATE_MASK,
+};
+
+#define BUTTON_COUNT (sizeof(button_pins) / sizeof(button_pins[0]))
+
+static uint8_t current_buttons = BUTTON_ALL_MASK;
+static app_stats_t stats;
+
+static uint8_t queued_buttons()
+{
+    return current_buttons;
+}
+
+static uint8_t read_pins()
+{
+    uint8_t state = BUTTON_ALL_MASK;
+    for (uint8_t i = 0; i < BUTTON_COUNT; ++i)
+    {
+        // Active low pins read 1 while pressed, the masks are 0 then
+        if (gpio_pin_get_dt(&button_pins[i]) > 0)
+        {
+            state &= ~button_masks[i];
+        }
+    }
+    return state;
+}
+
+static void input_thread(void*, void*, void*)
+{
+    for (uint8_t i = 0; i < BUTTON_COUNT; ++i)
+    {
+        gpio_pin_configure_dt(&button_pins[i], GPIO_INPUT);
+    }
+
+    uint8_t state = BUTTON_ALL_MASK;
+    uint32_t last_change = 0;
+    while (true)
+    {
+        uint8_t scan = read_pins();
+        if ((scan != state) && ((millis() - last_change) > DEBOUNCE_MS))
+        {
+            last_change = millis();
+            state = scan;
+            input_event_t event = { state, micros() };
+            if (k_msgq_put(&input_queue, &event, K_NO_WAIT) != 0)
+            {
+                ++stats.dropped;
+            }
+        }
+        k_msleep(INPUT_POLL_MS);
+    }
+}
+
+static void report_stats()
+{
+    uint32_t now = millis();
+    uint32_t elapsed = now - stats.window_start_ms;
+    if (elapsed < STATS_PERIOD_MS)
+    {
+        return;
+    }
+
+    const sh1107_emul_stats_t* bus = sh1107_emul_stats();
+    uint32_t average = (stats.events > 0) ? (uint32_t)(stats.latency_total_us / stats.events) : 0;
+    printk("frames %u (%u fps), inputs %u (%u dropped), latency %u/%u/%u us, bus %u bytes in %u transactions %u us\n",
+           stats.frames,
+           (stats.frames * 1000) / elapsed,
+           stats.events,
+           stats.dropped,
+           (stats.events > 0) ? stats.latency_min_us : 0,
+           average,
+           stats.latency_max_us,
+           bus->bytes,
+           bus->transactions,
+           bus->bus_us);
+
+    memset(&stats, 0, sizeof(stats));
+    stats.latency_min_us = UINT32_MAX;
+    stats.window_start_ms = now;
+}
+
+// Whole frame flush at each clock with and without page batching, costed
+// by the emulated bus
+static void report_flush_model()
+{
+    static const uint32_t clocks[] = { I2C_STANDARD_HZ, I2C_FAST_HZ, I2C_FAST_PLUS_HZ };
+    const sh1107_emul_stats_t* bus = sh1107_emul_stats();
+    for (uint8_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); ++i)
+    {
+        uint32_t clock = display->set_bus_speed(clocks[i]);
+        for (uint8_t batch = 0; batch < 2; ++batch)
+        {
+            display->set_page_batching(batch != 0);
+            uint32_t transactions = bus->transactions;
+            uint32_t bus_us = bus->bus_us;
+            display->mark_all_dirty();
+            display->display();
+            printk("flush at %u Hz, %s: %u transactions, %u us\n",
+                   clock,
+                   batch ? "batched" : "unbatched",
+                   bus->transactions - transactions,
+                   bus->bus_us - bus_us);
+        }
+    }
+    display->set_bus_speed(DEFAULT_BUS_HZ);
+}
+
+static void render_thread(void*, void*, void*)
+{
+    const struct device* panel = DEVICE_DT_GET(DT_CHOSEN(zephyr_display));
+    if (device_is_ready(panel))
+    {
+        display_set_pixel_format(panel, PIXEL_FORMAT_ARGB_8888);
+        display_blanking_off(panel);
+    }
+    else
+    {
+        printk("display not ready, rendering headless\n");
+        panel = NULL;
+    }
+
+    render_init();
+    report_flush_model();
+    set_button_source(queued_buttons);
+    push_render_function(&main_menu_render);
+    push_render_function(&splash_screen_render);
+
+    stats.latency_min_us = UINT32_MAX;
+    stats.window_start_ms = millis();
+    // Inputs not yet seen by a rendered frame, oldest first
+    uint32_t waiting_since_us = 0;
+    bool waiting = false;
+
+    while (true)
+    {
+        input_event_t event;
+        if (k_msgq_get(&input_queue, &event, K_USEC(RENDER_WAIT_US)) == 0)
+        {
+            current_buttons = event.buttons;
+            if (!waiting)
+            {
+                waiting_since_us = event.time_us;
+                waiting = true;
+            }
+            ++stats.events;
+        }
+
+        uint32_t frame = render_frame_count();
+        render();
+        if (render_frame_count() != frame)
+        {
+            sh1107_emul_present(panel);
+            ++stats.frames;
+            if (waiting)
+            {
+                uint32_t latency = micros() - waiting_since_us;
+                stats.latency_min_us = min(stats.latency_min_us, latency);
+                stats.latency_max_us = max(stats.latency_max_us, latency);
+                stats.latency_total_us += latency;
+                waiting = false;
+            }
+        }
+        report_stats();
+    }
+}
+
+#ifdef HAS_STIMULUS
+#define STIMULUS_STACK_SIZE 512
+#define STIMULUS_PRIORITY 5
+#define STIMULUS_START_MS 10000
+#define STIMULUS_HOLD_MS 80
+#define STIMULUS_GAP_MS 420
+
+// Scripted presses on the emulated pins so latency can be measured on
+// native_sim without anyone at the keyboard. Walks the menu up and down.
+static void stimulus_thread(void*, void*, void*)
+{
+    static const uint8_t sequence[] = { 2, 2, 2, 0, 0, 0 };
+    k_msleep(STIMULUS_START_MS);
+    for (uint32_t i = 0;; ++i)
+    {
+        const struct gpio_dt_spec* pin = &button_pins[sequence[i % sizeof(sequence)]];
+        // Physical level, the pins are active low
+        gpio_emul_input_set(pin->port, pin->pin, 0);
+        k_msleep(STIMULUS_HOLD_MS);
+        gpio_emul_input_set(pin->port, pin->pin, 1);
+        k_msleep(STIMULUS_GAP_MS);
+    }
+}
+
+K_THREAD_DEFINE(stimulus_tid, STIMULUS_STACK_SIZE, stimulus_thread, NULL, NULL, NULL,
+                STIMULUS_PRIORITY, 0, 0);
+#endif
+
+K_THREAD_DEFINE(input_tid, INPUT_STACK_SIZE, input_thread, NULL, NULL, NULL,
+                INPUT_PRIORITY, 0, 0);
+K_THREAD_DEFINE(render_tid, RENDER_STACK_SIZE, render_thread, NULL, NULL, NULL,
+                RENDER_PRIORITY, 0, 0);
+
+int main()
+{
+    Log("CipherPal on Zephyr");
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include "sh1107_emul.h"
+
+#include <Adafruit_I2CDevice.h>
+
+#include <zephyr/drivers/display.h>
+#include <zephyr/kernel.h>
+
+#include <string.h>
+
+#define PANEL_WIDTH 128
+#define PANEL_HEIGHT 64
+#define RAM_PAGES 16
+#define RAM_COLUMNS 128
+// Control byte: D/C selects data, with Co set only one byte follows
+// before the next control byte
+#define CONTROL_DATA 0x40
+#define CONTROL_CONTINUATION 0x80
+#define BITS_PER_BYTE 9
+// Start and stop conditions, about a clock each
+#define FRAMING_BITS 2
+
+typedef struct
+{
+    uint8_t ram[RAM_PAGES][RAM_COLUMNS];
+    uint8_t page;
+    uint8_t column;
+    uint8_t start_line;
+    uint8_t contrast;
+    bool inverted;
+    bool panel_on;
+    // First byte of a two byte command, 0 when none is pending
+    uint8_t pending;
+    bool changed;
+    uint32_t speed_hz;
+    sh1107_emul_stats_t stats;
+} sh1107_emul_t;
+
+static sh1107_emul_t emul = {
+    {{0}}, 0, 0, 0, 0x80, false, true, 0, true, 100000, {0, 0, 0, 0, 0}
+};
+static uint32_t pixels[PANEL_WIDTH * PANEL_HEIGHT];
+
+static bool takes_argument(uint8_t command)
+{
+    switch (command)
+    {
+        case 0x81: // contrast
+        case 0xA8: // multiplex ratio
+        case 0xAD: // charge pump
+        case 0xD3: // display offset
+        case 0xD5: // clock divide
+        case 0xD9: // precharge
+        case 0xDB: // VCOM level
+        case 0xDC: // start line
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void command(uint8_t byte)
+{
+    if (emul.pending != 0)
+    {
+        if (emul.pending == 0x81)
+        {
+            emul.contrast = byte;
+        }
+        else if (emul.pending == 0xDC)
+        {
+            emul.start_line = byte & 0x7F;
+        }
+        emul.pending = 0;
+        emul.changed = true;
+        return;
+    }
+
+    if (takes_argument(byte))
+    {
+        emul.pending = byte;
+    }
+    else if ((byte & 0xF0) == 0xB0)
+    {
+        emul.page = byte & 0x0F;
+    }
+    else if ((byte & 0xF0) == 0x00)
+    {
+        emul.column = (emul.column & 0x70) | (byte & 0x0F);
+    }
+    else if ((byte & 0xF8) == 0x10)
+    {
+        emul.column = ((byte & 0x07) << 4) | (emul.column & 0x0F);
+    }
+    else if ((byte == 0xA6) || (byte == 0xA7))
+    {
+        emul.inverted = (byte == 0xA7);
+        emul.changed = true;
+    }
+    else if ((byte == 0xAE) || (byte == 0xAF))
+    {
+        emul.panel_on = (byte == 0xAF);
+        emul.changed = true;
+    }
+}
+
+bool sh1107_emul_write(const uint8_t* prefix, size_t prefix_len, const uint8_t* buffer, size_t len)
+{
+    size_t total = prefix_len + len;
+    if (total == 0)
+    {
+        return true;
+    }
+
+    // Address byte plus payload, 9 clocks each, start/stop, and the
+    // driver's set up and completion per transaction
+    uint32_t bits = ((total + 1) * BITS_PER_BYTE) + FRAMING_BITS;
+    uint32_t bus_us = ((bits * 1000000UL) / emul.speed_hz) + SH1107_EMUL_OVERHEAD_US;
+    ++emul.stats.transactions;
+    if (emul.speed_hz > SH1107_EMUL_MAX_HZ)
+    {
+        // The address byte goes unanswered
+        ++emul.stats.naks;
+        emul.stats.bus_us += SH1107_EMUL_OVERHEAD_US;
+        k_busy_wait(SH1107_EMUL_OVERHEAD_US);
+        return false;
+    }
+
+    bool expect_control = true;
+    uint8_t control = 0;
+    for (size_t i = 0; i < total; ++i)
+    {
+        uint8_t byte = (i < prefix_len) ? prefix[i] : buffer[i - prefix_len];
+        if (expect_control)
+        {
+            control = byte;
+            expect_control = false;
+            continue;
+        }
+        if (control & CONTROL_DATA)
+        {
+            emul.ram[emul.page][emul.column] = byte;
+            emul.column = (emul.column + 1) % RAM_COLUMNS;
+            emul.changed = true;
+        }
+        else
+        {
+            command(byte);
+        }
+        expect_control = (control & CONTROL_CONTINUATION) != 0;
+    }
+
+    emul.stats.bytes += total;
+    emul.stats.bus_us += bus_us;
+    k_busy_wait(bus_us);
+    return true;
+}
+
+void sh1107_emul_set_speed(uint32_t hz)
+{
+    emul.speed_hz = (hz > 0) ? hz : 100000;
+}
+
+bool sh1107_emul_present(const struct device* display)
+{
+    if (!emul.changed || (display == NULL))
+    {
+        return false;
+    }
+    emul.changed = false;
+
+    // Brighter contrast settings show as lighter gray
+    uint8_t level = 0x40 + ((emul.contrast * 0xBF) / 0xFF);
+    uint32_t on = 0xFF000000UL | (level << 16) | (level << 8) | level;
+    uint32_t off = 0xFF000000UL;
+    for (uint8_t y = 0; y < PANEL_HEIGHT; ++y)
+    {
+        // Controller column 0 is the bottom line of the rotated panel
+        uint8_t column = (PANEL_HEIGHT - 1) - y;
+        for (uint8_t x = 0; x < PANEL_WIDTH; ++x)
+        {
+            uint8_t line = (x + emul.start_line) % PANEL_WIDTH;
+            bool lit = (emul.ram[line >> 3][column] >> (line & 7)) & 1;
+            lit = emul.panel_on && (lit != emul.inverted);
+            pixels[(y * PANEL_WIDTH) + x] = lit ? on : off;
+        }
+    }
+
+    struct display_buffer_descriptor desc;
+    desc.buf_size = sizeof(pixels);
+    desc.width = PANEL_WIDTH;
+    desc.height = PANEL_HEIGHT;
+    desc.pitch = PANEL_WIDTH;
+    display_write(display, 0, 0, &desc, pixels);
+    ++emul.stats.presents;
+    return true;
+}
+
+const sh1107_emul_stats_t* sh1107_emul_stats()
+{
+    return &emul.stats;
+}
+
+bool Adafruit_I2CDevice::write(const uint8_t* buffer,
+                               size_t len,
+                               bool stop,
+                               const uint8_t* prefix_buffer,
+                               size_t prefix_len)
+{
+    (void)stop;
+    return sh1107_emul_write(prefix_buffer, prefix_len, buffer, len);
+}
+
+bool Adafruit_I2CDevice::setSpeed(uint32_t desiredclk)
+{
+    sh1107_emul_set_speed(desiredclk);
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef SH1107_EMUL_H_
+#define SH1107_EMUL_H_
+
+#include <zephyr/device.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+// SH1107 controller model behind the Adafruit_I2CDevice shim. It keeps the
+// controller RAM, page/column addressing, start line, contrast, invert
+// and panel on/off, and shows the result on a Zephyr display. Each
+// transfer is charged its I2C time (address, payload, start/stop
+// overhead) at the configured bus speed and the caller is held for that
+// long, so frame times and latencies on native_sim track the hardware.
+// Above SH1107_EMUL_MAX_HZ transfers are not acknowledged, like a module
+// that cannot keep up, so the driver's clock probe can be exercised.
+
+// Wire and SERCOM set up and completion per transaction on the SAMD21
+#define SH1107_EMUL_OVERHEAD_US 20
+#ifndef SH1107_EMUL_MAX_HZ
+#define SH1107_EMUL_MAX_HZ 1000000UL
+#endif
+
+typedef struct
+{
+    uint32_t transactions;
+    uint32_t naks;
+    uint32_t bytes;
+    uint32_t bus_us;
+    uint32_t presents;
+} sh1107_emul_stats_t;
+
+// Returns false when the transfer was not acknowledged
+bool sh1107_emul_write(const uint8_t* prefix, size_t prefix_len, const uint8_t* buffer, size_t len);
+void sh1107_emul_set_speed(uint32_t hz);
+
+// Copy the panel to the display if it changed, returns true if it did
+bool sh1107_emul_present(const struct device* display);
+
+const sh1107_emul_stats_t* sh1107_emul_stats();
+
+#endif // SH1107_EMUL_H_